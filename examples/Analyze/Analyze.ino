@@ -14,8 +14,9 @@
  *   limitations under the License.
  */
 /*
-  A SPI flash memory test/analyzer that generates example/sample code for function
-  `spi_flash_vendor_cases` using the results from the tests.
+  A SPI flash memory test/analyzer that generates example/sample code for a
+  vendor strategy list, `SPI_FLASH_VENDOR_STRATEGIES()`, using the results from
+  the tests.
 
   Determine if the SPI flash memory has support for disabling pin functions /WP
   write protect and /HOLD. Or confirm that those functions are not active.
@@ -90,30 +91,38 @@
 //
 #include <ModeDIO_ReclaimGPIOs.h>
 #include <SfdpRevInfo.h>
+#include <SrWearGuard.h>
+#include <SrNvCommit.h>
 #include <TestFlashQE/FlashChipId.h>
 #include <TestFlashQE/SFDP.h>
 #include <TestFlashQE/WP_HOLD_Test.h>
+#include <TestFlashQE/FlashDiscovery.h>
+#include <TestFlashQE/FlashReport.h>
+
+// Baud rate for the binary report blob, 0 keeps the current rate. The "@FR"
+// line before the blob is always sent at the current rate.
+#ifndef ANALYZE_REPORT_BAUD
+#define ANALYZE_REPORT_BAUD 0u
+#endif
+
+// Headless mode for a fixture with many boards on one line, see Provision.ino
+#ifndef ANALYZE_PROVISION
+#define ANALYZE_PROVISION 0
+#endif
+
+#if FLASH_SR_WEAR_GUARD
+// The tests here must see every Status Register write reach the flash.
+#error "Remove -DFLASH_SR_WEAR_GUARD from the Analyze build options"
+#endif
+#if FLASH_SR_NV_COMMIT
+#error "Remove -DFLASH_SR_NV_COMMIT from the Analyze build options"
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
-// FlashDiscovery - A list of discovered characteristics that may help guide
-// configuring the SPI flash memory to disable the pin functions /WP and /HOLD.
+// FlashDiscovery - see TestFlashQE/FlashDiscovery.h. A copy is kept in RTC
+// memory while the discovery steps run, see Discovery.ino.
 //
-struct FlashDiscovery {
-  uint32_t device = 0;
-  bool S9 = false;                // Proposed/discovered QE bit possition
-  bool S6 = false;                // " S6 or S9 or neither
-  bool WP = false;                // Pin function /WP exist
-  bool has_8bw_sr1 = false;       // When true, WEL write operation succeeded
-  bool has_8bw_sr2 = false;       // "
-  bool has_8bw_sr3 = false;       // "
-  bool has_16bw_sr1 = false;      // "
-  bool has_volatile = false;      // Volatile Status Register bit detected
-  bool write_QE = false;          // Writable QE bit candidate, S9 or S6 is set
-  bool pass_analyze = false;
-  bool pass_SC = false;           // Short Circuit tests on GPIO 9 and 10 passed
-  bool pass_WP = false;           // /WP disabled - Test results
-  bool pass_HOLD = false;         // /HOLD disabled - Test results
-} fd_state;
+experimental::FlashDiscovery fd_state;
 
 static uint32_t get_qe_pos() {
   if (fd_state.S9) return 9u;
@@ -160,46 +169,50 @@ void printReclaimFn() {
       "//\n"
       "#include <ModeDIO_ReclaimGPIOs.h>\n"
       "\n"
-      "extern \"C\" \n"
-      "bool spi_flash_vendor_cases(uint32_t device) {\n"
-      "  using namespace experimental;\n"
-      "  bool success = false;\n"
+      "using namespace experimental;\n"
       "\n"
-      "  if (0x%04X == (device & 0xFFFFu)) {\n"
-      "    // <Replace this line with vendor name and part number>\n", fd_state.device & 0xFFFFu);
+      "static bool custom_match(FlashMatchInfo *info) {\n"
+      "  // <Replace this line with vendor name and part number>\n");
     //
     if (sfdpInfo.u32[0]) {
       Serial.PRINTF(
-        "    // SFDP Revision: %u.%02u, 1ST Parameter Table Revision: %u.%02u\n"
-        "    // SFDP Table Ptr: 0x%02X, Size: %u DW\n",
+        "  // SFDP Revision: %u.%02u, 1ST Parameter Table Revision: %u.%02u\n"
+        "  // SFDP Table Ptr: 0x%02X, Size: %u DW\n",
         sfdpInfo.hdr_major,  sfdpInfo.hdr_minor, sfdpInfo.parm_major, sfdpInfo.parm_minor,
         sfdpInfo.tbl_ptr, sfdpInfo.sz_dw);
     } else {
-      Serial.PRINTF("    // SFDP none\n");
+      Serial.PRINTF("  // SFDP none\n");
     }
+    Serial.PRINTF(
+      "  return 0x%04Xu == flash_match_id16(info);\n"
+      "}\n"
+      "\n"
+      "static bool custom_apply(FlashMatchInfo *) {\n", fd_state.device & 0xFFFFu);
     if (fd_state.S9) {
       if (fd_state.has_16bw_sr1) {
-        Serial.PRINTF_LN("    success = set_S9_QE_bit__16_bit_sr1_write(%svolatile_bit);", (fd_state.has_volatile) ? "" : "non_");
+        Serial.PRINTF_LN("  return set_S9_QE_bit__16_bit_sr1_write(%svolatile_bit);", (fd_state.has_volatile) ? "" : "non_");
       } else
       if (fd_state.has_8bw_sr2) {
-        Serial.PRINTF_LN("    success = set_S9_QE_bit__8_bit_sr2_write(%svolatile_bit);", (fd_state.has_volatile) ? "" : "non_");
+        Serial.PRINTF_LN("  return set_S9_QE_bit__8_bit_sr2_write(%svolatile_bit);", (fd_state.has_volatile) ? "" : "non_");
+      } else {
+        Serial.PRINTF_LN("  return false;");
       }
     } else
     if (fd_state.S6) {
-      Serial.PRINTF_LN("    success = set_S6_QE_bit__8_bit_sr1_write(%svolatile_bit);", (fd_state.has_volatile) ? "" : "non_");
+      Serial.PRINTF_LN("  return set_S6_QE_bit__8_bit_sr1_write(%svolatile_bit);", (fd_state.has_volatile) ? "" : "non_");
     } else {
-      Serial.PRINTF_LN("    success = %s;",
+      Serial.PRINTF_LN("  return %s;",
         (fd_state.pass_SC && fd_state.pass_WP && fd_state.pass_HOLD) ? "true" : "false");
     }
     Serial.PRINTF(
-      "  }\n"
+      "}\n"
       "\n"
-      "  if (! success) {\n"
-      "    // then try builtin support\n"
-      "    success = __spi_flash_vendor_cases(device);\n"
-      "  }\n"
-      "  return success;\n"
-      "}\n");
+      "constexpr FlashStrategy custom_strategies[] PROGMEM = {\n"
+      "  {kFlashRankId16, custom_match, custom_apply},\n"
+      "  // then try builtin support\n"
+      "  flash_strategy_builtin()\n"
+      "};\n"
+      "SPI_FLASH_VENDOR_STRATEGIES(custom_strategies);\n");
 }
 
 void suggestedReclaimFn() {
@@ -236,47 +249,16 @@ void suggestedReclaimFn() {
 
 void runScript(int next_key) {
   /*
-    Run a series of test
-    a) Analyze - Find best guess selections S9, S6, 8-bit or 16-bit writes, etc.
-      * A failure is NOT expected to cause crash/reboot
-    w) Use proposed settings from analyze to test /WP
-      * A failure is NOT expected to cause crash/reboot
-    h) Use proposed settings from analyze to test /HOLD
-      * expect a failure to cause a crash or reboot.
-
-    Print the custom example
+    Start the analyze, /WP, /HOLD, print script. The steps run from loop(),
+    see Discovery.ino.
   */
-  scripting = true;
-  Serial.PRINTF_LN("\nRun Script at 1ST boot");
+  Serial.PRINTF_LN("\nRun Script");
   if ('a' == next_key || 'b' == next_key || 'A' == next_key || 'B' == next_key) {
-    if (processKey(next_key)) {
-      // At this point, we have a guess for QE bit either S9 or S6
-      // To be confident of the QE bit location S9 or S6 we need to fail and
-      // succeed with /WP tests, enable and disable write protect with QE.
-      if (processKey('w')) {
-        // Test /HOLD while QE=1 (or the final passing QE value from 'w' test) -
-        // this is a final confirmation that we have free-ed both GPIO9 and
-        // GPIO10 uses settings suggested by 'w'
-        if (processKey('h')) {
-          suggestedReclaimFn();
-        } else {
-          Serial.PRINTF_LN("\nUnable to disable pin function /HOLD using QE/S%X", (fd_state.S9) ? 9u : 6u);
-        }
-      } else {
-        Serial.PRINTF_LN("\nUnable to disable pin function /WP using QE/S%X", (fd_state.S9) ? 9u : 6u);
-        if (fd_state.S9) {
-          Serial.PRINTF_LN("  Suggest trying QE/S6. Use menu hotkeys 'b', 'w', 'h', 'p'");
-        }
-      }
-    } else {
-      Serial.PRINTF_LN("\nUnable to configure Flash Status Register to free GPIO9 and GPIO10");
-    }
-    last_key = '?'; // clear value to avoid confusion from a later unrelated crash.
+    discoveryStart(next_key);
   } else {
     Serial.PRINTF_LN("\nUnable to configure Flash Status Register to free GPIO9 and GPIO10");
     processKey('?');
   }
-  scripting = false;
 }
 
 extern "C" void patchEarlyCrashReason() {
@@ -303,6 +285,9 @@ void setup() {
   patchEarlyCrashReason();
 
   Serial.begin(115200);
+#if ANALYZE_PROVISION
+  provisionBegin();
+#endif
   delay(200);
   Serial.PRINTF_LN(
     "\r\n\r\n"
@@ -312,6 +297,10 @@ void setup() {
 
   Serial.PRINTF_LN("  Reset reason: %s", ESP.getResetReason().c_str());
   uint32_t reason = ESP.getResetInfoPtr()->reason;
+  if (discoveryResume(reason)) {
+    last_key = '?';
+    return;
+  }
   switch (reason) {
     case REASON_WDT_RST:          // 1
     case REASON_EXCEPTION_RST:    // 2
@@ -351,9 +340,21 @@ void setup() {
 void loop() {
   if (run_once) {
     run_once = false;
-#ifdef RUN_SCRIPT_AT_BOOT
+#if defined(RUN_SCRIPT_AT_BOOT) && ! ANALYZE_PROVISION
     runScript('a');   // Start Analyze
 #endif
   }
-  serialClientLoop();
+#if ANALYZE_PROVISION
+  // The fixture starts the script with "RUN"
+  provisionLoop();
+  if (discoveryActive()) {
+    discoveryStep();
+  }
+#else
+  if (discoveryActive()) {
+    discoveryStep();
+  } else {
+    serialClientLoop();
+  }
+#endif
 }
@@ -17,6 +17,18 @@
 //
 // -DRECLAIM_GPIO_EARLY=1
 
+// Send the binary "@FR" report, TestFlashQE/FlashReport.h, at the end of the
+// analyze script. Optionally at a faster baud rate.
+//
+// -DANALYZE_REPORT_AT_DONE=1
+// -DANALYZE_REPORT_BAUD=921600
+
+// Headless provisioning of many boards on one RS-485 or wired-OR UART line,
+// see Provision.ino. Optionally the GPIO for the RS-485 driver enable.
+//
+// -DANALYZE_PROVISION=1
+// -DANALYZE_PROVISION_DE_PIN=5
+
 */
 
 
@@ -39,4 +51,10 @@
 //
 // -DRECLAIM_GPIO_EARLY=1
 
+// Send the binary "@FR" report, TestFlashQE/FlashReport.h, at the end of the
+// analyze script. Optionally at a faster baud rate.
+//
+// -DANALYZE_REPORT_AT_DONE=1
+// -DANALYZE_REPORT_BAUD=921600
+
 */
@@ -0,0 +1,203 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Discovery - the analyze, /WP, /HOLD script as a resumable state machine.
+
+  `discoveryStep()` runs one stage per call from `loop()`. Before a stage
+  runs, `fd_state` is saved to RTC memory with the stage number. If the stage
+  crashes, `discoveryResume()` in `setup()` finds the stage that was running
+  and records the result. A crash in the /HOLD test is the expected failure.
+
+  Each stage change prints one line for a fixture host to parse:
+
+    @FD <stage> <result> <device> <word1> <word2> <word3>
+
+  All fields are hex. Words 1 - 3 are `FlashDiscovery::u32[1..3]`. Hotkey 'i'
+  prints the current line, 'x' starts a run and 'X' clears the RTC copy.
+
+  With `-DANALYZE_REPORT_AT_DONE=1`, the binary report from hotkey 'j' is
+  also sent when a run finishes.
+*/
+
+static bool discovery_active = false;
+
+// Resets allowed in one stage before giving up, for boards that boot loop
+constexpr uint32_t kDiscoveryMaxBoots = 2u;
+
+static uint32_t readSR321() {
+  using namespace experimental;
+  Spi0ReadOp ops[3] = {
+    {kReadStatusRegister1Cmd, 8u},
+    {kReadStatusRegister2Cmd, 8u},
+    {kReadStatusRegister3Cmd, 8u}
+  };
+  uint32_t result[3] = {0u, 0u, 0u};
+  if (SPI_RESULT_OK != spi0_flash_read_batch(ops, result, 3u)) return 0u;
+  return ((result[2] & 0xFFu) << 16u) | ((result[1] & 0xFFu) << 8u) | (result[0] & 0xFFu);
+}
+
+void printDiscoveryRecord() {
+  Serial.PRINTF_LN("@FD %X %X %06X %08X %08X %08X", fd_state.stage, fd_state.result,
+    fd_state.device & 0xFFFFFFu, fd_state.u32[1], fd_state.u32[2], fd_state.u32[3]);
+}
+
+static void saveDiscovery(const uint32_t stage) {
+  // kDiscoveryMaxBoots counts per stage. A resume reruns the same stage, or
+  // backs up from /HOLD to /WP, and keeps the count.
+  if (stage > fd_state.stage) fd_state.boots = 0u;
+  fd_state.stage = stage;
+  fd_state.sr321 = readSR321();
+  experimental::flash_discovery_save(&fd_state);
+  printDiscoveryRecord();
+}
+
+static void finishDiscovery(const uint32_t result) {
+  using namespace experimental;
+  fd_state.result = result;
+  saveDiscovery(kFdStageDone);
+#if ANALYZE_REPORT_AT_DONE
+  sendFlashReport(Serial, &fd_state, ANALYZE_REPORT_BAUD);
+#endif
+  discovery_active = false;
+  scripting = false;
+  last_key = '?'; // clear value to avoid confusion from a later unrelated crash.
+}
+
+void discoveryStart(const int key) {
+  using namespace experimental;
+  const uint32_t device = fd_state.device;
+  memset(&fd_state.u32[0], 0, sizeof(fd_state));
+  fd_state.device = device;
+  fd_state.key = key;
+  fd_state.result = kFdResultNone;
+  discovery_active = true;
+  scripting = true;
+  saveDiscovery(kFdStageAnalyze);
+}
+
+bool discoveryActive() {
+  return discovery_active;
+}
+
+/*
+  Run one stage and advance
+  a) Analyze - Find best guess selections S9, S6, 8-bit or 16-bit writes, etc.
+    * A failure is NOT expected to cause crash/reboot
+  w) Use proposed settings from analyze to test /WP
+    * A failure is NOT expected to cause crash/reboot
+  h) Use proposed settings from analyze to test /HOLD
+    * expect a failure to cause a crash or reboot.
+  p) Print the custom example
+*/
+void discoveryStep() {
+  using namespace experimental;
+  if (! discovery_active) return;
+
+  scripting = true;
+  switch (fd_state.stage) {
+    case kFdStageAnalyze:
+      if (processKey(fd_state.key)) {
+        // At this point, we have a guess for QE bit either S9 or S6
+        // To be confident of the QE bit location S9 or S6 we need to fail and
+        // succeed with /WP tests, enable and disable write protect with QE.
+        saveDiscovery(kFdStageCheckWP);
+      } else {
+        Serial.PRINTF_LN("\nUnable to configure Flash Status Register to free GPIO9 and GPIO10");
+        finishDiscovery(kFdResultFailAnalyze);
+      }
+      break;
+
+    case kFdStageCheckWP:
+      if (processKey('w')) {
+        // Test /HOLD while QE=1 (or the final passing QE value from 'w' test) -
+        // this is a final confirmation that we have free-ed both GPIO9 and
+        // GPIO10 uses settings suggested by 'w'
+        saveDiscovery(kFdStageTestHold);
+      } else {
+        Serial.PRINTF_LN("\nUnable to disable pin function /WP using QE/S%X", (fd_state.S9) ? 9u : 6u);
+        if (fd_state.S9) {
+          Serial.PRINTF_LN("  Suggest trying QE/S6. Use menu hotkeys 'b', 'w', 'h', 'p'");
+        }
+        finishDiscovery(kFdResultFailWP);
+      }
+      break;
+
+    case kFdStageTestHold:
+      if (processKey('h')) {
+        saveDiscovery(kFdStageSuggest);
+      } else {
+        Serial.PRINTF_LN("\nUnable to disable pin function /HOLD using QE/S%X", (fd_state.S9) ? 9u : 6u);
+        finishDiscovery(kFdResultFailHold);
+      }
+      break;
+
+    case kFdStageSuggest:
+      suggestedReclaimFn();
+      finishDiscovery(kFdResultPass);
+      break;
+
+    default:
+      discovery_active = false;
+      break;
+  }
+  scripting = discovery_active;
+}
+
+/*
+  Called from setup(). Returns true when a discovery run was found in RTC
+  memory and handled.
+*/
+bool discoveryResume(const uint32_t reason) {
+  using namespace experimental;
+  FlashDiscovery saved;
+  if (! flash_discovery_load(&saved)) return false;
+  if (kFdStageIdle == saved.stage || kFdStageDone <= saved.stage) return false;
+
+  const uint32_t device = fd_state.device;
+  fd_state = saved;
+  fd_state.device = device;
+
+  switch (reason) {
+    case REASON_WDT_RST:          // 1
+    case REASON_EXCEPTION_RST:    // 2
+    case REASON_SOFT_WDT_RST:     // 3
+      if (kFdStageTestHold == fd_state.stage) {
+        Serial.PRINTF_LN("unwanted but anticipated crash while testing `/HOLD`");
+        Serial.PRINTF_LN("\nUnable to disable pin function /HOLD using QE/S%X", (fd_state.S9) ? 9u : 6u);
+        finishDiscovery(kFdResultFailHold);
+      } else {
+        Serial.PRINTF_LN("unexpected crash in discovery stage %u", fd_state.stage);
+        Serial.PRINTF_LN("\nUnable to configure Flash Status Register to free GPIO9 and GPIO10");
+        finishDiscovery(kFdResultCrash);
+      }
+      break;
+
+    default:
+      // Reset without a crash, like a fixture pulsing EN. Rerun the stage. The
+      // /HOLD test needs the Status Register left by /WP, so go back to it.
+      if (kDiscoveryMaxBoots <= fd_state.boots) {
+        finishDiscovery(kFdResultGaveUp);
+        break;
+      }
+      fd_state.boots++;
+      discovery_active = true;
+      scripting = true;
+      Serial.PRINTF_LN("Resume discovery at stage %u", fd_state.stage);
+      saveDiscovery((kFdStageTestHold == fd_state.stage) ? kFdStageCheckWP : fd_state.stage);
+      break;
+  }
+  return true;
+}
@@ -59,30 +59,32 @@ void printSR321(const char *indent, const bool always) {
 
   Serial.PRINTF("%sSR321 0x", indent);
 
-  uint32_t sr3 = 0u;
-  SpiOpResult ok0 = SPI_RESULT_ERR;
-  if (always || fd_state.has_8bw_sr3) {
-    ok0 = spi0_flash_read_status_register_3(&sr3);
-  }
-  if (SPI_RESULT_OK == ok0) {
+  // Read all the Status Registers we need with one SPI0 batch
+  const bool has_sr3 = always || fd_state.has_8bw_sr3;
+  const bool has_sr2 = always || fd_state.has_8bw_sr2 || fd_state.has_16bw_sr1;
+  Spi0ReadOp ops[3];
+  uint32_t result[3] = {0u, 0u, 0u};
+  size_t n = 0u;
+  ops[n++] = {kReadStatusRegister1Cmd, 8u};
+  if (has_sr2) ops[n++] = {kReadStatusRegister2Cmd, 8u};
+  if (has_sr3) ops[n++] = {kReadStatusRegister3Cmd, 8u};
+  SpiOpResult ok0 = spi0_flash_read_batch(ops, result, n);
+
+  uint32_t sr1 = result[0];
+  uint32_t sr2 = (has_sr2) ? result[1] : 0u;
+  uint32_t sr3 = (has_sr3) ? result[n - 1u] : 0u;
+  if (SPI_RESULT_OK == ok0 && has_sr3) {
     Serial.PRINTF("%02X:", sr3);
   } else {
     Serial.PRINTF("--:");
   }
 
-  uint32_t sr2 = 0u;
-  ok0 = SPI_RESULT_ERR;
-  if (always || fd_state.has_8bw_sr2 || fd_state.has_16bw_sr1) {
-    ok0 = spi0_flash_read_status_register_2(&sr2);
-  }
-  if (SPI_RESULT_OK == ok0) {
+  if (SPI_RESULT_OK == ok0 && has_sr2) {
     Serial.PRINTF("%02X:", sr2);
   } else {
     Serial.PRINTF("--:");
   }
 
-  uint32_t sr1 = 0u;
-  ok0 = spi0_flash_read_status_register_1(&sr1);
   if (SPI_RESULT_OK == ok0) {
     Serial.PRINTF_LN("%02X", sr1);
   } else {
@@ -798,7 +800,7 @@ bool processKey(const int key) {
           Serial.PRINTF_LN("\nMissing prerequisite test, run /WP test, menu 'w'");
       }
       if (!scripting && pass) {
-        Serial.PRINTF_LN("\nUse menu 'p' to print 'spi_flash_vendor_cases()' example function.");
+        Serial.PRINTF_LN("\nUse menu 'p' to print an example vendor strategy list.");
       }
       fd_state.pass_HOLD = pass;
       break;
@@ -860,6 +862,25 @@ bool processKey(const int key) {
       printSfdpReport();
       break;
 
+    case 'i':
+      Serial.PRINTF_LN();
+      printDiscoveryRecord();
+      break;
+
+    case 'j':
+      Serial.PRINTF_LN();
+      sendFlashReport(Serial, &fd_state, ANALYZE_REPORT_BAUD);
+      break;
+
+    case 'x':
+      runScript('a');
+      break;
+
+    case 'X':
+      experimental::flash_discovery_invalidate();
+      Serial.PRINTF_LN("\nDiscovery record cleared");
+      break;
+
     // Evaluate S9 as
     //   hotkey 'Q' or 'E' => QE=1
     //   hotkey 'q' or 'e' => QE=0
@@ -954,7 +975,11 @@ bool processKey(const int key) {
       pinMode(10u, OUTPUT);
       digitalWrite(10u, HIGH);
       Serial.PRINTF_LN("\nStart SPI Flash Software Reset (66h, 99h):");
-      spi0_flash_software_reset(25000u);
+      {
+        uint32_t elapsed_us = 0u;
+        SpiOpResult ok0 = spi0_flash_software_reset_wait(&elapsed_us);
+        Serial.PRINTF_LN("  Reset %s after %u us", (SPI_RESULT_OK == ok0) ? "ready" : "timed out", elapsed_us);
+      }
       printSR321("  ", true);
       break;
 
@@ -1003,12 +1028,16 @@ bool processKey(const int key) {
       Serial.PRINTF_LN("  A - Same as 'a' except less safe uses non-volatile Status Registers");
       Serial.PRINTF_LN("  B - Same as 'b' except less safe uses non-volatile Status Registers");
       Serial.PRINTF_LN("  f - Print SFDP Data");
+      Serial.PRINTF_LN("  x - Same as 'r'");
+      Serial.PRINTF_LN("  i - Print discovery record line '@FD ...'");
+      Serial.PRINTF_LN("  X - Clear discovery record in RTC memory");
+      Serial.PRINTF_LN("  j - Send binary report '@FR ...', see TestFlashQE/FlashReport.h");
       Serial.PRINTF_LN();
       Serial.PRINTF_LN("Isolated test sets:");
       Serial.PRINTF_LN("  s - GPIO pins 9 and 10 short circuit test, included in Analyze");
       Serial.PRINTF_LN("  w - Test /WP   digitalWrite(10, LOW) and write to Flash");
       Serial.PRINTF_LN("  h - Test /HOLD digitalWrite( 9, LOW)");
-      Serial.PRINTF_LN("  p - Print 'spi_flash_vendor_cases()' example function");
+      Serial.PRINTF_LN("  p - Print an example vendor strategy list");
       Serial.PRINTF_LN("  t - Test builtin/custom 'spi_flash_vendor_cases()'");
       Serial.PRINTF_LN();
       Serial.PRINTF_LN("Manual set/clear discovery flags:");
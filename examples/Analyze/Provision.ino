@@ -0,0 +1,206 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Provision - headless Analyze for a fixture with many boards on one line
+
+  Build with `-DANALYZE_PROVISION=1`. The hotkey menu is off and the boards
+  stay quiet. They only answer addressed lines on a shared RS-485 or wired-OR
+  UART line at 115200 bps:
+
+    @PV <addr> <cmd> [arg]
+
+  <addr> is the board's `ESP.getChipId()` in hex, 6 digits, or `*` for all
+  boards. Commands:
+
+    RUN [key]   Start the analyze, /WP, /HOLD script, key 'a' (default) or 'b'.
+                A board with a finished record ignores it until CLR.
+    LIST [seed] Every board answers with its record in a slot picked from its
+                chip ID and seed, 20 ms apart. Repeat with another seed to get
+                past two boards that picked the same slot.
+    GET         The record of one board.
+    RPT         The binary "@FR" report of one board, see FlashReport.h.
+    CLR         Clear the record in RTC memory.
+
+  Only addressed commands are acknowledged. A record line is:
+
+    @PV <addr> FD <stage> <result> <device> <word1> <word2> <word3>*<xx>
+
+  The fields are the same as the "@FD" line, see Discovery.ino. <xx> is the
+  XOR of the characters between '@' and '*', for spotting collisions.
+
+  The record is kept in RTC memory through the expected /HOLD crash reboots,
+  so a fixture can RUN all boards at once and LIST them in one sweep when
+  done. Lines that do not start with "@PV", like the BootROM's boot messages,
+  are ignored.
+
+  The UART TX pin is tri-stated except while a board answers. For RS-485, set
+  `-DANALYZE_PROVISION_DE_PIN=<gpio>` for the transceiver's driver enable.
+  Test output sent in between goes nowhere.
+*/
+
+#if ANALYZE_PROVISION
+
+#ifndef ANALYZE_PROVISION_DE_PIN
+#define ANALYZE_PROVISION_DE_PIN -1
+#endif
+
+constexpr uint8_t kProvisionTxPin = 1u;
+constexpr size_t kProvisionLineMax = 48u;
+constexpr uint32_t kProvisionSlots = 64u;
+constexpr uint32_t kProvisionSlotMs = 20u;
+
+static char provision_line[kProvisionLineMax];
+static size_t provision_len = 0u;
+static bool provision_drop = false;
+static uint32_t provision_id = 0u;
+static bool provision_list_pending = false;
+static uint32_t provision_list_start = 0u;
+static uint32_t provision_list_delay = 0u;
+
+static void provisionTx(const bool on) {
+  // Let test output drain while the pin is off the line
+  Serial.flush();
+  if (on) {
+    pinMode(kProvisionTxPin, SPECIAL);
+    if (0 <= ANALYZE_PROVISION_DE_PIN) digitalWrite(ANALYZE_PROVISION_DE_PIN, HIGH);
+  } else {
+    if (0 <= ANALYZE_PROVISION_DE_PIN) digitalWrite(ANALYZE_PROVISION_DE_PIN, LOW);
+    pinMode(kProvisionTxPin, INPUT);
+  }
+}
+
+static void provisionReply(const char *fmt, ...) {
+  char buf[80];
+  int n = snprintf_P(buf, sizeof(buf), PSTR("@PV %06X "), provision_id);
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf_P(&buf[n], sizeof(buf) - n, fmt, ap);
+  va_end(ap);
+  uint8_t sum = 0u;
+  for (const char *p = &buf[1]; *p; p++) sum ^= (uint8_t)*p;
+
+  provisionTx(true);
+  Serial.PRINTF("%s*%02X\r\n", buf, sum);
+  provisionTx(false);
+}
+
+// The RTC copy outlives a reboot after a finished run
+static void provisionRecord(experimental::FlashDiscovery *rec) {
+  if (! experimental::flash_discovery_load(rec)) {
+    *rec = fd_state;
+  }
+  rec->device = fd_state.device;
+}
+
+static void provisionReplyRecord() {
+  experimental::FlashDiscovery rec;
+  provisionRecord(&rec);
+  provisionReply(PSTR("FD %X %X %06X %08X %08X %08X"), rec.stage, rec.result,
+    rec.device & 0xFFFFFFu, rec.u32[1], rec.u32[2], rec.u32[3]);
+}
+
+static uint32_t provisionSlot(const uint32_t seed) {
+  // Any mix that moves the slot when the seed changes
+  uint32_t h = (provision_id ^ seed) * 0x9E3779B1u;
+  return (h >> 16u) % kProvisionSlots;
+}
+
+static void provisionRun(const int key, const bool addressed) {
+  using namespace experimental;
+  FlashDiscovery rec;
+  provisionRecord(&rec);
+  const bool busy = discoveryActive() || kFdStageDone == rec.stage;
+  if (! busy) {
+    discoveryStart(('b' == key) ? 'b' : 'a');
+  }
+  if (addressed) provisionReply(PSTR("RUN %s"), (busy) ? "BUSY" : "OK");
+}
+
+static void provisionCommand(char *line) {
+  char *save = nullptr;
+  const char *tag = strtok_r(line, " \r", &save);
+  const char *addr = strtok_r(nullptr, " \r", &save);
+  const char *cmd = strtok_r(nullptr, " \r", &save);
+  const char *arg = strtok_r(nullptr, " \r", &save);
+  if (nullptr == tag || nullptr == addr || nullptr == cmd) return;
+  if (0 != strcmp_P(tag, PSTR("@PV"))) return;
+
+  const bool all = (0 == strcmp_P(addr, PSTR("*")));
+  if (! all && provision_id != strtoul(addr, nullptr, 16)) return;
+  const bool addressed = ! all;
+
+  if (0 == strcmp_P(cmd, PSTR("RUN"))) {
+    provisionRun((arg) ? arg[0] : 'a', addressed);
+  } else
+  if (0 == strcmp_P(cmd, PSTR("LIST"))) {
+    provision_list_delay = provisionSlot((arg) ? strtoul(arg, nullptr, 16) : 0u) * kProvisionSlotMs;
+    provision_list_start = millis();
+    provision_list_pending = true;
+  } else
+  if (0 == strcmp_P(cmd, PSTR("GET")) && addressed) {
+    provisionReplyRecord();
+  } else
+  if (0 == strcmp_P(cmd, PSTR("RPT")) && addressed) {
+    provisionTx(true);
+    sendFlashReport(Serial, &fd_state, ANALYZE_REPORT_BAUD);
+    provisionTx(false);
+  } else
+  if (0 == strcmp_P(cmd, PSTR("CLR"))) {
+    if (! discoveryActive()) {
+      experimental::flash_discovery_invalidate();
+      const uint32_t device = fd_state.device;
+      memset(&fd_state.u32[0], 0, sizeof(fd_state));
+      fd_state.device = device;
+    }
+    if (addressed) provisionReply(PSTR("CLR %s"), (discoveryActive()) ? "BUSY" : "OK");
+  }
+}
+
+// Called from setup() right after Serial.begin()
+void provisionBegin() {
+  provision_id = ESP.getChipId() & 0xFFFFFFu;
+  if (0 <= ANALYZE_PROVISION_DE_PIN) {
+    digitalWrite(ANALYZE_PROVISION_DE_PIN, LOW);
+    pinMode(ANALYZE_PROVISION_DE_PIN, OUTPUT);
+  }
+  provisionTx(false);
+}
+
+// Called from loop() in place of serialClientLoop()
+void provisionLoop() {
+  while (0 < Serial.available()) {
+    const int c = Serial.read();
+    if ('\n' == c) {
+      if (! provision_drop) {
+        provision_line[provision_len] = '\0';
+        provisionCommand(provision_line);
+      }
+      provision_len = 0u;
+      provision_drop = false;
+    } else if (provision_len < kProvisionLineMax - 1u) {
+      provision_line[provision_len++] = (char)c;
+    } else {
+      // Overlong, not a command. Drop up to the next line.
+      provision_drop = true;
+    }
+  }
+  if (provision_list_pending && provision_list_delay <= millis() - provision_list_start) {
+    provision_list_pending = false;
+    provisionReplyRecord();
+  }
+}
+
+#endif // ANALYZE_PROVISION
@@ -0,0 +1,118 @@
+/*
+  Measure the cost of the SPI0 flash primitives in CCOUNT cycles.
+
+  Each primitive runs with the iCache off, and most with interrupts masked, so
+  the time shown is also how long WiFi and other ISRs are held off. The table
+  is printed at 80 MHz and again at 160 MHz CPU clock.
+
+  The flash clock comes from the build, "Tools->Flash Frequency". Rebuild with
+  a different setting to compare.
+
+  Nothing here writes to the non-volatile Status Register. The volatile write
+  rewrites the current SR1 value with 50h/01h.
+
+  This example code is in the public domain.
+*/
+#include <Arduino.h>
+#include <user_interface.h>
+#include <SpiFlashUtils.h>
+#include <TestFlashQE/Spi0Bench.h>
+
+using namespace experimental;
+
+constexpr size_t kSamples = 64u;
+uint32_t samples[kSamples];
+
+struct ReadArg {
+  uint32_t buf[16];
+  size_t sz;
+};
+
+static SpiOpResult benchEmpty(void *) {
+  return SPI_RESULT_OK;
+}
+
+static SpiOpResult benchReadSR1(void *) {
+  uint32_t status;
+  return spi0_flash_read_status_register_1(&status);
+}
+
+static SpiOpResult benchReadBatchSR321(void *) {
+  const Spi0ReadOp ops[3] = {
+    {kReadStatusRegister1Cmd, 8u},
+    {kReadStatusRegister2Cmd, 8u},
+    {kReadStatusRegister3Cmd, 8u}
+  };
+  uint32_t result[3];
+  return spi0_flash_read_batch(ops, result, 3u);
+}
+
+static SpiOpResult benchVolatileWriteSR1(void *arg) {
+  return spi0_flash_write_status_register_1(*(uint32_t *)arg, volatile_bit);
+}
+
+static SpiOpResult benchCommandPair(void *) {
+  spi0_flash_command_pair(kWriteEnableCmd, kWriteDisableCmd);
+  return SPI_RESULT_OK;
+}
+
+static SpiOpResult benchReadSfdp(void *arg) {
+  ReadArg *r = (ReadArg *)arg;
+  return spi0_flash_read_sfdp(0u, r->buf, r->sz);
+}
+
+static SpiOpResult benchReadUniqueId(void *arg) {
+  ReadArg *r = (ReadArg *)arg;
+  return spi0_flash_read_unique_id(0u, r->buf, r->sz);
+}
+
+static void benchRow(const char *name, BenchFn fn, void *arg, const uint32_t mhz) {
+  BenchStats stats;
+  spi0_bench_run(fn, arg, samples, kSamples, &stats);
+  spi0_bench_print_row(name, &stats, mhz);
+}
+
+void runTable() {
+  const uint32_t mhz = system_get_cpu_freq();
+  Serial.printf_P(PSTR("\r\nCPU %u MHz, Flash %u MHz, %u samples each\r\n"),
+    mhz, ESP.getFlashChipSpeed() / 1000000u, kSamples);
+  spi0_bench_print_header();
+
+  benchRow("empty call", benchEmpty, nullptr, mhz);
+  benchRow("read SR1", benchReadSR1, nullptr, mhz);
+  benchRow("read batch SR1-3", benchReadBatchSR321, nullptr, mhz);
+
+  uint32_t sr1 = 0u;
+  if (SPI_RESULT_OK == spi0_flash_read_status_register_1(&sr1)) {
+    benchRow("volatile write SR1", benchVolatileWriteSR1, &sr1, mhz);
+  }
+  benchRow("command pair 06h 04h", benchCommandPair, nullptr, mhz);
+
+  ReadArg r;
+  static const size_t sizes[] = {8u, 16u, 32u, 64u};
+  char name[24];
+  for (size_t sz : sizes) {
+    r.sz = sz;
+    snprintf_P(name, sizeof(name), PSTR("SFDP read %u bytes"), sz);
+    benchRow(name, benchReadSfdp, &r, mhz);
+  }
+  r.sz = 8u;
+  benchRow("unique ID 64-bit", benchReadUniqueId, &r, mhz);
+  r.sz = 16u;
+  benchRow("unique ID 128-bit", benchReadUniqueId, &r, mhz);
+}
+
+void setup() {
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.printf_P(PSTR("\r\n\r\nSPI0 flash primitive benchmark\r\n"));
+
+  system_update_cpu_freq(SYS_CPU_80MHZ);
+  runTable();
+  system_update_cpu_freq(SYS_CPU_160MHZ);
+  runTable();
+  system_update_cpu_freq(SYS_CPU_80MHZ);
+}
+
+void loop() {
+}
@@ -30,9 +30,11 @@ void blinky() {
   uint32_t current = millis();
   if (kWinkInterval < (current - last_wink)) {
     last_wink = current;
-    uint8_t on9 = digitalRead(9u);
-    digitalWrite(10u, on9);
-    digitalWrite(9u, (on9) ? LOW : HIGH);
+    // GPIO10 follows GPIO9, then GPIO9 flips. Both change with one register
+    // write.
+    using namespace experimental;
+    uint32_t on9 = ReclaimedPins::read() & kGpio9Mask;
+    ReclaimedPins::write(kReclaimedPinsMask, (on9) ? kGpio10Mask : kGpio9Mask);
   }
 }
 
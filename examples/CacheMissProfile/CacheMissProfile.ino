@@ -0,0 +1,64 @@
+/*
+  Measure the iCache miss cost at the build's flash mode and clock.
+
+  After moving from "QIO" to "DIO" to use GPIO9 and GPIO10, each cache line
+  fill takes longer. This prints the line fill cost, a 2 KB block of code run
+  cold and warm from flash and from IRAM, then profiles a few functions. Add
+  your own hot functions to the table with profileRow(). A function marked
+  IRAM_ATTR costs more than twice as much on a cold call as on a warm one.
+
+  Compare builds made with "Tools->Flash Mode" set to QIO and DIO, or with the
+  FlashClockProbe example recommendation.
+
+  This example code is in the public domain.
+*/
+#include <Arduino.h>
+#include <user_interface.h>
+#include <TestFlashQE/CacheMissProfile.h>
+
+CacheMissCost cost;
+char text[64];
+
+static void sampleSnprintf(void *) {
+  snprintf_P(text, sizeof(text), PSTR("%u %08X %s"), 12345u, 0xDEADBEEFu, "text");
+}
+
+static void sampleChecksum(void *) {
+  uint32_t sum = 0u;
+  for (size_t i = 0u; i < sizeof(text); i++) sum = (sum << 1u) ^ text[i];
+  text[0] = sum;
+}
+
+static void sampleStringConcat(void *) {
+  String s(F("millis "));
+  s += millis();
+  strncpy(text, s.c_str(), sizeof(text) - 1u);
+}
+
+static void profileRow(const char *name, CacheProfileFn fn, const uint32_t mhz) {
+  CacheFnProfile profile;
+  cache_profile_fn(fn, nullptr, &cost, &profile);
+  cache_profile_print_row(name, &profile, mhz);
+}
+
+void setup() {
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.printf_P(PSTR("\r\n\r\niCache miss cost profile\r\n"));
+
+  if (! cache_miss_measure(&cost)) {
+    Serial.printf_P(PSTR("  Unable to measure the cache line size\r\n"));
+    return;
+  }
+  cache_miss_print(&cost);
+
+  const uint32_t mhz = system_get_cpu_freq();
+  Serial.printf_P(PSTR("\r\nCPU %u MHz\r\n"), mhz);
+  cache_profile_print_header();
+  profileRow("snprintf_P", sampleSnprintf, mhz);
+  profileRow("checksum loop", sampleChecksum, mhz);
+  profileRow("String concat", sampleStringConcat, mhz);
+}
+
+void loop() {
+}
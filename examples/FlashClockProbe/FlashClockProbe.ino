@@ -0,0 +1,36 @@
+/*
+  Find the fastest flash clock and dual read mode that reads back correctly.
+
+  With GPIO9 and GPIO10 reclaimed, the build is limited to "DIO" or "DOUT".
+  Each flash clock and read mode the part lists in SFDP is tried while copying
+  4 KB of the sketch's own code through the iCache. A setting passes when all
+  copies have the same CRC-32 as the build's own setting. The copy time is all
+  cache misses, so the fewest cycles is the lowest cache miss cost.
+
+  The settings are put back after each copy; nothing is changed when done.
+  Apply the recommendation with "Tools->Flash Mode" and "Tools->Flash
+  Frequency", then run again to confirm.
+
+  This example code is in the public domain.
+*/
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <TestFlashQE/FlashClockProbe.h>
+
+constexpr uint32_t kPasses = 8u;
+constexpr size_t kMaxResults = 16u;
+FlashProbeResult results[kMaxResults];
+
+void setup() {
+  // The WiFi NMI is not masked during a copy
+  WiFi.mode(WIFI_OFF);
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.printf_P(PSTR("\r\n\r\nFlash clock and read mode probe, %u passes each\r\n"), kPasses);
+
+  const size_t n = flash_clock_probe(results, kMaxResults, nullptr, 0u, kPasses);
+  flash_clock_probe_print(results, n, kPasses);
+}
+
+void loop() {
+}
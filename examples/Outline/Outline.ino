@@ -35,6 +35,9 @@ void setup() {
     */
   }
 #endif
+#if RECLAIM_GPIO_TIMING
+  experimental::reclaim_timing_print();
+#endif
 }
 
 void loop() {
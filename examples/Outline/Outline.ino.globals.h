@@ -13,4 +13,10 @@
 //
 // -DRECLAIM_GPIO_EARLY=1
 
+// Record CCOUNT stamps for each phase of reclaim_GPIO_9_10() and the number of
+// SPI0 flash transactions. Printed from setup(). Leave DEBUG_FLASH_QE off for
+// meaningful numbers, the debug printing is counted in the phase times.
+//
+// -DRECLAIM_GPIO_TIMING=1
+
 */
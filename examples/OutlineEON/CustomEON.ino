@@ -11,39 +11,41 @@
 #include <ModeDIO_ReclaimGPIOs.h>
 #include <SfdpRevInfo.h>
 
-extern "C"
-bool spi_flash_vendor_cases(uint32_t device) {
-  using namespace experimental;
-  bool success = false;
+using namespace experimental;
 
+static bool en25q32c_match(FlashMatchInfo *info) {
+  if (0x301Cu != flash_match_id16(info)) return false;
+
+  // Status: tested, sealed in ESP-12F module
+  // EON EN25Q32C, identification based on datasheet and data matchup
+  // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
+  // SFDP Table Ptr: 0x30, Size: 9 DW
   SfdpRevInfo sfdpInfo;
-  uint32_t* sfdp_dw = get_sfdp_basic(&sfdpInfo);  // uses malloc, must free
-
-  if (0x301C == (device & 0xFFFFu) && sfdp_dw) {
-    // Status: tested, sealed in ESP-12F module
-    // EON EN25Q32C, identification based on datasheet and data matchup
-    // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
-    // SFDP Table Ptr: 0x30, Size: 9 DW
-    if (1u == sfdpInfo.parm_major &&
-      0u == sfdpInfo.parm_minor &&
-      0xE5u == (sfdp_dw[0] & 0xFFu)) {
-      // These will match EN25Q32C pin 4 NC (DQ3) no /HOLD function and no
-      // volatile bits. EON SPI Flash parts have a WPDis S6 bit in status
-      // register-1 for disabling /WP (and /HOLD). This is similar to QE/S9 on
-      // other vendor parts. No support for volatile SR1.
-      success = set_S6_QE_bit__8_bit_sr1_write(non_volatile_bit);
-    }
-    // 0x331Cu - EN25Q32, Not supported - no S6 bit
-    // 0x701Cu - EN25QH128A might work
-    // EN25Q32A, EN25Q32B - Not supported - no hardware to confirm operation
-    // datasheets do not show SFDP support; however, RTOS_SDK sample code
-    // implies they do.
-  }
-  if (sfdp_dw) free(sfdp_dw);
-
-  if (! success) {
-    // then try builtin support
-    success = __spi_flash_vendor_cases(device);
-  }
-  return success;
+  uint32_t sfdp_dw[kSfdpBasicMaxDw];
+  size_t sz_dw = get_sfdp_basic_table(&sfdpInfo, sfdp_dw, kSfdpBasicMaxDw);
+  return sz_dw &&
+    1u == sfdpInfo.parm_major &&
+    0u == sfdpInfo.parm_minor &&
+    0xE5u == (sfdp_dw[0] & 0xFFu);
+
+  // 0x331Cu - EN25Q32, Not supported - no S6 bit
+  // 0x701Cu - EN25QH128A might work
+  // EN25Q32A, EN25Q32B - Not supported - no hardware to confirm operation
+  // datasheets do not show SFDP support; however, RTOS_SDK sample code
+  // implies they do.
 }
+
+static bool en25q32c_apply(FlashMatchInfo *) {
+  // These will match EN25Q32C pin 4 NC (DQ3) no /HOLD function and no
+  // volatile bits. EON SPI Flash parts have a WPDis S6 bit in status
+  // register-1 for disabling /WP (and /HOLD). This is similar to QE/S9 on
+  // other vendor parts. No support for volatile SR1.
+  return set_S6_QE_bit__8_bit_sr1_write(non_volatile_bit);
+}
+
+constexpr FlashStrategy eon_strategies[] PROGMEM = {
+  {kFlashRankSfdp, en25q32c_match, en25q32c_apply},
+  // then try builtin support
+  flash_strategy_builtin()
+};
+SPI_FLASH_VENDOR_STRATEGIES(eon_strategies);
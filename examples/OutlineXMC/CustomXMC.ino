@@ -50,77 +50,74 @@ uint32_t get_flash_mhz() {
   return 0;
 }
 
-extern "C"
-bool spi_flash_vendor_cases(uint32_t device) {
-  using namespace experimental;
-  bool success = false;
-  SfdpRevInfo sfdpInfo = get_sfdp_revision();
+using namespace experimental;
 
-  if (0x4020 == (device & 0xFFFFu)) {  // XMC
-    // Datasheet: Rev M issue date 2018/07/17
-    // XMC XM25QH32B
-    // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
-    // SFDP Table Ptr: 0x30, Size: 9 DW
-    //
-    // Datasheet: Rev 2.1 issue date 2023/12/15
-    // XMC XM25QH32C
-    // SFDP Revision: 1.06, 1ST Parameter Table Revision: 1.06
-    // SFDP Table Ptr: 0x30, Size: 9 DW
-    //
-    // Special handling for XMC XM25QH32B anomaly where driver strength value is
-    // lost when switching from non-volatile to volatile requires backup/restore
-    // of Status Register-3.
-    uint32_t status3 = 0;
-    SpiOpResult ok0 = spi0_flash_read_status_register_3(&status3);
-    success = set_S9_QE_bit__16_bit_sr1_write(volatile_bit);
-    /*
-      Consider this example a hypothetical. While the data came from the
-      vendor's datasheets, without real hardware to inspect, we cannot be sure,
-      the data I used was not a typo.
-    */
-    if (SPI_RESULT_OK == ok0) {
-      // Copy Driver Strength value from non-volatile to volatile
-      uint32_t newSR3 = status3;;
-      if (get_flash_mhz() > 26) { // >26Mhz?
-        // Set the output drive to 100%
-        if (1u == sfdpInfo.parm_major && 0u == sfdpInfo.parm_minor && 9u == sfdpInfo.sz_dw && 1u == sfdpInfo.num_parm_hdrs) {
-          // Datasheet: Rev M issue date 2018/07/17
-          // XMC XM25QH32B
-          newSR3 &= ~(SPI_FLASH_SR3_XMC_DRV_MASK << SPI_FLASH_SR3_XMC_DRV_S);
-          newSR3 |= (SPI_FLASH_SR3_XMC_DRV_100 << SPI_FLASH_SR3_XMC_DRV_S);
-        } else
-        if (1u == sfdpInfo.parm_major && 6u == sfdpInfo.parm_minor && 9u == sfdpInfo.sz_dw && 1u == sfdpInfo.num_parm_hdrs) {
-          // Datasheet: Rev 2.1 issue date 2023/12/15
-          // XMC XM25QH32C
-          newSR3 &= ~(SPI_FLASH_SR3_XMC_DRV_MASK << SPI_FLASH_SR3_XMC_DRV_S);
-          newSR3 |= (SPI_FLASH_SR3_XM25QH32C_DRV_100 << SPI_FLASH_SR3_XMC_DRV_S);
-        } else
-        if (1u == sfdpInfo.parm_major && 0u == sfdpInfo.parm_minor && 10u == sfdpInfo.sz_dw && 2u == sfdpInfo.num_parm_hdrs) {
-          // Datasheet: Rev.R Issue Date: 2019/08/23
-          // XMC XM25QH64C
-          newSR3 &= ~(SPI_FLASH_SR3_XMC_DRV_MASK << SPI_FLASH_SR3_XMC_DRV_S);
-          newSR3 |= (SPI_FLASH_SR3_XM25QH32C_DRV_100 << SPI_FLASH_SR3_XMC_DRV_S);
-        }
-        // For all others, no change
-      }
-      ok0 = spi0_flash_write_status_register_3(newSR3, volatile_bit);
-      DBG_SFU_PRINTF("  XMC Anomaly: Copy Driver Strength values to volatile status register.\n");
-      if (SPI_RESULT_OK != ok0) {
-        DBG_SFU_PRINTF("* anomaly handling failed.\n");
+static bool xmc_match(FlashMatchInfo *info) {
+  // Datasheet: Rev M issue date 2018/07/17
+  // XMC XM25QH32B
+  // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
+  // SFDP Table Ptr: 0x30, Size: 9 DW
+  //
+  // Datasheet: Rev 2.1 issue date 2023/12/15
+  // XMC XM25QH32C
+  // SFDP Revision: 1.06, 1ST Parameter Table Revision: 1.06
+  // SFDP Table Ptr: 0x30, Size: 9 DW
+  return 0x4020u == flash_match_id16(info);
+}
+
+static bool xmc_apply(FlashMatchInfo *info) {
+  // Special handling for XMC XM25QH32B anomaly where driver strength value is
+  // lost when switching from non-volatile to volatile requires backup/restore
+  // of Status Register-3.
+  uint32_t status3 = 0;
+  SpiOpResult ok0 = spi0_flash_read_status_register_3(&status3);
+  bool success = set_S9_QE_bit__16_bit_sr1_write(volatile_bit);
+  /*
+    Consider this example a hypothetical. While the data came from the
+    vendor's datasheets, without real hardware to inspect, we cannot be sure,
+    the data I used was not a typo.
+  */
+  if (SPI_RESULT_OK == ok0) {
+    // Copy Driver Strength value from non-volatile to volatile
+    uint32_t newSR3 = status3;
+    if (get_flash_mhz() > 26) { // >26Mhz?
+      // Set the output drive to 100%
+      const SfdpRevInfo& sfdpInfo = flash_match_sfdp(info);
+      if (1u == sfdpInfo.parm_major && 0u == sfdpInfo.parm_minor && 9u == sfdpInfo.sz_dw && 1u == sfdpInfo.num_parm_hdrs) {
+        // Datasheet: Rev M issue date 2018/07/17
+        // XMC XM25QH32B
+        newSR3 &= ~(SPI_FLASH_SR3_XMC_DRV_MASK << SPI_FLASH_SR3_XMC_DRV_S);
+        newSR3 |= (SPI_FLASH_SR3_XMC_DRV_100 << SPI_FLASH_SR3_XMC_DRV_S);
+      } else
+      if (1u == sfdpInfo.parm_major && 6u == sfdpInfo.parm_minor && 9u == sfdpInfo.sz_dw && 1u == sfdpInfo.num_parm_hdrs) {
+        // Datasheet: Rev 2.1 issue date 2023/12/15
+        // XMC XM25QH32C
+        newSR3 &= ~(SPI_FLASH_SR3_XMC_DRV_MASK << SPI_FLASH_SR3_XMC_DRV_S);
+        newSR3 |= (SPI_FLASH_SR3_XM25QH32C_DRV_100 << SPI_FLASH_SR3_XMC_DRV_S);
+      } else
+      if (1u == sfdpInfo.parm_major && 0u == sfdpInfo.parm_minor && 10u == sfdpInfo.sz_dw && 2u == sfdpInfo.num_parm_hdrs) {
+        // Datasheet: Rev.R Issue Date: 2019/08/23
+        // XMC XM25QH64C
+        newSR3 &= ~(SPI_FLASH_SR3_XMC_DRV_MASK << SPI_FLASH_SR3_XMC_DRV_S);
+        newSR3 |= (SPI_FLASH_SR3_XM25QH32C_DRV_100 << SPI_FLASH_SR3_XMC_DRV_S);
       }
+      // For all others, no change
+    }
+    ok0 = spi0_flash_write_status_register_3(newSR3, volatile_bit);
+    DBG_SFU_PRINTF("  XMC Anomaly: Copy Driver Strength values to volatile status register.\n");
+    if (SPI_RESULT_OK != ok0) {
+      DBG_SFU_PRINTF("* anomaly handling failed.\n");
     }
   }
-
-#if 1
-  // If you do not need the additional boards supported in
-  // __spi_flash_vendor_cases(device); this block can be omitted. When not
-  // referenced, the function __spi_flash_vendor_cases is omitted by the linker
-  // from the build.
-
-  if (! success) {
-    // Check builtin support
-    success = __spi_flash_vendor_cases(device);
-  }
-#endif
   return success;
 }
+
+constexpr FlashStrategy xmc_strategies[] PROGMEM = {
+  // Ahead of the builtin XMC record, which only copies SR3 back
+  {kFlashRankId16, xmc_match, xmc_apply},
+  // If you do not need the additional boards supported by the builtin table,
+  // this line can be omitted. When not referenced, the table is omitted by the
+  // linker from the build.
+  flash_strategy_builtin()
+};
+SPI_FLASH_VENDOR_STRATEGIES(xmc_strategies);
@@ -0,0 +1,40 @@
+/*
+  Stress test GPIO9 and GPIO10 under full flash traffic.
+
+  After reclaim_GPIO_9_10(), both pins are driven by the sigma-delta generator
+  at MHz rates while 64 KB of flash is streamed with spi_flash_read() and
+  through the iCache. Every 4 KB block is checked against a CRC-32 taken with
+  the pins idle. Reports the error rate and throughput of each path.
+
+  A flash part that still honors /HOLD or /WP shows up as CRC errors, or as a
+  crash or HWDT reset during the run.
+
+  Disconnect anything on GPIO9 and GPIO10 first, or use series resistors.
+
+  This example code is in the public domain.
+*/
+#include <ModeDIO_ReclaimGPIOs.h>
+#include <TestFlashQE/PinStress.h>
+
+constexpr uint32_t kDurationMs = 10000u;
+constexpr uint8_t kPrescale = 1u;
+PinStressResult result;
+
+void setup() {
+  Serial.begin(115200u);
+  delay(200u);
+  Serial.printf_P(PSTR("\r\n\r\nGPIO9 and GPIO10 stress test under flash traffic\r\n"));
+
+  if (! reclaim_GPIO_9_10()) {
+    Serial.printf_P(PSTR("* reclaim_GPIO_9_10() failed, nothing to test\r\n"));
+    return;
+  }
+  if (! pin_stress_run(&result, experimental::kReclaimedPinsMask, kDurationMs, 0u, kPrescale)) {
+    Serial.printf_P(PSTR("* Stress test did not run, the idle reference reads did not agree\r\n"));
+    return;
+  }
+  pin_stress_print(&result);
+}
+
+void loop() {
+}
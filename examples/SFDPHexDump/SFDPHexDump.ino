@@ -17,6 +17,11 @@ The "SFDP" may be useful for differentiating between some parts.
     https://www.jedec.org/standards-documents/docs/jesd216b
     Free Download - requires registration
 
+  Build with `-DSFDP_HEXDUMP_REPORT=1` to also send the dump as a binary
+  "@FR" report blob for a host tool. The layout is the same as
+  `TestFlashQE/FlashReport.h` in the SpiFlashUtils library, with only the
+  Flash ID and SFDP records.
+
   This example code is in the public domain.
 */
 #include <Arduino.h>
@@ -32,11 +37,10 @@ inline void spi_set_addr(uint8_t *buf, const uint32_t addr) {
   buf[2] = addr & 0xFFu;
 }
 
-static SpiOpResult spi0_flash_read_sfdp(uint32_t offset, uint32_t *pData, size_t sz) {
-  if (sz > 64u || (sz % sizeof(uint32_t)) || 0u == sz) {
-    return SPI_RESULT_ERR;
-  }
+// SPI0Command returns at most 64 bytes per call.
+constexpr size_t kReadChunkSize = 64u;
 
+static SpiOpResult spi0_flash_read_sfdp_chunk(uint32_t offset, uint32_t *pData, size_t sz) {
   // 24 bit address reads with one dummpy byte.
   struct FlashAddr24 {
     union {
@@ -56,33 +60,37 @@ static SpiOpResult spi0_flash_read_sfdp(uint32_t offset, uint32_t *pData, size_t
   return SPI0Command(kReadSFDP, pData, 32u, sz * 8u);
 }
 
+// Any length, read in full 64-byte chunks
+static SpiOpResult spi0_flash_read_sfdp(uint32_t offset, uint32_t *pData, size_t sz) {
+  if ((sz % sizeof(uint32_t)) || 0u == sz) {
+    return SPI_RESULT_ERR;
+  }
+
+  for (size_t done = 0u; done < sz; done += kReadChunkSize) {
+    size_t chunk = std::min(sz - done, kReadChunkSize);
+    SpiOpResult ok0 = spi0_flash_read_sfdp_chunk(offset + done, &pData[done / sizeof(uint32_t)], chunk);
+    if (SPI_RESULT_OK != ok0) return ok0;
+  }
+  return SPI_RESULT_OK;
+}
+
 constexpr uint32_t kSfdpSignature = 0x50444653u; //'SFDP'
 //
 // Returns true   if 'SFDP' signature was found.
-// Returns false  when no signature is found.
-//
-// If an error occurs while reading SFDP data, after reading a good signature,
-// true is still returned.
+// Returns false  when no signature is found or the read failed.
 //
 bool dumpSfdp() {
   Serial.printf("Raw dump of SFDP");
-  uint32_t param[4];
-  SpiOpResult ok0 = spi0_flash_read_sfdp(0, param, sizeof(param));
-
-  if (SPI_RESULT_OK == ok0 && kSfdpSignature == param[0]) {
-    for (size_t j = 0u; ; ) {
-      Serial.printf("\n  0x%02X  ", 0x10u * j);
-      for (size_t i = 0u; i < 4u; i++) {
-        Serial.printf(" 0x%08X", param[i]);
-      }
-      j++;
-      if (16 <= j) break;
-
-      if (SPI_RESULT_OK != spi0_flash_read_sfdp((j * 16u), param, sizeof(param))) {
-        Serial.printf("\n  error reading SFDP.");
-        break;
-      }
+  uint32_t sfdp[64];  // 256 bytes, 4 reads
+  SpiOpResult ok0 = spi0_flash_read_sfdp(0, sfdp, sizeof(sfdp));
+
+  if (SPI_RESULT_OK == ok0 && kSfdpSignature == sfdp[0]) {
+    for (size_t i = 0u; i < 64u; i++) {
+      if (0u == (i % 4u)) Serial.printf("\n  0x%02X  ", i * 4u);
+      Serial.printf(" 0x%08X", sfdp[i]);
     }
+  } else if (SPI_RESULT_OK != ok0) {
+    Serial.printf("\n  error reading SFDP.");
   } else {
     Serial.printf("\n  SFDP not supported.");
     ok0 = SPI_RESULT_ERR;
@@ -92,11 +100,52 @@ bool dumpSfdp() {
   return (SPI_RESULT_OK == ok0);
 }
 
+#if SFDP_HEXDUMP_REPORT
+// CRC-32 (IEEE 802.3), bitwise
+static uint32_t crc32(const void *p, size_t sz) {
+  const uint8_t *b = (const uint8_t *)p;
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0u; i < sz; i++) {
+    crc ^= b[i];
+    for (size_t k = 0u; k < 8u; k++) {
+      crc = (crc >> 1u) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+// Header: 'SFUR', version 1, record count, total length
+// Record: tag, 0, data length, data
+// Trailer: CRC-32
+void sendReport() {
+  uint32_t buf[2 + 2 + 1 + 64 + 1];
+  size_t n = 2u;
+  buf[n++] = 1u | (4u << 16u);         // Flash ID
+  buf[n++] = spi_flash_get_id();
+  uint32_t count = 1u;
+  if (SPI_RESULT_OK == spi0_flash_read_sfdp(0, &buf[n + 1u], 256u) && kSfdpSignature == buf[n + 1u]) {
+    buf[n] = 3u | (256u << 16u);       // SFDP
+    n += 1u + 64u;
+    count++;
+  }
+  const size_t total = (n + 1u) * sizeof(uint32_t);
+  buf[0] = 0x52554653u;                // 'SFUR'
+  buf[1] = 1u | (count << 8u) | (total << 16u);
+  buf[n] = crc32(buf, n * sizeof(uint32_t));
+  Serial.printf("@FR %X %08X\r\n", total, buf[n]);
+  Serial.write((const uint8_t *)buf, total);
+  Serial.printf("\r\n");
+}
+#endif
+
 void setup() {
   Serial.begin(115200u);
   delay(200u);
   Serial.printf("\r\n\n\n");
   dumpSfdp();
+#if SFDP_HEXDUMP_REPORT
+  sendReport();
+#endif
 }
 
 void loop() {
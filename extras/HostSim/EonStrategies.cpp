@@ -0,0 +1,21 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  The sketch strategy list from the OutlineEON example, built as is. The EON
+  EN25Q32C is matched by it; all other parts fall through to the builtin table.
+*/
+#include <Arduino.h>
+#include "../../examples/OutlineEON/CustomEON.ino"
@@ -0,0 +1,313 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Flash Model - see FlashModel.h
+*/
+#include <string.h>
+#include "FlashModel.h"
+
+namespace hostsim {
+
+// Instructions the model knows, the same opcodes as SpiFlashUtils.h
+constexpr uint8_t kWriteStatus1   = 0x01u;
+constexpr uint8_t kWriteDisable   = 0x04u;
+constexpr uint8_t kReadStatus1    = 0x05u;
+constexpr uint8_t kWriteEnable    = 0x06u;
+constexpr uint8_t kWriteStatus3   = 0x11u;
+constexpr uint8_t kReadStatus3    = 0x15u;
+constexpr uint8_t kWriteStatus2   = 0x31u;
+constexpr uint8_t kReadStatus2    = 0x35u;
+constexpr uint8_t kVolatileEnable = 0x50u;
+constexpr uint8_t kReadSfdp       = 0x5Au;
+constexpr uint8_t kEnableReset    = 0x66u;
+constexpr uint8_t kReset          = 0x99u;
+constexpr uint8_t kJedecId        = 0x9Fu;
+
+constexpr uint8_t kWipBit = 0x01u;
+constexpr uint8_t kWelBit = 0x02u;
+constexpr uint8_t kQeS9Bit = 0x02u;     // in SR2
+
+// DW1 - DW9 of the 0xD8 part's Basic Parameter Table, see FlashChipId_D8.h.
+// The 9 DW tables from JESD216 rev 1.00 parts look much the same.
+#define BASIC_DW1_9(dw2) \
+  0xFFF120E5u, (dw2), 0x6B08EB44u, 0xBB423B08u, 0xFFFFFFEEu, 0xFF00FFFFu, \
+  0xFF00FFFFu, 0x520F200Cu, 0xFF00D810u
+#define BASIC_DW10_14 \
+  0xFEBD4A24u, 0x42152782u, 0x331662ECu, 0x757A757Au, 0x5CD5B304u
+
+constexpr uint32_t k32Mbit = 0x01FFFFFFu;
+constexpr uint32_t k8Mbit  = 0x007FFFFFu;
+
+/*
+  The notes for each part are in FlashPartTable.cpp and ModeDIO_ReclaimGPIOs.cpp.
+  Timing is the datasheet typical or the closest part's where the datasheet
+  gives none. Good enough for comparing strategies, not for absolute numbers.
+*/
+const FlashProfile kProfiles[] = {
+  // XMC XM25QH32B - loses SR3 (driver strength) on a volatile SR2 write, a
+  // software reset does not bring it back.
+  {"XMC", 0x164020u, 3u, {0x00u, 0x00u, 0x60u}, {0xFCu, 0x43u, 0x64u},
+    true, true, false, true, true, true, false, 5000u, 0u, 30u,
+    1u, 0u, 9u, {BASIC_DW1_9(k32Mbit)}},
+
+  // GigaDevice GD25Q32C - 8-bit Status Register writes only
+  {"GigaDevice", 0x1640C8u, 3u, {0x00u, 0x00u, 0x60u}, {0xFCu, 0x43u, 0x64u},
+    true, false, false, true, false, false, false, 5000u, 0u, 40u,
+    1u, 0u, 9u, {BASIC_DW1_9(k32Mbit)}},
+
+  // 0xD8 25Q32ET - 8-bit writes only, a software reset clears the
+  // non-volatile QE bit. SFDP 1.06, DW15 QE method 6, DW16 BIT3.
+  {"MysteryD8", 0x1640D8u, 3u, {0x00u, 0x00u, 0x60u}, {0xFCu, 0x43u, 0x64u},
+    true, false, false, true, false, false, true, 5000u, 0u, 40u,
+    1u, 6u, 16u, {BASIC_DW1_9(k32Mbit), BASIC_DW10_14, 0x00640600u, 0x00001008u}},
+
+  // BergMicro BN25F08 - no SFDP, 16-bit writes only
+  {"BergMicro", 0x1440E0u, 2u, {0x00u, 0x00u, 0x00u}, {0xFCu, 0x43u, 0x00u},
+    true, true, false, false, false, false, false, 8000u, 0u, 30u,
+    0u, 0u, 0u, {}},
+
+  // Winbond W25Q32FV - 16-bit and 8-bit writes
+  {"Winbond", 0x1640EFu, 3u, {0x00u, 0x00u, 0x60u}, {0xFCu, 0x43u, 0x64u},
+    true, true, false, true, false, false, false, 10000u, 0u, 30u,
+    1u, 0u, 9u, {BASIC_DW1_9(k32Mbit)}},
+
+  // Older Winbond with the same ID - 16-bit writes only, an 8-bit 01h write
+  // clears SR2
+  {"WinbondOld", 0x1640EFu, 2u, {0x00u, 0x00u, 0x00u}, {0xFCu, 0x43u, 0x00u},
+    true, true, true, false, false, false, false, 15000u, 0u, 30u,
+    1u, 0u, 9u, {BASIC_DW1_9(k32Mbit)}},
+
+  // Zbit ZB25VQ80 - SFDP 1.06, DW15 QE method 4, DW16 BIT3
+  {"Zbit", 0x14605Eu, 2u, {0x00u, 0x00u, 0x00u}, {0xFCu, 0x43u, 0x00u},
+    true, true, false, true, false, false, false, 8000u, 0u, 30u,
+    1u, 6u, 16u, {BASIC_DW1_9(k8Mbit), BASIC_DW10_14, 0x00400600u, 0x00001008u}},
+
+  // Puya P25Q80H
+  {"Puya", 0x146085u, 3u, {0x00u, 0x00u, 0x60u}, {0xFCu, 0x43u, 0x64u},
+    true, true, false, true, false, false, false, 8000u, 0u, 30u,
+    1u, 0u, 9u, {BASIC_DW1_9(k8Mbit)}},
+
+  // EON EN25Q32C - one Status Register, WPDis at S6, no 50h
+  {"EON", 0x16301Cu, 1u, {0x00u, 0x00u, 0x00u}, {0xFCu, 0x00u, 0x00u},
+    false, false, false, false, false, false, false, 10000u, 0u, 30u,
+    1u, 0u, 9u, {BASIC_DW1_9(k32Mbit)}},
+};
+
+#undef BASIC_DW1_9
+#undef BASIC_DW10_14
+
+const size_t kProfileCount = sizeof(kProfiles) / sizeof(kProfiles[0]);
+
+const FlashProfile *flash_profile(const char *name) {
+  for (size_t i = 0u; i < kProfileCount; i++) {
+    if (0 == strcmp(kProfiles[i].name, name)) return &kProfiles[i];
+  }
+  return nullptr;
+}
+
+void FlashModel::attach(const FlashProfile *profile) {
+  profile_ = profile;
+  for (size_t i = 0u; i < 3u; i++) nv_[i] = profile->sr_default[i];
+  nv_writes_ = vol_writes_ = dropped_ = resets_ = 0u;
+
+  // SFDP header, one parameter header, and the Basic Parameter Table at 30h
+  memset(sfdp_, 0xFF, sizeof(sfdp_));
+  if (profile->sfdp_dw) {
+    const uint8_t hdr[16] = {
+      'S', 'F', 'D', 'P', profile->sfdp_minor, profile->sfdp_major, 0x00u, 0xFFu,
+      0x00u, profile->sfdp_minor, profile->sfdp_major, profile->sfdp_dw, 0x30u, 0x00u, 0x00u, 0xFFu
+    };
+    memcpy(sfdp_, hdr, sizeof(hdr));
+    for (size_t i = 0u; i < profile->sfdp_dw; i++) {
+      for (size_t b = 0u; b < 4u; b++) {
+        sfdp_[0x30u + i * 4u + b] = (uint8_t)(profile->sfdp_basic[i] >> (8u * b));
+      }
+    }
+  }
+  power_up();
+}
+
+void FlashModel::power_up() {
+  for (size_t i = 0u; i < 3u; i++) vol_[i] = nv_[i];
+  wel_ = wel_clear_pending_ = vol_wren_ = reset_enabled_ = hang_next_write_ = false;
+  busy_until_ns_ = reset_until_ns_ = 0u;
+}
+
+void FlashModel::set_non_volatile_sr(const size_t idx, const uint8_t value) {
+  nv_[idx] = value;
+  vol_[idx] = value;
+}
+
+bool FlashModel::busy(const uint64_t now_ns) const {
+  return now_ns < busy_until_ns();
+}
+
+void FlashModel::settle(const uint64_t now_ns) {
+  if (wel_clear_pending_ && now_ns >= busy_until_ns_) {
+    wel_ = false;
+    wel_clear_pending_ = false;
+  }
+}
+
+uint8_t FlashModel::read_sr1(const uint64_t now_ns) const {
+  return (vol_[0] & ~(kWipBit | kWelBit)) | ((wel_) ? kWelBit : 0u) | ((now_ns < busy_until_ns_) ? kWipBit : 0u);
+}
+
+void FlashModel::execute(const uint64_t now_ns, const uint8_t cmd, const uint8_t *mosi, const size_t mosi_len,
+  uint8_t *miso, const size_t miso_len) {
+
+  settle(now_ns);
+  // Not driven reads as all ones
+  memset(miso, 0xFF, miso_len);
+  // 50h and 66h only apply to the very next instruction
+  const bool vol_armed = vol_wren_;
+  const bool reset_armed = reset_enabled_;
+  vol_wren_ = false;
+  reset_enabled_ = false;
+
+  if (now_ns < reset_until_ns_) {
+    dropped_++;
+    return;
+  }
+  if (now_ns < busy_until_ns_) {
+    if (kReadStatus1 == cmd) {
+      memset(miso, read_sr1(now_ns), miso_len);
+    } else {
+      dropped_++;
+    }
+    return;
+  }
+
+  const FlashProfile &p = *profile_;
+  switch (cmd) {
+    case kReadStatus1:
+      // Held CS repeats the register
+      memset(miso, read_sr1(now_ns), miso_len);
+      break;
+    case kReadStatus2:
+      if (2u <= p.sr_count) memset(miso, vol_[1], miso_len); else dropped_++;
+      break;
+    case kReadStatus3:
+      if (3u <= p.sr_count) memset(miso, vol_[2], miso_len); else dropped_++;
+      break;
+    case kWriteEnable:
+      wel_ = true;
+      break;
+    case kWriteDisable:
+      wel_ = false;
+      break;
+    case kVolatileEnable:
+      if (p.vol_wren) vol_wren_ = true; else dropped_++;
+      break;
+    case kWriteStatus1:
+    case kWriteStatus2:
+    case kWriteStatus3:
+      write_status(now_ns, cmd, mosi, mosi_len, vol_armed);
+      break;
+    case kJedecId:
+      for (size_t i = 0u; i < miso_len && i < 3u; i++) miso[i] = (uint8_t)(p.id >> (8u * i));
+      break;
+    case kReadSfdp:
+      // 24-bit address and a dummy byte
+      if (p.sfdp_dw && 4u <= mosi_len) {
+        const size_t addr = ((size_t)mosi[0] << 16u) | ((size_t)mosi[1] << 8u) | mosi[2];
+        for (size_t i = 0u; i < miso_len; i++) {
+          miso[i] = (sizeof(sfdp_) > addr + i) ? sfdp_[addr + i] : 0xFFu;
+        }
+      } else {
+        dropped_++;
+      }
+      break;
+    case kEnableReset:
+      reset_enabled_ = true;
+      break;
+    case kReset:
+      if (reset_armed) reset(now_ns); else dropped_++;
+      break;
+    default:
+      dropped_++;
+      break;
+  }
+}
+
+void FlashModel::write_status(const uint64_t now_ns, const uint8_t cmd, const uint8_t *mosi, const size_t len, const bool vol_armed) {
+  const FlashProfile &p = *profile_;
+  uint8_t value[3] = {0u, 0u, 0u};
+  uint32_t regs = 0u;
+  if (kWriteStatus1 == cmd) {
+    if (1u == len) {
+      regs = 1u;
+      value[0] = mosi[0];
+      // value[1] stays 0
+      if (p.wrsr_8bit_clears_sr2) regs |= 2u;
+    } else if (2u == len && p.wrsr_16bit && 2u <= p.sr_count) {
+      regs = 1u | 2u;
+      value[0] = mosi[0];
+      value[1] = mosi[1];
+    }
+  } else if (kWriteStatus2 == cmd) {
+    if (1u == len && p.wrsr2 && 2u <= p.sr_count) {
+      regs = 2u;
+      value[1] = mosi[0];
+    }
+  } else if (kWriteStatus3 == cmd) {
+    if (1u == len && 3u <= p.sr_count) {
+      regs = 4u;
+      value[2] = mosi[0];
+    }
+  }
+  // Not a length this part takes. WEL stays set.
+  if (0u == regs) {
+    dropped_++;
+    return;
+  }
+
+  if (wel_) {
+    for (size_t r = 0u; r < 3u; r++) {
+      if (0u == (regs & (1u << r))) continue;
+      nv_[r] = (uint8_t)((nv_[r] & ~p.sr_writable[r]) | (value[r] & p.sr_writable[r]));
+      vol_[r] = nv_[r];
+    }
+    nv_writes_++;
+    busy_until_ns_ = (hang_next_write_) ? kForever : now_ns + (uint64_t)p.tw_us * 1000u;
+    hang_next_write_ = false;
+    wel_clear_pending_ = true;
+  } else if (vol_armed) {
+    for (size_t r = 0u; r < 3u; r++) {
+      if (0u == (regs & (1u << r))) continue;
+      vol_[r] = (uint8_t)((vol_[r] & ~p.sr_writable[r]) | (value[r] & p.sr_writable[r]));
+    }
+    if (p.vol_sr2_clears_sr3 && (regs & 2u)) vol_[2] = 0u;
+    vol_writes_++;
+    busy_until_ns_ = now_ns + (uint64_t)p.tw_vol_us * 1000u;
+  } else {
+    dropped_++;
+  }
+}
+
+void FlashModel::reset(const uint64_t now_ns) {
+  const FlashProfile &p = *profile_;
+  resets_++;
+  if (p.reset_clears_nv_qe) nv_[1] &= ~kQeS9Bit;
+  vol_[0] = nv_[0];
+  vol_[1] = nv_[1];
+  if (! p.reset_keeps_sr3) vol_[2] = nv_[2];
+  wel_ = wel_clear_pending_ = false;
+  busy_until_ns_ = 0u;
+  reset_until_ns_ = now_ns + (uint64_t)p.trst_us * 1000u;
+}
+
+};  // namespace hostsim {
@@ -0,0 +1,129 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Flash Model - a behavioural SPI NOR flash for the host build
+
+  Status Registers-1, 2, and 3, each with a non-volatile copy and the volatile
+  (active) copy that reads return. A power-up loads the volatile copy from the
+  non-volatile one. The per part differences from FlashPartTable.cpp and the
+  notes in ModeDIO_ReclaimGPIOs.cpp are flags of a FlashProfile.
+
+  Write Status Register, 01h, 31h, or 11h:
+    * With WEL set (06h), the non-volatile and volatile copies are written and
+      WIP stays set for tW. WEL clears when the write completes. A set WEL wins
+      over 50h, the hazard spi0_flash_write_status_sequence() guards against.
+    * Right after 50h, on parts that have it, only the volatile copy is written.
+    * Otherwise, or for a length the part does not take, the write is dropped
+      and WEL stays set. This is how the BootROM's 16-bit write fails on parts
+      with 8-bit writes only.
+
+  While WIP is set, only Read Status Register-1 is answered. 66h then 99h
+  resets the part; for tRST it does not drive MISO and reads as all ones,
+  as does any read the part does not have.
+*/
+#ifndef HOSTSIM_FLASH_MODEL_H
+#define HOSTSIM_FLASH_MODEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace hostsim {
+
+struct FlashProfile {
+  const char *name;
+  uint32_t id;                  // 0xCCTTVV, as spi_flash_get_id() returns it
+  uint8_t sr_count;             // Status Registers, 1 - 3
+  uint8_t sr_default[3];        // Non-volatile values as shipped
+  uint8_t sr_writable[3];       // Bits a Status Register write changes
+  bool vol_wren;                // Has Volatile Write Enable 50h
+  bool wrsr_16bit;              // 01h takes SR1 and SR2 as one 16-bit write
+  bool wrsr_8bit_clears_sr2;    // An 8-bit 01h write clears SR2, legacy Winbond
+  bool wrsr2;                   // 31h writes SR2
+  bool vol_sr2_clears_sr3;      // XMC, a volatile write of SR2 clears SR3
+  bool reset_keeps_sr3;         // XMC, 66h-99h does not reload SR3
+  bool reset_clears_nv_qe;      // 0xD8, 66h-99h clears the non-volatile QE/S9
+  uint32_t tw_us;               // Non-volatile Status Register write, tW
+  uint32_t tw_vol_us;           // Volatile Status Register write
+  uint32_t trst_us;             // Software reset recovery, tRST
+  uint8_t sfdp_major;           // 1ST parameter table revision
+  uint8_t sfdp_minor;
+  uint8_t sfdp_dw;              // Basic Parameter Table length, 0 for no SFDP
+  uint32_t sfdp_basic[16];
+};
+
+extern const FlashProfile kProfiles[];
+extern const size_t kProfileCount;
+// nullptr when there is no profile by that name
+const FlashProfile *flash_profile(const char *name);
+
+class FlashModel {
+public:
+  void attach(const FlashProfile *profile);
+  const FlashProfile *profile() const { return profile_; }
+
+  // Status Registers back to the non-volatile values, WEL and WIP clear
+  void power_up();
+
+  // One instruction with CS low: cmd, then mosi, then miso is filled. now_ns
+  // is the time CS goes high.
+  void execute(const uint64_t now_ns, const uint8_t cmd, const uint8_t *mosi, const size_t mosi_len,
+    uint8_t *miso, const size_t miso_len);
+
+  // WIP set, or in tRST, at now_ns. busy_until_ns() is when it ends.
+  // The next non-volatile Status Register write never completes, WIP stays
+  // set until a reset or power-up.
+  void hang_next_write() { hang_next_write_ = true; }
+  static constexpr uint64_t kForever = UINT64_MAX;
+
+  bool busy(const uint64_t now_ns) const;
+  uint64_t busy_until_ns() const { return (busy_until_ns_ > reset_until_ns_) ? busy_until_ns_ : reset_until_ns_; }
+
+  uint8_t volatile_sr(const size_t idx) const { return vol_[idx]; }
+  uint8_t non_volatile_sr(const size_t idx) const { return nv_[idx]; }
+  void set_non_volatile_sr(const size_t idx, const uint8_t value);
+  bool wel() const { return wel_; }
+
+  uint32_t nv_writes() const { return nv_writes_; }
+  uint32_t vol_writes() const { return vol_writes_; }
+  uint32_t dropped() const { return dropped_; }
+  uint32_t resets() const { return resets_; }
+
+private:
+  void settle(const uint64_t now_ns);
+  uint8_t read_sr1(const uint64_t now_ns) const;
+  void write_status(const uint64_t now_ns, const uint8_t cmd, const uint8_t *mosi, const size_t len, const bool vol_armed);
+  void reset(const uint64_t now_ns);
+
+  const FlashProfile *profile_ = nullptr;
+  uint8_t nv_[3] = {0u, 0u, 0u};
+  uint8_t vol_[3] = {0u, 0u, 0u};
+  uint8_t sfdp_[256];
+  bool wel_ = false;
+  bool wel_clear_pending_ = false;
+  bool vol_wren_ = false;
+  bool reset_enabled_ = false;
+  bool hang_next_write_ = false;
+  uint64_t busy_until_ns_ = 0u;
+  uint64_t reset_until_ns_ = 0u;
+  uint32_t nv_writes_ = 0u;
+  uint32_t vol_writes_ = 0u;
+  uint32_t dropped_ = 0u;
+  uint32_t resets_ = 0u;
+};
+
+};  // namespace hostsim {
+
+#endif // HOSTSIM_FLASH_MODEL_H
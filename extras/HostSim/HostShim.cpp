@@ -0,0 +1,408 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Host Shim - see HostShim.h
+*/
+#include <Arduino.h>
+#include <user_interface.h>
+#include <spi_utils.h>
+#include <stdio.h>
+#include "BootROM_NONOS.h"
+#include "ReclaimedPins.h"
+#include "HostShim.h"
+
+using namespace hostsim;
+
+constexpr uint8_t kReadStatus1 = 0x05u;
+constexpr uint8_t kWriteEnable = 0x06u;
+constexpr uint8_t kWriteStatus1 = 0x01u;
+constexpr uint8_t kJedecId = 0x9Fu;
+
+constexpr uint32_t kRtcBlocks = 192u;
+constexpr uint32_t kRtcUserBlock = 64u;
+
+constexpr uint32_t kSpi0BootMode = SPICDIO | SPICFASTRD | SPICAHB | SPIC2BSE;
+
+static struct {
+  FlashModel flash;
+  uint64_t now_ns;
+  BusStats stats;
+  uint32_t depth;               // iCache off windows
+  uint64_t window_start_ns;
+  uint32_t window_spi0c;
+  uint32_t faults;
+  uint32_t hangs;
+  uint32_t rtc[kRtcBlocks];
+  uint32_t rtc_seed;
+  struct rst_info rst;
+  uint8_t pin_mode[17];
+  bool verbose;
+} board;
+
+HostSpi0Regs host_spi0;
+volatile uint32_t host_gpio[8];
+volatile uint32_t host_gpc[17];
+volatile uint32_t host_gpf[17];
+
+static SpiFlashChip host_flashchip = {0u, 4u * 1024u * 1024u, 64u * 1024u, 4096u, 256u, 0xFFFFu};
+SpiFlashChip *flashchip = &host_flashchip;
+
+HardwareSerial Serial;
+
+////////////////////////////////////////////////////////////////////////////////
+// Bus
+//
+static void begin_transaction(void) {
+  if (board.depth) board.faults++;
+  board.depth++;
+  board.stats.transactions++;
+  board.window_start_ns = board.now_ns;
+  board.window_spi0c = SPI0C;
+  board.now_ns += kWindowOverheadNs;
+}
+
+static void end_transaction(void) {
+  if (0u == board.depth) {
+    board.faults++;
+    return;
+  }
+  board.depth--;
+  if (SPI0C != board.window_spi0c) board.faults++;
+  board.stats.bus_ns += board.now_ns - board.window_start_ns;
+}
+
+// One instruction, bytes in wire order
+static void transfer(const uint8_t cmd, const uint8_t *mosi, const size_t mosi_len, uint8_t *miso, const size_t miso_len) {
+  const uint64_t bits = 8u + 8u * (mosi_len + miso_len);
+  board.now_ns += kCsOverheadNs + (bits * 1000000000u) / kSpiClockHz;
+  board.flash.execute(board.now_ns, cmd, mosi, mosi_len, miso, miso_len);
+  board.stats.commands++;
+}
+
+// Words to bytes, the SPI0 W registers send the low byte first
+static void words_to_bytes(const uint32_t *w, uint8_t *b, const size_t len) {
+  for (size_t i = 0u; i < len; i++) b[i] = (uint8_t)(w[i / 4u] >> (8u * (i % 4u)));
+}
+
+static void bytes_to_words(const uint8_t *b, const size_t len, uint32_t *w) {
+  for (size_t i = 0u; i < (len + 3u) / 4u; i++) w[i] = 0u;
+  for (size_t i = 0u; i < len; i++) w[i / 4u] |= (uint32_t)b[i] << (8u * (i % 4u));
+}
+
+static uint8_t read_status1(void) {
+  uint8_t sr1 = 0u;
+  transfer(kReadStatus1, nullptr, 0u, &sr1, 1u);
+  return sr1;
+}
+
+// BootROM style wait, one read, then skip to the end of WIP
+static uint8_t wait_idle(void) {
+  uint8_t sr1 = read_status1();
+  if (board.flash.busy(board.now_ns)) {
+    if (FlashModel::kForever == board.flash.busy_until_ns()) {
+      board.hangs++;
+      return sr1;
+    }
+    board.now_ns = board.flash.busy_until_ns();
+    sr1 = read_status1();
+  }
+  return sr1;
+}
+
+HostSpi0Cmd &HostSpi0Cmd::operator=(const uint32_t value) {
+  if (0u == (value & SPICMDUSR)) return *this;
+  // The iCache must be off, and the controller in the most basic IO mode
+  if (0u == board.depth) board.faults++;
+  if (SPI0C & (SPICQIO | SPICDIO | SPICQOUT | SPICDOUT | SPICFASTRD)) board.faults++;
+
+  const uint32_t u = host_spi0.user;
+  const uint32_t u1 = host_spi0.user1;
+  const uint8_t cmd = (uint8_t)(host_spi0.user2 & 0xFFu);
+  const size_t mosi_bits = (u & SPIUMOSI) ? ((u1 >> SPILMOSI) & SPIMMOSI) + 1u : 0u;
+  const size_t miso_bits = (u & SPIUMISO) ? ((u1 >> SPILMISO) & SPIMMISO) + 1u : 0u;
+  uint8_t mosi[64];
+  uint8_t miso[64];
+  const size_t mosi_len = std::min((mosi_bits + 7u) / 8u, sizeof(mosi));
+  const size_t miso_len = std::min((miso_bits + 7u) / 8u, sizeof(miso));
+  words_to_bytes(host_spi0.w, mosi, mosi_len);
+  transfer(cmd, mosi, mosi_len, miso, miso_len);
+  if (miso_len) bytes_to_words(miso, miso_len, host_spi0.w);
+  return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BootROM, SDK and core
+//
+extern "C" {
+
+void Cache_Read_Disable_2(void) {
+  begin_transaction();
+}
+
+void Cache_Read_Enable_2(void) {
+  end_transaction();
+}
+
+uint32_t Wait_SPI_Idle(SpiFlashChip *fc) {
+  (void)fc;
+  return (0u != wait_idle()) ? 1u : 0u;
+}
+
+int SPI_read_status(SpiFlashChip *chip, uint32_t *status) {
+  (void)chip;
+  *status = wait_idle();
+  return 0;
+}
+
+uint32_t spi_flash_get_id(void) {
+  begin_transaction();
+  wait_idle();
+  uint8_t id[3];
+  transfer(kJedecId, nullptr, 0u, id, sizeof(id));
+  end_transaction();
+  return (uint32_t)id[0] | ((uint32_t)id[1] << 8u) | ((uint32_t)id[2] << 16u);
+}
+
+SpiFlashOpResult spi_flash_read_status(uint32_t *status) {
+  begin_transaction();
+  *status = wait_idle();
+  end_transaction();
+  return SPI_FLASH_RESULT_OK;
+}
+
+uint32_t esp_get_cycle_count(void) {
+  return (uint32_t)(board.now_ns * kCpuMhz / 1000u);
+}
+
+void ets_delay_us(uint32_t us) {
+  board.now_ns += (uint64_t)us * 1000u;
+}
+
+unsigned long micros(void) {
+  return (unsigned long)(board.now_ns / 1000u);
+}
+
+unsigned long millis(void) {
+  return (unsigned long)(board.now_ns / 1000000u);
+}
+
+void delay(unsigned long ms) {
+  board.now_ns += (uint64_t)ms * 1000000u;
+}
+
+void yield(void) {
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (sizeof(board.pin_mode) > pin) board.pin_mode[pin] = mode;
+}
+
+struct rst_info *system_get_rst_info(void) {
+  return &board.rst;
+}
+
+bool system_rtc_mem_read(uint8_t src_addr, void *des_addr, uint16_t load_size) {
+  if (kRtcUserBlock > src_addr || (kRtcBlocks - src_addr) * 4u < load_size) return false;
+  memcpy(des_addr, &board.rtc[src_addr], load_size);
+  return true;
+}
+
+bool system_rtc_mem_write(uint8_t des_addr, const void *src_addr, uint16_t save_size) {
+  if (kRtcUserBlock > des_addr || (kRtcBlocks - des_addr) * 4u < save_size) return false;
+  memcpy(&board.rtc[des_addr], src_addr, save_size);
+  return true;
+}
+
+void system_soft_wdt_feed(void) {
+}
+
+uint8_t system_get_cpu_freq(void) {
+  return kCpuMhz;
+}
+
+namespace experimental {
+
+SpiOpResult SPI0Command(uint8_t cmd, uint32_t *data, uint32_t mosi_bits, uint32_t miso_bits, uint32_t pre_cmd) {
+  if (512u < mosi_bits || 512u < miso_bits) return SPI_RESULT_ERR;
+  if ((mosi_bits || miso_bits) && nullptr == data) return SPI_RESULT_ERR;
+  uint8_t mosi[64];
+  uint8_t miso[64];
+  const size_t mosi_len = (mosi_bits + 7u) / 8u;
+  const size_t miso_len = (miso_bits + 7u) / 8u;
+  if (mosi_len) words_to_bytes(data, mosi, mosi_len);
+
+  begin_transaction();
+  wait_idle();
+  if (pre_cmd) transfer((uint8_t)pre_cmd, nullptr, 0u, nullptr, 0u);
+  transfer(cmd, mosi, mosi_len, miso, miso_len);
+  end_transaction();
+  // Cleared to the bit length
+  if (miso_len) {
+    bytes_to_words(miso, miso_len, data);
+    if (miso_bits % 32u) data[miso_bits / 32u] &= (1u << (miso_bits % 32u)) - 1u;
+  }
+  return SPI_RESULT_OK;
+}
+
+};  // namespace experimental {
+
+};
+
+static int serial_vprintf(const char *fmt, va_list ap) {
+  if (! board.verbose) return 0;
+  return vprintf(fmt, ap);
+}
+
+extern "C" int ets_uart_printf(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = serial_vprintf(fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+int Print::printf(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = serial_vprintf(fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+int Print::printf_P(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = serial_vprintf(fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+size_t Print::print(const char *s) {
+  return (size_t)printf("%s", s);
+}
+
+size_t Print::println(const char *s) {
+  return (size_t)printf("%s\n", s);
+}
+
+size_t Print::println(const __FlashStringHelper *s) {
+  return println(reinterpret_cast<const char *>(s));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Board
+//
+namespace hostsim {
+
+// The BootROM for a DIO flash mode, Disable_QMode: Write Enable, then a 16-bit
+// Write Status Register-1 that keeps SR1 and clears SR2. A part without 16-bit
+// writes drops it and is left with WEL set.
+static void bootrom_disable_qmode(void) {
+  begin_transaction();
+  wait_idle();
+  transfer(kWriteEnable, nullptr, 0u, nullptr, 0u);
+  const uint8_t status[2] = {(uint8_t)(read_status1() & ~0x03u), 0x00u};
+  transfer(kWriteStatus1, status, sizeof(status), nullptr, 0u);
+  wait_idle();
+  end_transaction();
+}
+
+static void boot(const uint32_t reason) {
+  memset(&board.rst, 0, sizeof(board.rst));
+  board.rst.reason = reason;
+  SPI0C = kSpi0BootMode;
+  bootrom_disable_qmode();
+  // .data is loaded from the image at each boot
+  reclaimed_pins_set_available(false);
+  memset(board.pin_mode, 0xFF, sizeof(board.pin_mode));
+}
+
+void board_attach(const FlashProfile *profile) {
+  memset(&board.stats, 0, sizeof(board.stats));
+  board.faults = 0u;
+  board.hangs = 0u;
+  board.depth = 0u;
+  board.flash.attach(profile);
+  board_power_cycle();
+}
+
+FlashModel &board_flash() {
+  return board.flash;
+}
+
+void board_power_cycle() {
+  board.flash.power_up();
+  // RTC memory does not keep its content without power
+  for (size_t i = 0u; i < kRtcBlocks; i++) {
+    board.rtc_seed = board.rtc_seed * 1664525u + 1013904223u;
+    board.rtc[i] = board.rtc_seed;
+  }
+  boot(REASON_DEFAULT_RST);
+}
+
+void board_soft_restart() {
+  boot(REASON_SOFT_RESTART);
+}
+
+void board_deep_sleep_wake() {
+  boot(REASON_DEEP_SLEEP_AWAKE);
+}
+
+void board_set_quad_mode(const bool quad) {
+  SPI0C = (quad) ? ((kSpi0BootMode & ~SPICDIO) | SPICQIO) : kSpi0BootMode;
+}
+
+BusStats board_stats() {
+  BusStats s = board.stats;
+  s.nv_writes = board.flash.nv_writes();
+  s.vol_writes = board.flash.vol_writes();
+  s.dropped = board.flash.dropped();
+  return s;
+}
+
+BusStats board_stats_since(const BusStats &mark) {
+  const BusStats now = board_stats();
+  BusStats s;
+  s.transactions = now.transactions - mark.transactions;
+  s.commands = now.commands - mark.commands;
+  s.nv_writes = now.nv_writes - mark.nv_writes;
+  s.vol_writes = now.vol_writes - mark.vol_writes;
+  s.dropped = now.dropped - mark.dropped;
+  s.bus_ns = now.bus_ns - mark.bus_ns;
+  return s;
+}
+
+uint64_t board_now_ns() {
+  return board.now_ns;
+}
+
+uint32_t board_faults() {
+  return board.faults;
+}
+
+uint32_t board_hangs() {
+  return board.hangs;
+}
+
+uint32_t board_pin_mode(const uint8_t pin) {
+  return (sizeof(board.pin_mode) > pin) ? board.pin_mode[pin] : 0xFFu;
+}
+
+void board_set_verbose(const bool verbose) {
+  board.verbose = verbose;
+}
+
+};  // namespace hostsim {
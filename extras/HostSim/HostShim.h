@@ -0,0 +1,83 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Host Shim - the ESP8266 side of the host build
+
+  The SPI0 controller, the BootROM and SDK flash calls, the core's SPI0Command,
+  RTC user memory, the reset reason, and a simulated clock, all on one flash
+  model. The library sources build against the headers in shim/ unchanged.
+
+  Each iCache off/on window, SPI0Command call, or SDK flash call is one
+  transaction, the same as SFU_SPI0_COUNT() counts them on the device. Bus time
+  is simulated time with the iCache off: the bits at kSpiClockHz, per
+  instruction and per transaction overheads, and any tW, tRST, or delay waited
+  out inside the transaction. CPU time outside of that is not modelled.
+
+  Wait_SPI_Idle() and SPI_read_status() send one Read Status Register-1. When
+  WIP is set, the clock skips to the end of the write and they read it again.
+  A part that never clears WIP would hang them on the device; here it is
+  counted by board_hangs() and they return.
+*/
+#ifndef HOSTSIM_HOST_SHIM_H
+#define HOSTSIM_HOST_SHIM_H
+
+#include <stdint.h>
+#include "FlashModel.h"
+
+namespace hostsim {
+
+constexpr uint32_t kSpiClockHz = 40000000u;     // SPI0 at 40 MHz, DIO
+constexpr uint32_t kCpuMhz = 80u;
+constexpr uint64_t kCsOverheadNs = 100u;        // CS setup and hold, per instruction
+constexpr uint64_t kWindowOverheadNs = 1000u;   // iCache off/on and SPI0 register save, per transaction
+
+struct BusStats {
+  uint32_t transactions;
+  uint32_t commands;            // Flash instructions, with the BootROM idle checks
+  uint32_t nv_writes;           // Non-volatile Status Register writes, endurance cycles
+  uint32_t vol_writes;
+  uint32_t dropped;             // Instructions the part ignored
+  uint64_t bus_ns;
+};
+
+// Attach a part and power it up
+void board_attach(const FlashProfile *profile);
+FlashModel &board_flash();
+
+// Each runs the BootROM's Disable_QMode for a DIO boot, as the device does.
+// The library's .data flags are reset as the loader would.
+void board_power_cycle();       // REASON_DEFAULT_RST, RTC memory lost
+void board_soft_restart();      // REASON_SOFT_RESTART
+void board_deep_sleep_wake();   // REASON_DEEP_SLEEP_AWAKE, the flash stayed powered
+void board_set_quad_mode(const bool quad);
+
+// Totals since board_attach()
+BusStats board_stats();
+BusStats board_stats_since(const BusStats &mark);
+uint64_t board_now_ns();
+// SPI0 user commands with the iCache on, nested iCache off, or SPI0C left
+// changed. Any is a crash on the device.
+uint32_t board_faults();
+// BootROM WIP polls that would never have returned
+uint32_t board_hangs();
+uint32_t board_pin_mode(const uint8_t pin);
+
+// Serial output to stdout
+void board_set_verbose(const bool verbose);
+
+};  // namespace hostsim {
+
+#endif // HOSTSIM_HOST_SHIM_H
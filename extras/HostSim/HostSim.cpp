@@ -0,0 +1,482 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  HostSim - regression checks and a benchmark of the reclaim strategies, run
+  against the flash model. See README.md.
+
+    hostsim        run the checks, exit status 1 on a failure
+    hostsim -b     also print the benchmark table
+    hostsim -v     also show the library's Serial output
+
+  The build options of the library, like -DRECLAIM_GPIO_RECIPE_CACHE=1, are
+  fixed per binary. The Makefile builds one binary for each set of options.
+*/
+#include <Arduino.h>
+#include <stdio.h>
+#include <ModeDIO_ReclaimGPIOs.h>
+#include <SrWearGuard.h>
+#include <SrNvCommit.h>
+#include "HostShim.h"
+
+#ifndef HOSTSIM_VARIANT
+#define HOSTSIM_VARIANT "default"
+#endif
+
+using namespace experimental;
+using namespace hostsim;
+
+static const char *scenario = "";
+static uint32_t checks = 0u;
+static uint32_t failures = 0u;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+static void check(const bool ok, const char *what, const int line) {
+  checks++;
+  if (ok) return;
+  failures++;
+  printf("FAIL [%s] %s: HostSim.cpp:%d: %s\n", HOSTSIM_VARIANT, scenario, line, what);
+}
+
+static const FlashProfile *attach(const char *name) {
+  const FlashProfile *profile = flash_profile(name);
+  if (nullptr == profile) {
+    printf("FAIL [%s] no flash profile %s\n", HOSTSIM_VARIANT, name);
+    exit(1);
+  }
+  board_attach(profile);
+  return profile;
+}
+
+// Where each part keeps the bit that disables /WP and /HOLD, and whether
+// reclaim_GPIO_9_10() writes it non-volatile.
+struct ReclaimExpect {
+  const char *name;
+  uint8_t sr;                   // Status Register index
+  uint8_t qe;                   // QE/S9 or WPDis/S6 bit in that register
+  bool non_volatile;
+};
+
+static const ReclaimExpect kExpect[] = {
+  {"XMC",        1u, BIT1, false},
+  {"GigaDevice", 1u, BIT1, false},
+  {"MysteryD8",  1u, BIT1, false},
+  {"BergMicro",  1u, BIT1, false},
+  {"Winbond",    1u, BIT1, false},
+  {"WinbondOld", 1u, BIT1, false},
+  {"Zbit",       1u, BIT1, false},
+  {"Puya",       1u, BIT1, false},
+  // CustomEON.ino from the OutlineEON example
+  {"EON",        0u, BIT6, true},
+};
+
+static const ReclaimExpect *expect_for(const char *name) {
+  for (const ReclaimExpect &e : kExpect) {
+    if (0 == strcmp(e.name, name)) return &e;
+  }
+  return nullptr;
+}
+
+struct Measured {
+  bool ok;
+  BusStats stats;
+};
+
+static Measured measure(bool (*fn)(void)) {
+  const BusStats mark = board_stats();
+  const bool ok = fn();
+  return {ok, board_stats_since(mark)};
+}
+
+static bool reclaim_once(void) {
+  return reclaim_GPIO_9_10();
+}
+
+static bool reclaim_fast_once(void) {
+  return reclaim_GPIO_9_10_fast();
+}
+
+struct SingleVendor {
+  const char *name;
+  bool (*run)(void);
+};
+
+static const SingleVendor kSingleVendor[] = {
+  {"XMC",        reclaim_GPIO_9_10<Vendor::XMC>},
+  {"GigaDevice", reclaim_GPIO_9_10<Vendor::GigaDevice>},
+  {"MysteryD8",  reclaim_GPIO_9_10<Vendor::MysteryD8>},
+  {"BergMicro",  reclaim_GPIO_9_10<Vendor::BergMicro>},
+  {"Winbond",    reclaim_GPIO_9_10<Vendor::Winbond>},
+  {"WinbondOld", reclaim_GPIO_9_10<Vendor::Winbond>},
+  {"Zbit",       reclaim_GPIO_9_10<Vendor::Zbit>},
+  {"Puya",       reclaim_GPIO_9_10<Vendor::Puya>},
+  {"EON",        reclaim_GPIO_9_10<Vendor::EON>},
+};
+
+static bool (*single_vendor_for(const char *name))(void) {
+  for (const SingleVendor &s : kSingleVendor) {
+    if (0 == strcmp(s.name, name)) return s.run;
+  }
+  return nullptr;
+}
+
+// The state every successful reclaim must leave. The full detection ends with a
+// Write Disable. A replay or the fast check may leave the WEL set by the
+// BootROM; every library write starts with 06h or 04h-50h.
+static void check_reclaimed(const ReclaimExpect &e, const uint32_t faults, const bool detect = true) {
+  FlashModel &flash = board_flash();
+  CHECK(e.qe == (flash.volatile_sr(e.sr) & e.qe));
+  CHECK(e.non_volatile == (e.qe == (flash.non_volatile_sr(e.sr) & e.qe)));
+  if (detect) {
+    CHECK(! flash.wel());
+  }
+  CHECK(reclaimed_pins_available());
+  CHECK(INPUT == board_pin_mode(9u));
+  CHECK(INPUT == board_pin_mode(10u));
+  CHECK(faults == board_faults());
+}
+
+static void check_timing(const Measured &m) {
+#if RECLAIM_GPIO_TIMING
+  // The on-device counters agree with the bus
+  CHECK(reclaim_timing_is_valid());
+  CHECK(m.stats.transactions == reclaim_timing_get()->spi0_calls);
+  // flash_cmds leaves out the Wait_SPI_Idle() and WIP polls
+  CHECK(m.stats.transactions <= reclaim_timing_get()->flash_cmds);
+  CHECK(m.stats.commands >= reclaim_timing_get()->flash_cmds);
+#else
+  (void)m;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Every part, reclaim_GPIO_9_10() and the single vendor build after power-up
+static void test_cold_reclaim(void) {
+  for (size_t i = 0u; i < kProfileCount; i++) {
+    const FlashProfile &p = kProfiles[i];
+    const ReclaimExpect *e = expect_for(p.name);
+    scenario = p.name;
+    CHECK(nullptr != e);
+    if (nullptr == e) continue;
+
+    attach(p.name);
+    const uint32_t faults = board_faults();
+    const Measured m = measure(reclaim_once);
+    CHECK(m.ok);
+    check_reclaimed(*e, faults);
+    check_timing(m);
+    // Only the parts without a volatile Status Register cost an endurance cycle
+    CHECK(((e->non_volatile) ? 1u : 0u) == m.stats.nv_writes);
+
+    // Again, the bit is found set and nothing is written
+    const Measured again = measure(reclaim_once);
+    CHECK(again.ok);
+    CHECK(0u == again.stats.nv_writes);
+    CHECK(0u == again.stats.vol_writes);
+
+    attach(p.name);
+    const Measured single = measure(single_vendor_for(p.name));
+    CHECK(single.ok);
+    check_reclaimed(*e, faults);
+    CHECK(single.stats.transactions < m.stats.transactions);
+  }
+}
+
+// SPI0 in QIO or QOUT, nothing is sent
+static void test_quad_mode(void) {
+  scenario = "QIO";
+  attach("Winbond");
+  board_set_quad_mode(true);
+  const Measured m = measure(reclaim_once);
+  CHECK(! m.ok);
+  CHECK(0u == m.stats.transactions);
+  CHECK(! reclaimed_pins_available());
+  board_set_quad_mode(false);
+}
+
+// A volatile write of SR2 clears the XMC SR3, and a software reset does not
+// bring it back.
+static void test_xmc_sr3(void) {
+  scenario = "XMC SR3";
+  const FlashProfile *p = attach("XMC");
+  FlashModel &flash = board_flash();
+  const uint8_t sr3 = p->sr_default[2];
+
+  CHECK(set_S9_QE_bit__16_bit_sr1_write(volatile_bit));
+  CHECK(0u == flash.volatile_sr(2));
+  CHECK(spi0_flash_software_reset_wait(nullptr) == SPI_RESULT_OK);
+  CHECK(0u == (flash.volatile_sr(1) & BIT1));
+  CHECK(0u == flash.volatile_sr(2));
+
+  board_power_cycle();
+  CHECK(sr3 == flash.volatile_sr(2));
+  const BusStats mark = board_stats();
+  CHECK(set_S9_QE_bit__16_bit_sr1_write__xmc_sr3());
+  CHECK(BIT1 == (flash.volatile_sr(1) & BIT1));
+  CHECK(sr3 == flash.volatile_sr(2));
+  CHECK(sr3 == flash.non_volatile_sr(2));
+  CHECK(0u == board_stats_since(mark).nv_writes);
+}
+
+// 66h-99h clears the non-volatile QE bit of the 0xD8 part, not of the
+// GigaDevice part it looks like.
+static void test_d8_reset(void) {
+  static const char *const parts[] = {"MysteryD8", "GigaDevice"};
+  for (const char *name : parts) {
+    scenario = name;
+    const FlashProfile *p = attach(name);
+    FlashModel &flash = board_flash();
+    CHECK(set_S9_QE_bit__8_bit_sr2_write(non_volatile_bit));
+    CHECK(BIT1 == (flash.non_volatile_sr(1) & BIT1));
+
+    uint32_t elapsed_us = 0u;
+    CHECK(SPI_RESULT_OK == spi0_flash_software_reset_wait(&elapsed_us));
+    CHECK(p->trst_us <= elapsed_us);
+    const uint32_t qe = (p->reset_clears_nv_qe) ? 0u : BIT1;
+    CHECK(qe == (flash.non_volatile_sr(1) & BIT1));
+    CHECK(qe == (flash.volatile_sr(1) & BIT1));
+  }
+}
+
+// One Status Register and no 50h. The WPDis bit is written once; the
+// BootROM's 16-bit write fails, so it is still set at the next boot.
+static void test_eon(void) {
+  scenario = "EON";
+  attach("EON");
+  FlashModel &flash = board_flash();
+  CHECK(flash.wel());
+  const Measured m = measure(reclaim_GPIO_9_10<Vendor::EON>);
+  CHECK(m.ok);
+  CHECK(1u == m.stats.nv_writes);
+  CHECK(BIT6 == (flash.non_volatile_sr(0) & BIT6));
+
+  board_soft_restart();
+  CHECK(BIT6 == (flash.volatile_sr(0) & BIT6));
+  const Measured again = measure(reclaim_GPIO_9_10<Vendor::EON>);
+  CHECK(again.ok);
+  CHECK(0u == again.stats.nv_writes);
+}
+
+// The BootROM leaves WEL set on 8-bit only parts. With WEL set, a 50h write
+// goes non-volatile. The write sequence must clear WEL first.
+static void test_wel_left_set(void) {
+  scenario = "WEL left set";
+  attach("GigaDevice");
+  FlashModel &flash = board_flash();
+  CHECK(flash.wel());
+  const Measured m = measure(reclaim_once);
+  CHECK(m.ok);
+  CHECK(0u == m.stats.nv_writes);
+  CHECK(0u == (flash.non_volatile_sr(1) & BIT1));
+
+  // What the 04h in the sequence prevents
+  attach("GigaDevice");
+  uint32_t status2 = BIT1;
+  SPI0Command(kWriteStatusRegister2Cmd, &status2, 8u, 0u, kVolatileWriteEnableCmd);
+  CHECK(1u == flash.nv_writes());
+}
+
+// A 16-bit part, the BootROM clears QE at each boot. A legacy part also
+// clears SR2 on an 8-bit Status Register-1 write.
+static void test_bootrom_and_legacy(void) {
+  scenario = "BootROM";
+  attach("Winbond");
+  FlashModel &flash = board_flash();
+  CHECK(reclaim_GPIO_9_10());
+  const uint32_t writes = flash.nv_writes();
+  board_soft_restart();
+  CHECK(writes + 1u == flash.nv_writes());
+  CHECK(0u == (flash.volatile_sr(1) & BIT1));
+
+  scenario = "WinbondOld";
+  attach("WinbondOld");
+  CHECK(reclaim_GPIO_9_10());
+  CHECK(SPI_RESULT_OK == spi0_flash_write_status_register_1(BIT2, volatile_bit));
+  CHECK(0u == (flash.volatile_sr(1) & BIT1));
+}
+
+// A write that never completes. The WIP poll gives up and nothing after it
+// spins on WIP.
+static void test_stuck_busy(void) {
+  scenario = "stuck busy";
+  attach("Winbond");
+  board_flash().hang_next_write();
+  const uint64_t start = board_now_ns();
+  CHECK(SPI_RESULT_TIMEOUT == spi0_flash_write_status_register_1(BIT2, non_volatile_bit));
+  CHECK(0u == board_hangs());
+  CHECK((uint64_t)kSpi0WaitReadyTimeoutUs * 1000u <= board_now_ns() - start);
+}
+
+#if RECLAIM_GPIO_RECIPE_CACHE
+// Warm boots replay the recipe, a power cycle runs the full detection
+static void test_recipe(void) {
+  for (size_t i = 0u; i < kProfileCount; i++) {
+    const FlashProfile &p = kProfiles[i];
+    const ReclaimExpect *e = expect_for(p.name);
+    if (nullptr == e) continue;
+    scenario = p.name;
+
+    attach(p.name);
+    const uint32_t faults = board_faults();
+    const Measured cold = measure(reclaim_once);
+    CHECK(cold.ok);
+
+    board_soft_restart();
+    const Measured warm = measure(reclaim_once);
+    CHECK(warm.ok);
+    check_reclaimed(*e, faults, false);
+    check_timing(warm);
+    CHECK(warm.stats.transactions < cold.stats.transactions);
+    // Not even the EON's non-volatile bit is written again
+    CHECK(0u == warm.stats.nv_writes);
+
+    // The volatile bit is still set on parts the BootROM cannot write
+    board_deep_sleep_wake();
+    const bool kept = (e->qe == (board_flash().volatile_sr(e->sr) & e->qe));
+    const Measured fast = measure(reclaim_fast_once);
+    CHECK(fast.ok);
+    check_reclaimed(*e, faults, false);
+    if (kept) {
+      CHECK(1u == fast.stats.transactions);
+    }
+    CHECK(fast.stats.transactions <= warm.stats.transactions + 1u);
+
+    board_power_cycle();
+    const Measured again = measure(reclaim_once);
+    CHECK(again.ok);
+    CHECK(again.stats.transactions > warm.stats.transactions);
+  }
+}
+#endif
+
+#if FLASH_SR_NV_COMMIT
+// The BootROM's Disable_QMode undoes a committed non-volatile QE at each boot
+static void test_nv_commit(void) {
+  scenario = "NV commit";
+  attach("Winbond");
+  FlashModel &flash = board_flash();
+  sr_nv_commit_reset();
+  uint32_t verify = 0u;
+  BusStats mark = board_stats();
+  CHECK(SPI_RESULT_OK == spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, kQES9Bit2B, non_volatile_bit, 16u, kReadStatusRegister2Cmd, &verify));
+  CHECK(1u == board_stats_since(mark).nv_writes);
+
+  // Same value, the hardware agrees
+  mark = board_stats();
+  CHECK(SPI_RESULT_OK == spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, kQES9Bit2B, non_volatile_bit, 16u, kReadStatusRegister2Cmd, &verify));
+  CHECK(0u == board_stats_since(mark).nv_writes);
+
+  // The BootROM's write clears QE, the commit finds it lost
+  board_soft_restart();
+  CHECK(0u == (flash.non_volatile_sr(1) & BIT1));
+  mark = board_stats();
+  CHECK(SPI_RESULT_OK == spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, kQES9Bit2B, non_volatile_bit, 16u, kReadStatusRegister2Cmd, &verify));
+  CHECK(1u == board_stats_since(mark).nv_writes);
+  SrNvCommit commit;
+  CHECK(sr_nv_commit_get(&commit));
+  CHECK(1u == commit.rewrites);
+
+  // A volatile QE reads the same as the non-volatile value; the write must
+  // still go out.
+  scenario = "NV after volatile";
+  attach("Winbond");
+  sr_nv_commit_reset();
+  CHECK(set_S9_QE_bit__16_bit_sr1_write(volatile_bit));
+  CHECK(SPI_RESULT_OK == spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, kQES9Bit2B, non_volatile_bit, 16u, kReadStatusRegister2Cmd, &verify));
+  CHECK(BIT1 == (flash.non_volatile_sr(1) & BIT1));
+}
+#endif
+
+#if FLASH_SR_WEAR_GUARD
+static void test_wear_guard(void) {
+  scenario = "wear guard";
+  const FlashProfile *p = attach("Puya");
+  FlashModel &flash = board_flash();
+  sr_wear_reset_counters();
+  const BusStats mark = board_stats();
+  CHECK(SPI_RESULT_OK == spi0_flash_write_status_register_3(p->sr_default[2], non_volatile_bit));
+  CHECK(0u == board_stats_since(mark).nv_writes);
+  CHECK(SPI_RESULT_OK == spi0_flash_write_status_register_3(0x20u, non_volatile_bit));
+  CHECK(1u == board_stats_since(mark).nv_writes);
+  CHECK(0x20u == flash.non_volatile_sr(2));
+  SrWearCounters counters;
+  CHECK(sr_wear_get_counters(&counters));
+  CHECK(1u == counters.nv_writes[2]);
+  CHECK(1u == counters.skipped);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark, one row per part and strategy
+static void bench_row(const char *part, const char *strategy, const Measured &m) {
+  printf("%-8s %-11s %-10s %-3s %4u %5u %3u %10.1f\n", HOSTSIM_VARIANT, part, strategy,
+    (m.ok) ? "ok" : "--", m.stats.transactions, m.stats.commands, m.stats.nv_writes,
+    (double)m.stats.bus_ns / 1000.0);
+}
+
+static void bench(void) {
+  printf("%-8s %-11s %-10s %-3s %4s %5s %3s %10s\n", "build", "part", "strategy", "", "txn", "cmds", "nv", "bus us");
+  for (size_t i = 0u; i < kProfileCount; i++) {
+    const char *name = kProfiles[i].name;
+    attach(name);
+    bench_row(name, "detect", measure(reclaim_once));
+
+    attach(name);
+    bench_row(name, "single", measure(single_vendor_for(name)));
+
+#if RECLAIM_GPIO_RECIPE_CACHE
+    attach(name);
+    reclaim_GPIO_9_10();
+    board_soft_restart();
+    bench_row(name, "replay", measure(reclaim_once));
+
+    attach(name);
+    reclaim_GPIO_9_10();
+    board_deep_sleep_wake();
+    bench_row(name, "fast", measure(reclaim_fast_once));
+#endif
+  }
+}
+
+int main(int argc, char **argv) {
+  bool show_bench = false;
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp(argv[i], "-v")) board_set_verbose(true);
+    if (0 == strcmp(argv[i], "-b")) show_bench = true;
+  }
+
+  test_cold_reclaim();
+  test_quad_mode();
+  test_xmc_sr3();
+  test_d8_reset();
+  test_eon();
+  test_wel_left_set();
+  test_bootrom_and_legacy();
+  test_stuck_busy();
+#if RECLAIM_GPIO_RECIPE_CACHE
+  test_recipe();
+#endif
+#if FLASH_SR_NV_COMMIT
+  test_nv_commit();
+#endif
+#if FLASH_SR_WEAR_GUARD
+  test_wear_guard();
+#endif
+
+  printf("[%s] %u checks, %u failed\n", HOSTSIM_VARIANT, checks, failures);
+  if (show_bench) bench();
+  return (failures) ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  HostSim shim - the parts of the ESP8266 Arduino core the library uses, for a
+  host build. Only enough to compile the library sources unchanged and run
+  them against the flash model, see ../README.md.
+*/
+#ifndef HOSTSIM_ARDUINO_H
+#define HOSTSIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+#include <algorithm>
+#endif
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+
+#define BIT0  0x00000001u
+#define BIT1  0x00000002u
+#define BIT2  0x00000004u
+#define BIT3  0x00000008u
+#define BIT4  0x00000010u
+#define BIT5  0x00000020u
+#define BIT6  0x00000040u
+#define BIT7  0x00000080u
+#define BIT8  0x00000100u
+#define BIT9  0x00000200u
+#define BIT10 0x00000400u
+#define BIT11 0x00000800u
+#define BIT12 0x00001000u
+#define BIT13 0x00002000u
+#define BIT14 0x00004000u
+#define BIT15 0x00008000u
+#define BIT16 0x00010000u
+#define BIT17 0x00020000u
+#define BIT18 0x00040000u
+#define BIT19 0x00080000u
+#define BIT20 0x00100000u
+#define BIT21 0x00200000u
+#define BIT22 0x00400000u
+#define BIT23 0x00800000u
+#define BIT24 0x01000000u
+#define BIT25 0x02000000u
+#define BIT26 0x04000000u
+#define BIT27 0x08000000u
+#define BIT28 0x10000000u
+#define BIT29 0x20000000u
+#define BIT30 0x40000000u
+#define BIT31 0x80000000u
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PROGMEM
+#define PSTR(s) (s)
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p) (*(const void * const *)(p))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+#define INPUT             0x00u
+#define INPUT_PULLUP      0x02u
+#define OUTPUT            0x01u
+#define OUTPUT_OPEN_DRAIN 0x03u
+#define SPECIAL           0xF8u
+
+#include "esp8266_peri.h"
+#include "spi_flash.h"
+#include "spi_utils.h"     // the core's Arduino.h has these two through Esp.h
+#include "spi_vendors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Simulated time, see HostShim.cpp
+uint32_t esp_get_cycle_count(void);
+void ets_delay_us(uint32_t us);
+unsigned long micros(void);
+unsigned long millis(void);
+void delay(unsigned long ms);
+void yield(void);
+
+// Interrupt level, there are no interrupts in the host build
+static inline uint32_t xt_rsil(const uint32_t level) { (void)level; return 0u; }
+static inline void xt_wsr_ps(const uint32_t ps) { (void)ps; }
+
+void pinMode(uint8_t pin, uint8_t mode);
+
+// BootROM print to UART0, also shown only with hostsim -v
+int ets_uart_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#ifdef __cplusplus
+}
+
+class __FlashStringHelper;
+
+// Output goes to stdout only with hostsim -v
+class Print {
+public:
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+  int printf_P(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+  size_t print(const char *s);
+  size_t println(const char *s = "");
+  size_t println(const __FlashStringHelper *s);
+};
+
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+};
+
+extern HardwareSerial Serial;
+#endif
+
+#endif // HOSTSIM_ARDUINO_H
@@ -0,0 +1,109 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  HostSim shim - SPI0 and GPIO registers
+
+  The SPI0 registers are plain words, except SPI0CMD. Setting SPICMDUSR runs
+  the user command described by SPI0U, SPI0U1, SPI0U2, and SPI0W0 on the flash
+  model, and the bit reads back clear at once. Names and bit positions follow
+  esp8266_peri.h of the core.
+*/
+#ifndef HOSTSIM_ESP8266_PERI_H
+#define HOSTSIM_ESP8266_PERI_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+struct HostSpi0Cmd {
+  HostSpi0Cmd &operator=(const uint32_t value);
+  operator uint32_t() const { return 0u; }
+};
+
+struct HostSpi0Regs {
+  HostSpi0Cmd cmd;
+  uint32_t ctrl;
+  uint32_t user;
+  uint32_t user1;
+  uint32_t user2;
+  uint32_t w[16];
+};
+extern HostSpi0Regs host_spi0;
+
+#define SPI0CMD host_spi0.cmd
+#define SPI0C   host_spi0.ctrl
+#define SPI0U   host_spi0.user
+#define SPI0U1  host_spi0.user1
+#define SPI0U2  host_spi0.user2
+#define SPI0W0  host_spi0.w[0]
+#endif
+
+// SPI0CMD
+#define SPICMDUSR     (1u << 18)
+
+// SPI0C
+#define SPICWPR       (1u << 21)
+#define SPICQIO       (1u << 24)
+#define SPICDIO       (1u << 23)
+#define SPIC2BSE      (1u << 22)
+#define SPICQOUT      (1u << 20)
+#define SPICSHARE     (1u << 19)
+#define SPICAHB       (1u << 17)
+#define SPICRESANDRES (1u << 15)
+#define SPICDOUT      (1u << 14)
+#define SPICFASTRD    (1u << 13)
+
+// SPI0U
+#define SPIUCOMMAND   (1u << 31)
+#define SPIUADDR      (1u << 30)
+#define SPIUDUMMY     (1u << 29)
+#define SPIUMISO      (1u << 28)
+#define SPIUMOSI      (1u << 27)
+#define SPIUCSSETUP   (1u << 5)
+
+// SPI0U1
+#define SPILMOSI      17
+#define SPILMISO      8
+#define SPIMMOSI      0x1FFu
+#define SPIMMISO      0x1FFu
+
+// SPI0U2
+#define SPILCOMMAND   28
+#define SPIMCOMMAND   0xFu
+
+#define WDT_FEED() do {} while (false)
+
+// GPIO, only stored
+extern volatile uint32_t host_gpio[8];
+extern volatile uint32_t host_gpc[17];
+extern volatile uint32_t host_gpf[17];
+#define GPO  host_gpio[0]
+#define GPOS host_gpio[1]
+#define GPOC host_gpio[2]
+#define GPE  host_gpio[3]
+#define GPES host_gpio[4]
+#define GPEC host_gpio[5]
+#define GPI  host_gpio[6]
+#define GPC(p) host_gpc[(p) & 0xF]
+#define GPF9  host_gpf[9]
+#define GPF10 host_gpf[10]
+#define GPCD  2
+#define GPCI  7
+#define GPFPU 7
+#define GPFFS(f) (((((f) & 4) != 0) << 8) | ((f) & 3) << 4)
+#define GPFFS_GPIO(p) (((p) == 0 || (p) == 2 || (p) == 4 || (p) == 5) ? 0 : ((p) == 16) ? 1 : 3)
+#define GPFFS_BUS(p) (((p) == 1 || (p) == 3) ? 0 : ((p) == 2 || (p) == 12 || (p) == 13 || (p) == 14 || (p) == 15) ? 2 : ((p) == 0) ? 4 : 1)
+
+#endif // HOSTSIM_ESP8266_PERI_H
@@ -0,0 +1,35 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  HostSim shim - core esp8266_undocumented.h, BootROM functions
+*/
+#ifndef HOSTSIM_ESP8266_UNDOCUMENTED_H
+#define HOSTSIM_ESP8266_UNDOCUMENTED_H
+
+#include "spi_flash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Reads Status Register-1 until WIP clears
+uint32_t Wait_SPI_Idle(SpiFlashChip *fc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_ESP8266_UNDOCUMENTED_H
@@ -0,0 +1,46 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  HostSim shim - core spi_utils.h
+*/
+#ifndef HOSTSIM_SPI_UTILS_H
+#define HOSTSIM_SPI_UTILS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+typedef enum {
+  SPI_RESULT_OK,
+  SPI_RESULT_ERR,
+  SPI_RESULT_TIMEOUT
+} SpiOpResult;
+
+// Same arguments as the core. One transaction: a wait for idle, pre_cmd when
+// not 0, then cmd with mosi_bits from data and miso_bits read back into data.
+SpiOpResult SPI0Command(uint8_t cmd, uint32_t *data, uint32_t mosi_bits, uint32_t miso_bits, uint32_t pre_cmd = 0u);
+
+};  // namespace experimental {
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_SPI_UTILS_H
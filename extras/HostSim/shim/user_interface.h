@@ -0,0 +1,58 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  HostSim shim - NONOS SDK user_interface.h
+*/
+#ifndef HOSTSIM_USER_INTERFACE_H
+#define HOSTSIM_USER_INTERFACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum rst_reason {
+  REASON_DEFAULT_RST = 0,
+  REASON_WDT_RST = 1,
+  REASON_EXCEPTION_RST = 2,
+  REASON_SOFT_WDT_RST = 3,
+  REASON_SOFT_RESTART = 4,
+  REASON_DEEP_SLEEP_AWAKE = 5,
+  REASON_EXT_SYS_RST = 6
+};
+
+struct rst_info {
+  uint32_t reason;
+  uint32_t exccause;
+  uint32_t epc1;
+  uint32_t epc2;
+  uint32_t epc3;
+  uint32_t excvaddr;
+  uint32_t depc;
+};
+
+struct rst_info *system_get_rst_info(void);
+bool system_rtc_mem_read(uint8_t src_addr, void *des_addr, uint16_t load_size);
+bool system_rtc_mem_write(uint8_t des_addr, const void *src_addr, uint16_t save_size);
+void system_soft_wdt_feed(void);
+uint8_t system_get_cpu_freq(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_USER_INTERFACE_H
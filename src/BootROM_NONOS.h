@@ -97,6 +97,22 @@ int Disable_QMode(SpiFlashChip *chip);
 // Disables iCache. Use Cache_Read_Enable_New to turn back on.
 void Cache_Read_Disable();
 
+/*
+  BootROM replacements for SDK calls, used by the RECLAIM_GPIO_EARLY == 2 path.
+
+  ets_get_cpu_frequency - CPU MHz as last set with ets_update_cpu_frequency().
+  The SDK keeps it current; before that, it is the BootROM value.
+
+  rtc_get_reset_reason - the hardware reset cause, not the SDK's rst_info
+  reason. 1 is power-on. The SDK derives REASON_* from this plus notes it keeps
+  in RTC system memory.
+*/
+uint32_t ets_get_cpu_frequency(void);
+uint32_t rtc_get_reset_reason(void);
+enum {
+  kRomResetPowerOn = 1u
+};
+
 // NONOS_SDK
 bool spi_flash_issi_enable_QIO_mode();
 bool flash_gd25q32c_enable_QIO_mode();
@@ -0,0 +1,163 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Device Fingerprint - see DeviceFingerprint.h
+*/
+#include <Arduino.h>
+#include <spi_vendors.h>
+#include "SpiFlashUtils.h"    // sfu_rtc_mem_read()
+#include "SfdpRevInfo.h"
+#include "FlashChipId_D8.h"
+#include "DeviceFingerprint.h"
+
+extern "C" {
+
+namespace experimental {
+
+constexpr uint32_t kFingerprintMagic = 0x46500910u;  // "FP" 09 10
+constexpr uint64_t kFnvOffset = 0xCBF29CE484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001B3ull;
+
+union FingerprintRtc {
+  struct {
+    uint32_t key_lo;
+    uint32_t key_hi;
+    uint32_t id:24;             // Flash ID the key was built from
+    uint32_t source:8;          // UniqueIdSource used to build the key
+    uint32_t chksum;
+  };
+  uint32_t u32[4];
+};
+
+static uint64_t fingerprint_cache = 0u;
+static bool fingerprint_cached = false;
+static UniqueIdSource fingerprint_source = kUniqueIdNone;
+
+static uint64_t fnv1a(uint64_t hash, const void *p, const size_t sz) {
+  const uint8_t *b = (const uint8_t *)p;
+  for (size_t i = 0u; i < sz; i++) {
+    hash = (hash ^ b[i]) * kFnvPrime;
+  }
+  return hash;
+}
+
+static uint32_t rtc_chksum(const FingerprintRtc *rtc) {
+  uint32_t sum = kFingerprintMagic;
+  for (size_t i = 0u; i < 3u; i++) {
+    sum = ((sum << 5u) | (sum >> 27u)) ^ rtc->u32[i];
+  }
+  return sum;
+}
+
+UniqueIdSource device_unique_id(const uint32_t id, uint32_t *uid, size_t *sz) {
+  *sz = 0u;
+  const uint32_t vendor = id & 0xFFu;
+  if (SPI_FLASH_VENDOR_EON == vendor) {
+    if (SPI_RESULT_OK != spi0_flash_read_sfdp(0x80u, uid, 12u)) return kUniqueIdNone;
+    *sz = 12u;
+    return kUniqueIdSfdp80h96;
+  }
+  if (kMysteryId_D8 == vendor) {
+    if (SPI_RESULT_OK != spi0_flash_read_unique_id_64(uid)) return kUniqueIdNone;
+    *sz = 8u;
+    return kUniqueId4Bh64;
+  }
+  if (SPI_RESULT_OK != spi0_flash_read_unique_id_128(uid)) return kUniqueIdNone;
+  if (0xFFFFFFFFu == uid[2] && 0xFFFFFFFFu == uid[3]) {
+    *sz = 8u;
+    return kUniqueId4Bh64;
+  }
+  *sz = 16u;
+  return kUniqueId4Bh128;
+}
+
+uint64_t device_fingerprint_compute(void) {
+  const uint32_t id = spi_flash_get_id() & 0xFFFFFFu;
+  const SfdpRevInfo rev = get_sfdp_revision();
+  // Only the revision fields, the table pointer and size are implied by them
+  const uint32_t rev_u32 = rev.u32[0];
+
+  uint32_t uid[4] = {0u, 0u, 0u, 0u};
+  size_t sz = 0u;
+  fingerprint_source = device_unique_id(id, uid, &sz);
+
+  uint64_t hash = fnv1a(kFnvOffset, &id, 3u);
+  hash = fnv1a(hash, &rev_u32, sizeof(rev_u32));
+  if (kUniqueIdNone != fingerprint_source) hash = fnv1a(hash, uid, sz);
+
+  fingerprint_cache = hash;
+  fingerprint_cached = true;
+
+  FingerprintRtc rtc;
+  rtc.key_lo = (uint32_t)hash;
+  rtc.key_hi = (uint32_t)(hash >> 32u);
+  rtc.id = id;
+  rtc.source = fingerprint_source;
+  rtc.chksum = rtc_chksum(&rtc);
+  sfu_rtc_mem_write(DEVICE_FINGERPRINT_RTC_BLOCK, &rtc.u32[0], sizeof(rtc));
+  return hash;
+}
+
+uint64_t device_fingerprint(void) {
+  if (fingerprint_cached) return fingerprint_cache;
+
+  FingerprintRtc rtc;
+  if (sfu_rtc_mem_read(DEVICE_FINGERPRINT_RTC_BLOCK, &rtc.u32[0], sizeof(rtc)) &&
+      rtc_chksum(&rtc) == rtc.chksum &&
+      // The flash may have been swapped without a power cycle, like on a socket
+      (spi_flash_get_id() & 0xFFFFFFu) == rtc.id) {
+    fingerprint_cache = ((uint64_t)rtc.key_hi << 32u) | rtc.key_lo;
+    fingerprint_cached = true;
+    fingerprint_source = (UniqueIdSource)rtc.source;
+    return fingerprint_cache;
+  }
+  return device_fingerprint_compute();
+}
+
+UniqueIdSource device_fingerprint_source(void) {
+  return fingerprint_source;
+}
+
+void device_fingerprint_invalidate(void) {
+  FingerprintRtc rtc;
+  memset(&rtc.u32[0], 0, sizeof(rtc));
+  sfu_rtc_mem_write(DEVICE_FINGERPRINT_RTC_BLOCK, &rtc.u32[0], sizeof(rtc));
+  fingerprint_cached = false;
+}
+
+const DeviceFingerprintEntry *device_fingerprint_lookup(const DeviceFingerprintEntry *table, const size_t n, const uint64_t key) {
+  const uint32_t hi = (uint32_t)(key >> 32u);
+  const uint32_t lo = (uint32_t)key;
+  size_t first = 0u;
+  size_t last = n;
+  while (first < last) {
+    const size_t mid = first + (last - first) / 2u;
+    // pgm_read_dword works for both DRAM and PROGMEM tables
+    const uint32_t mid_hi = pgm_read_dword(&table[mid].key_hi);
+    const uint32_t mid_lo = pgm_read_dword(&table[mid].key_lo);
+    if (mid_hi == hi && mid_lo == lo) return &table[mid];
+    if (mid_hi < hi || (mid_hi == hi && mid_lo < lo)) {
+      first = mid + 1u;
+    } else {
+      last = mid;
+    }
+  }
+  return NULL;
+}
+
+};  // namespace experimental {
+
+};
@@ -0,0 +1,83 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Device Fingerprint - one 64-bit key for this flash chip.
+
+  Folds the JEDEC ID, the SFDP header and 1ST parameter table revisions, and
+  the chip's unique ID into a 64-bit FNV-1a hash. The unique ID source depends
+  on the part:
+   * EON (0x1C) - 96 bits in the SFDP space at 80h, 4Bh is a Fast Read opcode.
+   * Mystery vendor 0xD8 - only the first 64 bits from 4Bh are programmed.
+   * Others - 128 bits from 4Bh. When the upper 64 bits are all 0xFF, only the
+     lower 64 are used.
+
+  The first call reads the flash with a few SPI0 transactions. The result is
+  kept in RAM and in RTC user memory. Later calls read no flash; at a warm
+  boot only the Flash ID is read, and the key is rebuilt when it no longer
+  matches. After a power cycle the RTC checksum fails and the key is rebuilt.
+
+  `device_fingerprint_lookup()` does a binary search of a table sorted by key.
+  The table may be in PROGMEM.
+*/
+#ifndef EXPERIMENTAL_DEVICE_FINGERPRINT_H
+#define EXPERIMENTAL_DEVICE_FINGERPRINT_H
+
+// RTC user memory blocks 175 - 178, `ESP.rtcUserMemory` offset 111 - 114. Just
+// below the FlashDiscovery record.
+#ifndef DEVICE_FINGERPRINT_RTC_BLOCK
+#define DEVICE_FINGERPRINT_RTC_BLOCK 175u
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+enum UniqueIdSource : uint8_t {
+  kUniqueIdNone = 0u,
+  kUniqueId4Bh64,
+  kUniqueId4Bh128,
+  kUniqueIdSfdp80h96
+};
+
+struct DeviceFingerprintEntry {
+  uint32_t key_lo;              // Split so the table packs to 4-byte alignment
+  uint32_t key_hi;
+  uint32_t value;               // Caller defined, for example an index
+};
+
+uint64_t device_fingerprint(void);
+// Reads the flash and refreshes the cache
+uint64_t device_fingerprint_compute(void);
+// Source of the unique ID the current key was built from
+UniqueIdSource device_fingerprint_source(void);
+void device_fingerprint_invalidate(void);
+
+// The unique ID from the source for this Flash ID, see above. uid holds 16
+// bytes; sz is set to the bytes read, 0 with kUniqueIdNone.
+UniqueIdSource device_unique_id(const uint32_t id, uint32_t *uid, size_t *sz);
+
+// table must be sorted by key_hi, then key_lo. Returns NULL when not found.
+const DeviceFingerprintEntry *device_fingerprint_lookup(const DeviceFingerprintEntry *table, const size_t n, const uint64_t key);
+
+};  // namespace experimental {
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPERIMENTAL_DEVICE_FINGERPRINT_H
@@ -0,0 +1,182 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Flash Part Table - see FlashPartTable.h
+*/
+#include <Arduino.h>
+#include "ModeDIO_ReclaimGPIOs.h"
+#include "SfdpRevInfo.h"
+#include "FlashPartTable.h"
+#include "FlashStrategy.h"
+
+#if !defined(SPI_FLASH_VENDOR_MYSTERY_D8)
+#include "FlashChipId_D8.h"
+#endif
+
+extern "C" {
+
+namespace experimental {
+
+#define ID16(type, vendor) (((type) << 8u) | (vendor))
+
+// Keep sorted by type, then vendor. A static_assert below checks it.
+constexpr uint32_t flash_parts[] PROGMEM = {
+  // XMC (0x20) - Special handling for XMC anomaly where driver strength value
+  // is lost when switching from non-volatile to volatile.
+  // Status: tested, sealed in ESP-12F module
+  // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
+  flash_part(ID16(0x40u, SPI_FLASH_VENDOR_XMC), 9u, 16u, volatile_bit, kRecipeFixupXmcSR3),
+
+  // GigaDevice (0xC8) - Based on my read of the GigaDevice datasheet
+  // Only supports 8-bit status register writes just like "Mystery Vendor"
+  // Status: no hardware testing
+  // For this part, non-volatile could be used w/o concern of write fatgue.
+  // volatile_bit is safe and faster write time.
+  flash_part(ID16(0x40u, SPI_FLASH_VENDOR_GIGADEVICE), 9u, 8u, volatile_bit),
+
+  // "Mystery Vendor" (0xD8) 25Q32ET, an obfuscated GigaDevice part?
+  // The SFDP table says the MFG is 0xC8
+  // Status: tested, sealed in ESP-12F module
+  // SFDP Revision: 1.06, 1ST Parameter Table Revision: 1.06
+  // Only supports 8-bit status register writes.
+  flash_part(ID16(0x40u, SPI_FLASH_VENDOR_MYSTERY_D8), 9u, 8u, volatile_bit),
+
+  // BergMicro (0xE0) BN25F08 with an XTX logo mark
+  // Status: hardware tested
+  // SFDP none
+  flash_part(ID16(0x40u, SPI_FLASH_VENDOR_BERGMICRO), 9u, 16u, volatile_bit),
+
+  // Winbond (0xEF) 25Q32FVSIG
+  // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
+  // 16-bit status register writes is what the ESP8266 BootROM is expecting.
+  flash_part(ID16(0x40u, SPI_FLASH_VENDOR_WINBOND_NEX), 9u, 16u, volatile_bit),
+
+  // Zbit (0x5E) 25VQ80AT
+  // Status: tested
+  // SFDP Revision: 1.06, 1ST Parameter Table Revision: 1.06
+  // I have two parts with Zbit vendor ID that are not compatible
+  flash_part(ID16(0x60u, SPI_FLASH_VENDOR_ZBIT), 9u, 16u, volatile_bit),
+
+  // Puya (0x85) P25Q80H
+  // Status: tested
+  // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
+  flash_part(ID16(0x60u, SPI_FLASH_VENDOR_PUYA), 9u, 16u, volatile_bit),
+
+#if 0
+  // Not tested, block for now
+  // These are two QE/S6 Flash vendors the NONOS_SDK checks for.
+  // ISSI (0x9D) confusable with PMC, does not support volatile, type 0x40 or 0x70
+  // Macronix (0xC2) type 0x20
+  // EON (0x1C) EN25Q32C type 0x30, WPDis S6 bit, see OutlineEON
+#endif
+};
+
+#undef ID16
+
+constexpr size_t kFlashPartCount = sizeof(flash_parts) / sizeof(flash_parts[0]);
+
+constexpr bool flash_parts_sorted() {
+  for (size_t i = 1u; i < kFlashPartCount; i++) {
+    if (flash_parts[i - 1u] >= flash_parts[i]) return false;
+  }
+  return true;
+}
+static_assert(flash_parts_sorted(), "flash_parts[] must be sorted for binary search");
+
+size_t flash_part_count(void) {
+  return kFlashPartCount;
+}
+
+FlashPartRecord flash_part_get(const size_t idx) {
+  FlashPartRecord rec;
+  rec.u32 = (idx < kFlashPartCount) ? pgm_read_dword(&flash_parts[idx]) : 0u;
+  return rec;
+}
+
+bool flash_part_lookup(const uint32_t _id, FlashPartRecord *rec) {
+  const uint32_t key = (_id & 0xFFFFu) << 16u;
+  // Lower bound of the first record with this ID
+  size_t first = 0u;
+  size_t last = kFlashPartCount;
+  while (first < last) {
+    const size_t mid = first + (last - first) / 2u;
+    if (pgm_read_dword(&flash_parts[mid]) < key) {
+      first = mid + 1u;
+    } else {
+      last = mid;
+    }
+  }
+
+  bool found = false;
+  bool have_rev = false;
+  uint32_t rev = 0u;
+  for (size_t i = first; i < kFlashPartCount; i++) {
+    FlashPartRecord r;
+    r.u32 = pgm_read_dword(&flash_parts[i]);
+    if ((r.u32 & 0xFFFF0000u) != key) break;
+    if (0u == r.sfdp_rev) {
+      // Wildcard, keep looking for an exact revision
+      *rec = r;
+      found = true;
+      continue;
+    }
+    if (! have_rev) {
+      const SfdpRevInfo info = get_sfdp_revision();
+      rev = (info.parm_major << 4u) | (info.parm_minor & 0xFu);
+      have_rev = true;
+    }
+    if (r.sfdp_rev == rev) {
+      *rec = r;
+      return true;
+    }
+  }
+  return found;
+}
+
+bool flash_part_apply(const FlashPartRecord *rec) {
+  const bool non_volatile = (0u != rec->non_volatile);
+  if (9u == rec->qe_pos) {
+    if (rec->wide16) {
+      if (kRecipeFixupXmcSR3 & rec->fixup) {
+        return set_S9_QE_bit__16_bit_sr1_write__xmc_sr3();
+      }
+      return set_S9_QE_bit__16_bit_sr1_write(non_volatile);
+    }
+    return set_S9_QE_bit__8_bit_sr2_write(non_volatile);
+  }
+  if (6u == rec->qe_pos) {
+    return set_S6_QE_bit__8_bit_sr1_write(non_volatile);
+  }
+  return false;
+}
+
+// The record found by the match is carried to the apply in scratch
+bool flash_part_strategy_match(FlashMatchInfo *info) {
+  FlashPartRecord rec;
+  if (! flash_part_lookup(info->id, &rec)) return false;
+  info->scratch = rec.u32;
+  return true;
+}
+
+bool flash_part_strategy_apply(FlashMatchInfo *info) {
+  FlashPartRecord rec;
+  rec.u32 = info->scratch;
+  return flash_part_apply(&rec);
+}
+
+};  // namespace experimental {
+
+};
@@ -0,0 +1,70 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Flash Part Table - the builtin flash parts as packed records in PROGMEM.
+
+  Each record is one 32-bit word. The table is sorted by value, which sorts by
+  Flash ID type and vendor bytes, then SFDP revision, so a lookup is a binary
+  search. `__spi_flash_vendor_cases()` and the Analyze reports share
+  `flash_part_lookup()`.
+
+  A record with `sfdp_rev` 0 matches any SFDP revision, including none. When a
+  part needs different handling by revision, add records with the 1ST
+  parameter table revision `(major << 4) | minor`. The SFDP header is only read
+  when the ID matches a record with a revision.
+*/
+#ifndef EXPERIMENTAL_FLASH_PART_TABLE_H
+#define EXPERIMENTAL_FLASH_PART_TABLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+union FlashPartRecord {
+  struct {
+    uint32_t qe_pos:4;          // 9 or 6, 0 for no QE write
+    uint32_t wide16:1;          // 1 - 16-bit write to SR1, 0 - 8-bit write
+    uint32_t non_volatile:1;    // non_volatile_bit or volatile_bit
+    uint32_t fixup:2;           // kRecipeFixup... bits
+    uint32_t sfdp_rev:8;        // 1ST parameter table revision, 0 for any
+    uint32_t id16:16;           // (type << 8) | vendor, from spi_flash_get_id()
+  };
+  uint32_t u32;
+};
+
+constexpr uint32_t flash_part(const uint32_t id16, const uint32_t qe_pos, const uint32_t numbits,
+  const bool non_volatile, const uint32_t fixup = 0u, const uint32_t sfdp_rev = 0u) {
+  return (id16 << 16u) | (sfdp_rev << 8u) | (fixup << 6u) | ((non_volatile) ? BIT5 : 0u) |
+    ((16u == numbits) ? BIT4 : 0u) | (qe_pos & 0xFu);
+}
+
+// False when the Flash ID is not in the table
+bool flash_part_lookup(const uint32_t _id, FlashPartRecord *rec);
+// Run the set_S9_QE_bit__*()/set_S6_QE_bit__*() function for the record
+bool flash_part_apply(const FlashPartRecord *rec);
+
+size_t flash_part_count(void);
+FlashPartRecord flash_part_get(const size_t idx);
+
+};  // namespace experimental {
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPERIMENTAL_FLASH_PART_TABLE_H
@@ -0,0 +1,84 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Flash Strategy - see FlashStrategy.h
+*/
+#include <Arduino.h>
+#include "SpiFlashUtils.h"    // DBG_SFU_PRINTF, SFU_EVENT
+#include "FlashStrategy.h"
+
+extern "C" {
+
+namespace experimental {
+
+const SfdpRevInfo& flash_match_sfdp(FlashMatchInfo *info) {
+  if (! info->have_sfdp) {
+    info->sfdp = get_sfdp_revision();
+    info->have_sfdp = true;
+  }
+  return info->sfdp;
+}
+
+size_t flash_strategy_find(FlashMatchInfo *info) {
+  size_t count = 0u;
+  const FlashStrategy *list = spi_flash_vendor_strategies(&count);
+  if (nullptr == list) return SIZE_MAX;
+
+  for (size_t i = 0u; i < count; i++) {
+    FlashStrategy s;
+    memcpy_P(&s, &list[i], sizeof(FlashStrategy));
+    if (s.match && s.match(info)) return i;
+  }
+  return SIZE_MAX;
+}
+
+bool flash_strategy_apply(const size_t index, FlashMatchInfo *info) {
+  size_t count = 0u;
+  const FlashStrategy *list = spi_flash_vendor_strategies(&count);
+  if (nullptr == list || count <= index) return false;
+
+  FlashStrategy s;
+  memcpy_P(&s, &list[index], sizeof(FlashStrategy));
+  const bool success = (s.apply) ? s.apply(info) : false;
+  DBG_SFU_PRINTF("  Vendor strategy %u, rank %u: %s\n", (uint32_t)index, s.rank, (success) ? "applied" : "failed");
+  SFU_EVENT(kSfuEvtStrategy, index, (success) ? 1u : 0u);
+  return success;
+}
+
+bool flash_strategy_dispatch(const uint32_t _id) {
+  FlashMatchInfo info;
+  memset(&info, 0, sizeof(info));
+  info.id = _id;
+  const size_t index = flash_strategy_find(&info);
+  if (SIZE_MAX == index) return false;
+  return flash_strategy_apply(index, &info);
+}
+
+// Default list, the builtin part table only
+constexpr FlashStrategy builtin_strategies[] PROGMEM = {
+  flash_strategy_builtin()
+};
+
+};  // namespace experimental {
+
+const experimental::FlashStrategy *__spi_flash_vendor_strategies(size_t *count) {
+  *count = sizeof(experimental::builtin_strategies) / sizeof(experimental::builtin_strategies[0]);
+  return experimental::builtin_strategies;
+}
+
+const experimental::FlashStrategy *spi_flash_vendor_strategies(size_t *count) __attribute__ ((weak, alias("__spi_flash_vendor_strategies")));
+
+};
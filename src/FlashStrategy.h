@@ -0,0 +1,140 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Flash Strategy - composable vendor cases for reclaim_GPIO_9_10()
+
+  A strategy is a match predicate and an apply function. The list is one
+  constexpr array in PROGMEM, ordered by rank, most specific first. One pass
+  runs the first strategy that matches; its apply result is the result. A
+  failed apply does not fall through to a less specific strategy, which
+  could pick the wrong QE bit method for the part.
+
+  A sketch adds parts with its own list and the `SPI_FLASH_VENDOR_STRATEGIES()`
+  macro, in place of a copy of the `spi_flash_vendor_cases()` dispatcher:
+
+    static bool xmc_b_match(FlashMatchInfo *info);
+    static bool xmc_b_apply(FlashMatchInfo *info);
+
+    constexpr FlashStrategy my_strategies[] PROGMEM = {
+      {kFlashRankSfdp, xmc_b_match, xmc_b_apply},
+      flash_strategy_builtin()
+    };
+    SPI_FLASH_VENDOR_STRATEGIES(my_strategies);
+
+  A `static_assert` checks the rank order. Leave out
+  `flash_strategy_builtin()` and the builtin part table is dropped by the
+  linker. Without a sketch list, the default list is the builtin table.
+
+  The list runs from `__spi_flash_vendor_cases()`, after the SFDP DW15 cases,
+  so every caller of `reclaim_GPIO_9_10()` or `reclaim_GPIO_9_10_async()`
+  sees it. A custom `spi_flash_vendor_cases()` still replaces the whole
+  dispatch.
+
+  Match and apply run with the same restrictions as `spi_flash_vendor_cases()`;
+  they may be called from `preinit()`.
+*/
+#ifndef EXPERIMENTAL_FLASH_STRATEGY_H
+#define EXPERIMENTAL_FLASH_STRATEGY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SfdpRevInfo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+// Higher is more specific. A list must not increase.
+enum FlashStrategyRank : uint32_t {
+  kFlashRankFallback = 0u,      // Catch-all, the builtin table
+  kFlashRankVendor   = 1u,      // Vendor byte of the Flash ID
+  kFlashRankId16     = 2u,      // Type and vendor bytes
+  kFlashRankSfdp     = 3u       // Flash ID and SFDP details
+};
+
+// One per dispatch pass, shared by the match calls and the apply call
+struct FlashMatchInfo {
+  uint32_t id;                  // 0xCCTTVV from spi_flash_get_id()
+  uint32_t scratch;             // Free for a match to hand to its apply
+  SfdpRevInfo sfdp;             // Valid after flash_match_sfdp()
+  bool have_sfdp;
+};
+
+typedef bool (*FlashMatchFn)(FlashMatchInfo *info);
+typedef bool (*FlashApplyFn)(FlashMatchInfo *info);
+
+struct FlashStrategy {
+  uint32_t rank;                // FlashStrategyRank
+  FlashMatchFn match;
+  FlashApplyFn apply;
+};
+
+// (type << 8) | vendor
+inline uint32_t flash_match_id16(const FlashMatchInfo *info) {
+  return info->id & 0xFFFFu;
+}
+
+// SFDP revision, read at most once per pass
+const SfdpRevInfo& flash_match_sfdp(FlashMatchInfo *info);
+
+// The builtin table from FlashPartTable.cpp as one strategy
+bool flash_part_strategy_match(FlashMatchInfo *info);
+bool flash_part_strategy_apply(FlashMatchInfo *info);
+
+constexpr FlashStrategy flash_strategy_builtin() {
+  return {kFlashRankFallback, flash_part_strategy_match, flash_part_strategy_apply};
+}
+
+// First match wins. False when nothing matched or the apply failed.
+bool flash_strategy_dispatch(const uint32_t _id);
+
+// flash_strategy_dispatch() in two parts, for reclaim_GPIO_9_10_async(). Set
+// info->id and clear the rest first. find returns the list index of the first
+// match, or SIZE_MAX when nothing matched.
+size_t flash_strategy_find(FlashMatchInfo *info);
+bool flash_strategy_apply(const size_t index, FlashMatchInfo *info);
+
+};  // namespace experimental {
+
+// weak - a sketch list from SPI_FLASH_VENDOR_STRATEGIES() replaces it
+const experimental::FlashStrategy *spi_flash_vendor_strategies(size_t *count);
+
+#ifdef __cplusplus
+}
+
+namespace experimental {
+
+template <size_t N>
+constexpr bool flash_strategies_ordered(const FlashStrategy (&list)[N]) {
+  for (size_t i = 1u; i < N; i++) {
+    if (list[i - 1u].rank < list[i].rank) return false;
+  }
+  return true;
+}
+
+};  // namespace experimental {
+#endif
+
+#define SPI_FLASH_VENDOR_STRATEGIES(list) \
+  static_assert(experimental::flash_strategies_ordered(list), #list " must be ordered most specific rank first"); \
+  extern "C" const experimental::FlashStrategy *spi_flash_vendor_strategies(size_t *count) { \
+    *count = sizeof(list) / sizeof(list[0]); \
+    return list; \
+  }
+
+#endif // EXPERIMENTAL_FLASH_STRATEGY_H
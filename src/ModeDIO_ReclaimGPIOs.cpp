@@ -121,11 +121,41 @@ EON
 */
 #include <Arduino.h>
 #include "ModeDIO_ReclaimGPIOs.h"
+#include "SfdpRevInfo.h"
+#include "FlashStrategy.h"
 
 #if !defined(SPI_FLASH_VENDOR_MYSTERY_D8)
 #include "FlashChipId_D8.h"
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+// Special handling for XMC anomaly where driver strength value is lost when
+// switching from non-volatile to volatile.
+bool set_S9_QE_bit__16_bit_sr1_write__xmc_sr3(void) {
+  using namespace experimental;
+
+  // Backup Status Register-3
+  uint32_t status3 = 0u;
+  SpiOpResult ok0 = spi0_flash_read_status_register_3(&status3);
+  // bool success = set_S9_QE_bit__8_bit_sr2_write(volatile_bit);
+  bool success = set_S9_QE_bit__16_bit_sr1_write(volatile_bit);
+  if (SPI_RESULT_OK == ok0) {
+    uint32_t newSR3 = 0u;
+    spi0_flash_read_status_register_3(&newSR3);
+    if (status3 != newSR3) {
+      // Copy Driver Strength value from non-volatile to volatile
+      ok0 = spi0_flash_write_status_register_3(status3, volatile_bit);
+      reclaim_recipe_note_fixup(kRecipeFixupXmcSR3, status3);
+      DBG_SFU_PRINTF("  XMC Anomaly: Copy Driver Strength values to volatile status register.\n");
+      SFU_EVENT(kSfuEvtXmcFixup, (SPI_RESULT_OK == ok0) ? 1u : 0u, status3);
+      if (SPI_RESULT_OK != ok0) {
+        DBG_SFU_PRINTF("* anomaly handling failed.\n");
+      }
+    }
+  }
+  return success;
+}
+
 /*//////////////////////////////////////////////////////////////////////////////
   To have a larger pool of Flash vendors to test against, I tested with devices
   that did not expose GPIO9 and GPIO10. These did not work well. Let us hope
@@ -151,178 +181,116 @@ bool __spi_flash_vendor_cases(const uint32_t _id) {
   "Parameter ID" that maps to "Bank Number":"Manufacturer ID". I do not have any
   devices that provide this.
 
+  The builtin parts, with their test notes, are in FlashPartTable.cpp. A
+  sketch list from SPI_FLASH_VENDOR_STRATEGIES() runs ahead of them, see
+  FlashStrategy.h.
   */
-  uint32_t vendor = 0xFFu & _id;
-  uint32_t type = (_id >> 8u) & 0xFFu;
-
-  switch (vendor) {
-    case SPI_FLASH_VENDOR_BERGMICRO:
-      // Status: hardware tested
-      // Logo XTX BN25F08
-      // SFDP none
-
-      // I have a Sonoff SV with flash part BN25F08 with an XTX logo mark
-      // the JEDEC MFG ID matches BergMicro as does the part number.
-    case SPI_FLASH_VENDOR_WINBOND_NEX:
-      // Winbond 25Q32FVSIG
-      // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
-      // SFDP Table Ptr: 0x80, Size: 36 Bytes
-      if (0x40u == type) {
-        // 16-bit status register writes is what the ESP8266 BootROM is
-        // expecting the flash to support. "Legacy method" is what I often see
-        // used to descibe the 16-bit status register-1 writes in newer SPI
-        // Flash datasheets. I expect this to work with modules that are
-        // compatibile with SPI Flash Mode: "QIO" or "QOUT".
-        success = set_S9_QE_bit__16_bit_sr1_write(volatile_bit);
-      }
-      break;
+  success = flash_strategy_dispatch(_id);
 
-    case SPI_FLASH_VENDOR_PUYA:
-      // Status: tested
-      // Puya P25Q80H
-      // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
-      // SFDP Table Ptr: 0x30, Size: 36 Bytes
-    case SPI_FLASH_VENDOR_ZBIT:
-      // Status: tested
-      // Zbit 25VQ80AT
-      // SFDP Revision: 1.06, 1ST Parameter Table Revision: 1.06
-      // SFDP Table Ptr: 0x30, Size: 64 Bytes
-      if (0x60u == type) {
-        success = set_S9_QE_bit__16_bit_sr1_write(volatile_bit);
-      }
-      // I have two parts with Zbit vendor ID that are not compatible
-      // TODO - recheck datasheet for device values for 4MB part
-      break;
+  if (! success) {
+    DBG_SFU_PRINTF("* No builtin flash QE bit handler.\n");
+    SFU_EVENT(kSfuEvtNoHandler, 0u, _id);
+  }
+  return success;
+}
 
-    case SPI_FLASH_VENDOR_MYSTERY_D8: // 0xD8
-      // "Mystery Vendor" - an obfuscated GigaDevice part?
-      // The SFDP table says the MFG is 0xC8
-      //
-      // Status: tested, sealed in ESP-12F module
-      // "Mystery Vendor" 25Q32ET, No logo
-      // SFDP Revision: 1.06, 1ST Parameter Table Revision: 1.06
-      // SFDP Table Ptr: 0x30, Size: 64 Bytes
-    case SPI_FLASH_VENDOR_GIGADEVICE: // 0xC8
-      // Based on my read of the GigaDevice datasheet
-      // Only supports 8-bit status register writes just like "Mystery Vendor"
-      // Status: no hardware testing
-      if (0x40u == type) {
-        success = set_S9_QE_bit__8_bit_sr2_write(volatile_bit);
-      }
-      // For this part, non-volatile could be used w/o concern of write fatgue.
-      // Once non-volatile set, no attempts by the BootROM or SDK to change will
-      // work. 16-bit Status Register-1 writes will always fail.
-      // volatile_bit is safe and faster write time.
-      break;
+bool spi_flash_vendor_cases(uint32_t _id) __attribute__ ((weak, alias("__spi_flash_vendor_cases")));
 
-    case SPI_FLASH_VENDOR_XMC: // 0x20
-      // Special handling for XMC anomaly where driver strength value is lost
-      // when switching from non-volatile to volatile.
-      // Status: tested, sealed in ESP-12F module
-      // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
-      // SFDP Table Ptr: 0x30, Size: 36 Bytes
-      if (0x40u == type) {
-        // Backup Status Register-3
-        uint32_t status3 = 0u;
-        SpiOpResult ok0 = spi0_flash_read_status_register_3(&status3);
-        // success = set_S9_QE_bit__8_bit_sr2_write(volatile_bit);
-        success = set_S9_QE_bit__16_bit_sr1_write(volatile_bit);
-        if (SPI_RESULT_OK == ok0) {
-          uint32_t newSR3 = 0u;
-          spi0_flash_read_status_register_3(&newSR3);
-          if (status3 != newSR3) {
-            // Copy Driver Strength value from non-volatile to volatile
-            ok0 = spi0_flash_write_status_register_3(status3, volatile_bit);
-            DBG_SFU_PRINTF("  XMC Anomaly: Copy Driver Strength values to volatile status register.\n");
-            if (SPI_RESULT_OK != ok0) {
-              DBG_SFU_PRINTF("* anomaly handling failed.\n");
-            }
-          }
-        }
-      }
-      break;
+////////////////////////////////////////////////////////////////////////////////
+// SFDP DW15 Quad Enable Requirements - JESD216A and up
+//
+// Only volatile Status Register writes are used. A part that only describes a
+// non-volatile Status Register is left to the vendor table, which knows when
+// wear is not a concern.
+bool spi_flash_sfdp_read(experimental::SfdpDescriptor *desc) {
+  using namespace experimental;
 
-#if 0
-    // Not tested, block for now
-    // These are two QE/S6 Flash vendors the NONOS_SDK checks for.
-    // Tests are based on RTOS_SDK code
-    //   https://github.com/espressif/esp-idf/blob/bdb9f972c6a1f1c5ca50b1be2e7211ec7c24e881/components/bootloader_support/bootloader_flash/src/flash_qio_mode.c#L37-L54
-    case SPI_FLASH_VENDOR_ISSI_2:     // 0x9D (confusable with PMC) - Does not support volatile
-      if (0x40u == (0xCFu & type)) {
-        // Status: no hardware testing
-        success = set_S6_QE_bit__8_bit_sr1_write(non_volatile_bit);
-      }
-      break;
+  if (! get_sfdp_descriptor(desc)) {
+    DBG_SFU_PRINTF("  No SFDP\n");
+    SFU_EVENT(kSfuEvtSfdp, 0xFFu, 0u);
+    return false;
+  }
+  if (! desc->has_dw15) {
+    DBG_SFU_PRINTF("  SFDP %u.%02u table has no DW15\n", desc->parm_major, desc->parm_minor);
+    SFU_EVENT(kSfuEvtSfdp, 0xFFu, (desc->parm_major << 8u) | desc->parm_minor);
+    return false;
+  }
+  return true;
+}
 
-    case SPI_FLASH_VENDOR_MACRONIX:   // 0xC2
-      if (0x20u == type) {
-        // Status: no hardware testing
-        success = set_S6_QE_bit__8_bit_sr1_write(non_volatile_bit);
-      }
-      break;
-#endif
+bool spi_flash_sfdp_apply(const experimental::SfdpDescriptor *pdesc) {
+  using namespace experimental;
+  const SfdpDescriptor &desc = *pdesc;
+
+  // DW16 bits 0-6, Status Register-1 volatility and write enable. Each bit is
+  // its own case:
+  //   BIT0 non-volatile, 06h
+  //   BIT1 volatile only, 06h
+  //   BIT2 volatile only, 50h
+  //   BIT3 non-volatile with a volatile copy, 50h for the volatile copy
+  //   BIT4 mixed volatile and non-volatile bits, 06h
+  uint32_t non_volatile;
+  if (desc.vol_sr & (BIT2 | BIT3)) {
+    non_volatile = volatile_bit;
+  } else if (desc.vol_sr & BIT1) {
+    non_volatile = volatile_wren_bit;
+  } else {
+    // BIT0 or BIT4, the QE bit may be non-volatile
+    DBG_SFU_PRINTF("  SFDP: No volatile Status Register\n");
+    return false;
+  }
 
-#if 0
-    case SPI_FLASH_VENDOR_EON:        // 0x1C
-      // Status: tested, sealed in ESP-12F module
-      // EON EN25Q32C, identification based on datasheet and data matchup
-      // SFDP Revision: 1.00, 1ST Parameter Table Revision: 1.00
-      // SFDP Table Ptr: 0x30, Size: 36 Bytes
-      if (0x30u == type) {
-        // These will match EN25Q32A, EN25Q32B, EN25Q32C pin 4 NC (DQ3) no /HOLD function
-        // EON SPI Flash parts have a WPDis S6 bit in status register-1 for
-        // disabling /WP (and /HOLD). This is similar to QE/S9 on other vendor parts.
-        success = set_S6_QE_bit__8_bit_sr1_write(non_volatile_bit);
-      }
-      // 0x331Cu - Not supported, EN25Q32 no S6 bit
-      // 0x701Cu - EN25QH128A might work
-      break;
-#endif
+  DBG_SFU_PRINTF("  SFDP %u.%02u DW15 QE method: %u\n", desc.parm_major, desc.parm_minor, desc.qe_method);
+  SFU_EVENT(kSfuEvtSfdp, desc.qe_method, (desc.parm_major << 8u) | desc.parm_minor);
+  switch (desc.qe_method) {
+    case kSfdpQeS9_01h_2B:
+    case kSfdpQeS9_01h_2B_Keep:
+    case kSfdpQeS9_35h_01h_2B:
+      return set_S9_QE_bit__16_bit_sr1_write(non_volatile);
+
+    case kSfdpQeS9_35h_31h_1B:
+      return set_S9_QE_bit__8_bit_sr2_write(non_volatile);
+
+    case kSfdpQeS6_01h_1B:
+      return set_S6_QE_bit__8_bit_sr1_write(non_volatile);
 
+    case kSfdpQeNone:       // /HOLD is not controlled by a QE bit.
+    case kSfdpQeSR2B7_3Eh:  // No function for 3Eh/3Fh
     default:
-      success = false;
       break;
   }
-
-  if (! success) {
-    DBG_SFU_PRINTF("* No builtin flash QE bit handler.\n");
-  }
-  return success;
+  return false;
 }
 
-bool spi_flash_vendor_cases(uint32_t _id) __attribute__ ((weak, alias("__spi_flash_vendor_cases")));
+bool spi_flash_sfdp_cases(void) {
+  experimental::SfdpDescriptor desc;
+  return spi_flash_sfdp_read(&desc) && spi_flash_sfdp_apply(&desc);
+}
 
 ////////////////////////////////////////////////////////////////////////////////
-// Handle Freeing up GPIO pins 9 and 10 for various Flash memory chips.
-//
-// returns:
-// true  - on success
-// false - on failure
+// Full detection - read Flash ID and run vendor cases
 //
-bool reclaim_GPIO_9_10() {
+static bool reclaim_detect() {
   using namespace experimental;
-  bool success = false;
-
-#if RECLAIM_GPIO_EARLY && DEBUG_FLASH_QE
-  pinMode(1u, SPECIAL);
-  uart_buff_switch(0u);
-#endif
-  DBG_SFU_PRINTF("\n\n\nRun reclaim_GPIO_9_10()\n");
 
 #if (RECLAIM_GPIO_EARLY == 2)
   uint32_t _id = alt_spi_flash_get_id();
 #else
+  SFU_SPI0_COUNT();
   uint32_t _id = spi_flash_get_id();
 #endif
+  RECLAIM_TIMING_STAMP(kReclaimPhaseIdRead);
   DBG_SFU_PRINTF("  Flash Chip ID: 0x%06X\n", _id);
+  SFU_EVENT(kSfuEvtFlashId, 0u, _id);
 
-#if DEBUG_FLASH_QE
+#if DEBUG_FLASH_QE || DEBUG_FLASH_QE_LOG
   if (is_WEL()) {
     // Most likely left over from BootROM's attempt to update the Flash Status Register.
     // Common event for SPI Flash that don't support 16-bit Write Status Register-1.
     // Seen with EON's EN25Q32C, GigaDevice and Mystery Vendor 0xD8. These
     // do not support 16-bit write status register-1.
     DBG_SFU_PRINTF("  Detected: a previous write failed. The WEL bit is still set.\n");
+    SFU_EVENT(kSfuEvtWelLeftSet, 0u, 0u);
     spi0_flash_write_disable();
   }
 #else
@@ -330,28 +298,161 @@ bool reclaim_GPIO_9_10() {
   // against WEL bit left on in order to prevent volatile writes from turning
   // into non-volatile.
 #endif
+  RECLAIM_TIMING_STAMP(kReclaimPhaseWelCheck);
 
-  // Expand to read SFDP Parameter Version. Use result to differentiate parts.
+  reclaim_recipe_begin(_id);
+  bool success = false;
+#if RECLAIM_GPIO_SFDP
+  success = spi_flash_sfdp_cases();
+  RECLAIM_TIMING_STAMP(kReclaimPhaseSfdp);
+  if (! success) {
+    // The QE write may have failed verify. The vendor table starts over.
+    reclaim_recipe_begin(_id);
+  }
+#endif
+  if (! success) {
+    success = spi_flash_vendor_cases(_id);
+  }
+  spi0_flash_write_disable();
+#if RECLAIM_GPIO_RECIPE_CACHE
+  if (success) {
+    reclaim_recipe_save(reclaim_recipe_current());
+  } else {
+    reclaim_recipe_invalidate();
+  }
+#endif
+  return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Common entry and exit for reclaim_GPIO_9_10() and the single vendor
+// reclaim_GPIO_9_10<Vendor::...>() versions.
+//
+bool _reclaim_GPIO_9_10_begin([[maybe_unused]] const uint32_t id16) {
+  using namespace experimental;
+
+#if (RECLAIM_GPIO_EARLY == 1) && DEBUG_FLASH_QE
+  // With RECLAIM_GPIO_EARLY == 2, ets_printf() already prints to UART0 through
+  // the TX pin the BootROM set up; no SDK UART calls are needed.
+  pinMode(1u, SPECIAL);
+  uart_buff_switch(0u);
+#endif
+  // Not available until _end(true), also when run again
+  reclaimed_pins_set_available(false);
+  DBG_SFU_PRINTF("\n\n\nRun reclaim_GPIO_9_10()\n");
+  SFU_EVENT_LOG_CLEAR();
+  SFU_EVENT(kSfuEvtReclaimBegin, 0u, 0u);
+  RECLAIM_TIMING_START();
 
   // SPI0 must be in DIO or DOUT mode to continue.
   if (is_spi0_quad()) {
     DBG_SFU_PRINTF("  GPIO pins 9 and 10 are not available when configured for SPI Flash Modes: \"QIO\" or \"QOUT\"\n");
+    SFU_EVENT(kSfuEvtQuadMode, 0u, 0u);
+    _reclaim_GPIO_9_10_end(false);
     return false;
   }
 
-  success = spi_flash_vendor_cases(_id);
-  spi0_flash_write_disable();
+#if DEBUG_FLASH_QE || DEBUG_FLASH_QE_LOG
+  if (id16) {
+    // Build asserted the flash part. Only check it for debug builds.
+#if (RECLAIM_GPIO_EARLY == 2)
+    uint32_t _id = alt_spi_flash_get_id();
+#else
+    uint32_t _id = spi_flash_get_id();
+#endif
+    if (id16 != (_id & 0xFFFFu)) {
+      DBG_SFU_PRINTF("* Flash Chip ID: 0x%06X, build expected 0x%04X\n", _id, id16);
+      SFU_EVENT(kSfuEvtIdMismatch, id16, _id);
+    }
+  }
+#endif
+  return true;
+}
+
+bool _reclaim_GPIO_9_10_end(const bool success) {
+  using namespace experimental;
+  RECLAIM_TIMING_STOP();
+
   DBG_SFU_PRINTF("%sSPI0 signals '/WP' and '/HOLD' are%s disabled.\n", (success) ? "  " : "** ", (success) ? "" : " NOT");
   DBG_SFU_PRINTF("%sGPIO9 and GPIO10 are%s available.\n", (success) ? "  " : "** ", (success) ? "" : " NOT");
+  SFU_EVENT(kSfuEvtReclaimEnd, (success) ? 1u : 0u, 0u);
 
   // Set GPIOs to Arduino defaults
   if (success) {
     pinMode(9u, INPUT);
     pinMode(10u, INPUT);
   }
-#if RECLAIM_GPIO_EARLY && DEBUG_FLASH_QE
+  reclaimed_pins_set_available(success);
+#if (RECLAIM_GPIO_EARLY == 1) && DEBUG_FLASH_QE
   ets_delay_us(12000u);   // Give the TX FIFO a moment to clear
   pinMode(1u, INPUT);     // restore back to default
 #endif
   return success;
 }
+
+// Recipe replay or full detection, between _begin and _end
+static bool reclaim_run() {
+  using namespace experimental;
+  bool success = false;
+  bool replayed = false;
+#if RECLAIM_GPIO_RECIPE_CACHE
+  // Warm boot, the flash has not been power cycled. Replay the recipe saved
+  // from the previous boot and skip detection.
+  if (reclaim_recipe_is_warm_boot()) {
+    ReclaimRecipe recipe;
+    if (reclaim_recipe_load(&recipe)) {
+      replayed = success = reclaim_recipe_replay(&recipe);
+      SFU_EVENT(kSfuEvtRecipeReplay, (success) ? 1u : 0u, recipe.id);
+      if (success) {
+        DBG_SFU_PRINTF("  Recipe replayed for Flash Chip ID: 0x%06X\n", recipe.id);
+      } else {
+        DBG_SFU_PRINTF("* Recipe replay failed, run full detection.\n");
+      }
+    }
+  }
+#endif
+  if (! replayed) {
+    success = reclaim_detect();
+  }
+  return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Handle Freeing up GPIO pins 9 and 10 for various Flash memory chips.
+//
+// returns:
+// true  - on success
+// false - on failure
+//
+bool reclaim_GPIO_9_10() {
+  if (! _reclaim_GPIO_9_10_begin(0u)) return false;
+  return _reclaim_GPIO_9_10_end(reclaim_run());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Same as reclaim_GPIO_9_10(); however, first check if the QE bit from the
+// saved recipe is still set. Volatile Status Register bits survive an ESP8266
+// reset when the flash is not power cycled. When they did, that is the only
+// flash transaction.
+//
+bool reclaim_GPIO_9_10_fast() {
+  using namespace experimental;
+  bool success = false;
+
+  if (! _reclaim_GPIO_9_10_begin(0u)) return false;
+
+#if RECLAIM_GPIO_RECIPE_CACHE
+  ReclaimRecipe recipe;
+  if (reclaim_recipe_load(&recipe)) {
+    success = reclaim_recipe_is_applied(&recipe);
+    if (success) {
+      DBG_SFU_PRINTF("  QE/S%u still set for Flash Chip ID: 0x%06X\n", recipe.qe_pos, recipe.id);
+      SFU_EVENT(kSfuEvtRecipeApplied, recipe.qe_pos, recipe.id);
+    }
+  }
+#endif
+  if (! success) {
+    success = reclaim_run();
+  }
+  return _reclaim_GPIO_9_10_end(success);
+}
@@ -21,19 +21,136 @@
 #endif
 
 #include "SpiFlashUtilsQE.h"
+#include "ReclaimRecipe.h"
+#include "ReclaimTiming.h"
+#include "ReclaimedPins.h"
+#include "FlashStrategy.h"
+
+/*
+  SFDP first: when the flash has a JESD216A or later Basic Parameter Table, use
+  the DW15 Quad Enable Requirements field to pick the QE bit method. Parts
+  without DW15, or with a method we do not handle, continue on to
+  `spi_flash_vendor_cases()`. Disable with `-DRECLAIM_GPIO_SFDP=0` when a
+  custom `spi_flash_vendor_cases()` must handle a part that also has DW15.
+*/
+#if ((1 - RECLAIM_GPIO_SFDP - 1) == 2)
+#undef RECLAIM_GPIO_SFDP
+#define RECLAIM_GPIO_SFDP 1
+#endif
+#ifndef RECLAIM_GPIO_SFDP
+#define RECLAIM_GPIO_SFDP 1
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 bool reclaim_GPIO_9_10();
+// Checks the saved recipe's QE bit with one batched Status Register read
+// first. Needs -DRECLAIM_GPIO_RECIPE_CACHE=1, else the same as above.
+bool reclaim_GPIO_9_10_fast();
 bool spi_flash_vendor_cases(uint32_t _id);    // weak - replacement with custom
 bool __spi_flash_vendor_cases(uint32_t _id);
+bool spi_flash_sfdp_cases(void);
+// spi_flash_sfdp_cases() in two parts, for reclaim_GPIO_9_10_async()
+bool spi_flash_sfdp_read(experimental::SfdpDescriptor *desc);
+bool spi_flash_sfdp_apply(const experimental::SfdpDescriptor *desc);
+bool set_S9_QE_bit__16_bit_sr1_write__xmc_sr3(void);
+
+// Shared by reclaim_GPIO_9_10() and reclaim_GPIO_9_10<Vendor::...>()
+bool _reclaim_GPIO_9_10_begin(const uint32_t id16);
+bool _reclaim_GPIO_9_10_end(const bool success);
 
 #ifdef __cplusplus
 }
 #endif
 
+#ifdef __cplusplus
+/*
+  Single flash part builds
+
+  For a product with one module and one flash part, call
+  `experimental::reclaim_GPIO_9_10<Vendor::XMC>()` in place of
+  `reclaim_GPIO_9_10()`. Only the one recipe is compiled in. There is no Flash
+  ID read, SFDP read, or vendor table, and the linker drops them. With
+  `-DDEBUG_FLASH_QE=1` the Flash ID is still read and checked.
+
+  The part may also be selected from the `Sketch.ino.globals.h` file with
+  `-DRECLAIM_GPIO_VENDOR=XMC`, then call `reclaim_GPIO_9_10<kReclaimVendor>()`.
+*/
+namespace experimental {
+
+enum class Vendor : uint8_t {
+  BergMicro,
+  EON,
+  GigaDevice,
+  MysteryD8,
+  Puya,
+  Winbond,
+  XMC,
+  Zbit
+};
+
+// kId16 is the Flash Chip ID (type << 8 | vendor) the recipe was tested with.
+// There is no generic version. An unlisted Vendor is a compile error.
+template <Vendor V> struct ReclaimPolicy;
+
+template <> struct ReclaimPolicy<Vendor::BergMicro> {
+  static constexpr uint32_t kId16 = 0x40E0u;
+  static bool set_qe() { return set_S9_QE_bit__16_bit_sr1_write(volatile_bit); }
+};
+
+template <> struct ReclaimPolicy<Vendor::EON> {
+  // EN25Q32C WPDis, no volatile Status Register
+  static constexpr uint32_t kId16 = 0x301Cu;
+  static bool set_qe() { return set_S6_QE_bit__8_bit_sr1_write(non_volatile_bit); }
+};
+
+template <> struct ReclaimPolicy<Vendor::GigaDevice> {
+  static constexpr uint32_t kId16 = 0x40C8u;
+  static bool set_qe() { return set_S9_QE_bit__8_bit_sr2_write(volatile_bit); }
+};
+
+template <> struct ReclaimPolicy<Vendor::MysteryD8> {
+  static constexpr uint32_t kId16 = 0x40D8u;
+  static bool set_qe() { return set_S9_QE_bit__8_bit_sr2_write(volatile_bit); }
+};
+
+template <> struct ReclaimPolicy<Vendor::Puya> {
+  static constexpr uint32_t kId16 = 0x6085u;
+  static bool set_qe() { return set_S9_QE_bit__16_bit_sr1_write(volatile_bit); }
+};
+
+template <> struct ReclaimPolicy<Vendor::Winbond> {
+  static constexpr uint32_t kId16 = 0x40EFu;
+  static bool set_qe() { return set_S9_QE_bit__16_bit_sr1_write(volatile_bit); }
+};
+
+template <> struct ReclaimPolicy<Vendor::XMC> {
+  static constexpr uint32_t kId16 = 0x4020u;
+  static bool set_qe() { return set_S9_QE_bit__16_bit_sr1_write__xmc_sr3(); }
+};
+
+template <> struct ReclaimPolicy<Vendor::Zbit> {
+  static constexpr uint32_t kId16 = 0x605Eu;
+  static bool set_qe() { return set_S9_QE_bit__16_bit_sr1_write(volatile_bit); }
+};
+
+template <Vendor V>
+bool reclaim_GPIO_9_10() {
+  if (! _reclaim_GPIO_9_10_begin(ReclaimPolicy<V>::kId16)) return false;
+  bool success = ReclaimPolicy<V>::set_qe();
+  spi0_flash_write_disable();
+  return _reclaim_GPIO_9_10_end(success);
+}
+
+#ifdef RECLAIM_GPIO_VENDOR
+constexpr Vendor kReclaimVendor = Vendor::RECLAIM_GPIO_VENDOR;
+#endif
+
+};  // namespace experimental {
+#endif
+
 // missing from spi_vendors.h
 #ifndef SPI_FLASH_VENDOR_BERGMICRO
 #define SPI_FLASH_VENDOR_BERGMICRO 0xE0u
@@ -0,0 +1,202 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaim Async - see ReclaimAsync.h
+
+  The steps follow reclaim_GPIO_9_10_fast(): recipe check, recipe replay, then
+  the full detection.
+*/
+#include <Arduino.h>
+#include <Schedule.h>       // schedule_recurrent_function_us()
+#include "ReclaimAsync.h"
+
+namespace experimental {
+
+enum ReclaimAsyncStep : uint8_t {
+  kAsyncStepBegin,
+  kAsyncStepRecipeCheck,
+  kAsyncStepRecipeReplay,
+  kAsyncStepId,
+  kAsyncStepSfdpRead,
+  kAsyncStepSfdpApply,
+  kAsyncStepVendorFind,
+  kAsyncStepVendorApply,
+  kAsyncStepFinish
+};
+
+struct ReclaimAsyncState {
+  ReclaimAsyncCb cb = nullptr;
+  void *arg = nullptr;
+  uint32_t id = 0u;
+  ReclaimAsyncStep step = kAsyncStepBegin;
+  ReclaimAsyncStatus status = kReclaimAsyncIdle;
+  bool success = false;
+  bool detected = false;    // Full detection ran, save or clear the recipe
+  size_t strategy = 0u;     // flash_strategy_find() result
+#if RECLAIM_GPIO_RECIPE_CACHE
+  ReclaimRecipe recipe = {};
+#endif
+  // Carried from a lookup step to its apply step
+  SfdpDescriptor desc = {};
+  FlashMatchInfo info = {};
+};
+
+static ReclaimAsyncState async_state;
+
+// A sketch's own spi_flash_vendor_cases() cannot be split; it runs as one step.
+static bool vendor_cases_replaced(void) {
+  return (spi_flash_vendor_cases != __spi_flash_vendor_cases);
+}
+
+// One step per call. Returns false when the run is over, which also removes
+// it from the scheduler.
+static bool reclaim_async_step(void) {
+  ReclaimAsyncState &s = async_state;
+
+  switch (s.step) {
+    case kAsyncStepBegin:
+      if (! _reclaim_GPIO_9_10_begin(0u)) {
+        // _begin already called _end(false)
+        s.status = kReclaimAsyncFailed;
+        if (s.cb) s.cb(s.arg, false);
+        return false;
+      }
+#if RECLAIM_GPIO_RECIPE_CACHE
+      s.step = (reclaim_recipe_load(&s.recipe)) ? kAsyncStepRecipeCheck : kAsyncStepId;
+#else
+      s.step = kAsyncStepId;
+#endif
+      break;
+
+#if RECLAIM_GPIO_RECIPE_CACHE
+    case kAsyncStepRecipeCheck:
+      s.success = reclaim_recipe_is_applied(&s.recipe);
+      s.step = (s.success) ? kAsyncStepFinish
+             : (reclaim_recipe_is_warm_boot()) ? kAsyncStepRecipeReplay : kAsyncStepId;
+      break;
+
+    case kAsyncStepRecipeReplay:
+      s.success = reclaim_recipe_replay(&s.recipe);
+      SFU_EVENT(kSfuEvtRecipeReplay, (s.success) ? 1u : 0u, s.recipe.id);
+      if (! s.success) {
+        DBG_SFU_PRINTF("* Recipe replay failed, run full detection.\n");
+      }
+      s.step = (s.success) ? kAsyncStepFinish : kAsyncStepId;
+      break;
+#endif
+
+    case kAsyncStepId:
+#if (RECLAIM_GPIO_EARLY == 2)
+      s.id = alt_spi_flash_get_id();
+#else
+      SFU_SPI0_COUNT();
+      s.id = spi_flash_get_id();
+#endif
+      RECLAIM_TIMING_STAMP(kReclaimPhaseIdRead);
+      DBG_SFU_PRINTF("  Flash Chip ID: 0x%06X\n", s.id);
+      SFU_EVENT(kSfuEvtFlashId, 0u, s.id);
+      reclaim_recipe_begin(s.id);
+      s.detected = true;
+      s.step = (RECLAIM_GPIO_SFDP) ? kAsyncStepSfdpRead : kAsyncStepVendorFind;
+      break;
+
+    case kAsyncStepSfdpRead:
+      s.step = (spi_flash_sfdp_read(&s.desc)) ? kAsyncStepSfdpApply : kAsyncStepVendorFind;
+      break;
+
+    case kAsyncStepSfdpApply:
+      s.success = spi_flash_sfdp_apply(&s.desc);
+      RECLAIM_TIMING_STAMP(kReclaimPhaseSfdp);
+      if (! s.success) {
+        // The QE write may have failed verify. The vendor table starts over.
+        reclaim_recipe_begin(s.id);
+      }
+      s.step = (s.success) ? kAsyncStepFinish : kAsyncStepVendorFind;
+      break;
+
+    case kAsyncStepVendorFind:
+      if (vendor_cases_replaced()) {
+        s.success = spi_flash_vendor_cases(s.id);
+        s.step = kAsyncStepFinish;
+        break;
+      }
+      memset(&s.info, 0, sizeof(s.info));
+      s.info.id = s.id;
+      s.strategy = flash_strategy_find(&s.info);
+      if (SIZE_MAX == s.strategy) {
+        DBG_SFU_PRINTF("* No builtin flash QE bit handler.\n");
+        SFU_EVENT(kSfuEvtNoHandler, 0u, s.id);
+        s.success = false;
+        s.step = kAsyncStepFinish;
+      } else {
+        s.step = kAsyncStepVendorApply;
+      }
+      break;
+
+    case kAsyncStepVendorApply:
+      s.success = flash_strategy_apply(s.strategy, &s.info);
+      if (! s.success) {
+        DBG_SFU_PRINTF("* No builtin flash QE bit handler.\n");
+        SFU_EVENT(kSfuEvtNoHandler, 0u, s.id);
+      }
+      s.step = kAsyncStepFinish;
+      break;
+
+    case kAsyncStepFinish:
+    default:
+      if (s.detected) {
+        // The full detection leaves WEL clear; see reclaim_detect().
+        spi0_flash_write_disable();
+#if RECLAIM_GPIO_RECIPE_CACHE
+        if (s.success) {
+          reclaim_recipe_save(reclaim_recipe_current());
+        } else {
+          reclaim_recipe_invalidate();
+        }
+#endif
+      }
+      _reclaim_GPIO_9_10_end(s.success);
+      s.status = (s.success) ? kReclaimAsyncDone : kReclaimAsyncFailed;
+      if (s.cb) s.cb(s.arg, s.success);
+      return false;
+  }
+  return true;
+}
+
+bool reclaim_GPIO_9_10_async(ReclaimAsyncCb cb, void *arg, const uint32_t step_us) {
+  if (kReclaimAsyncBusy == async_state.status) return false;
+
+  // The pins may not be driven until the last step succeeds
+  reclaimed_pins_set_available(false);
+  async_state.cb = cb;
+  async_state.arg = arg;
+  async_state.id = 0u;
+  async_state.step = kAsyncStepBegin;
+  async_state.success = false;
+  async_state.detected = false;
+  async_state.status = kReclaimAsyncBusy;
+  if (! schedule_recurrent_function_us(reclaim_async_step, step_us)) {
+    async_state.status = kReclaimAsyncFailed;
+    return false;
+  }
+  return true;
+}
+
+ReclaimAsyncStatus reclaim_GPIO_9_10_async_status(void) {
+  return async_state.status;
+}
+
+};  // namespace experimental {
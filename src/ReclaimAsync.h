@@ -0,0 +1,68 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaim Async - reclaim_GPIO_9_10() run as small steps from the scheduler
+
+  For sketches that do not need GPIO9 and GPIO10 until well after WiFi is up.
+  `reclaim_GPIO_9_10_async()` queues a recurrent scheduled function; each
+  call runs one step, then returns to `loop()`. Each lookup runs apart from
+  the write it picks:
+
+    the Flash ID read               one SPI0 command
+    the recipe check                one batched Status Register read
+    the recipe replay               one write sequence, plus one for XMC SR3
+    the SFDP descriptor read        header, parameter header and table reads
+    the SFDP QE bit write           Status Register read, then one write
+                                    sequence with its verify read
+    the vendor strategy lookup      the match functions; the builtin table
+                                    reads SFDP at most once
+    the vendor strategy apply       as the SFDP QE bit write; the XMC fixup
+                                    adds an SR3 read, write and re-read
+
+  The write enable, write, and verify are always one sequence and never split
+  across steps. A custom `spi_flash_vendor_cases()` runs whole, as one step.
+
+  Poll `reclaim_GPIO_9_10_async_status()` or pass a callback. It is called
+  once, from the scheduler, after `ReclaimedPins::available()` is updated.
+
+  Do not call `reclaim_GPIO_9_10()` while an async run is busy.
+*/
+#ifndef EXPERIMENTAL_RECLAIM_ASYNC_H
+#define EXPERIMENTAL_RECLAIM_ASYNC_H
+
+#include "ModeDIO_ReclaimGPIOs.h"
+
+#ifdef __cplusplus
+namespace experimental {
+
+enum ReclaimAsyncStatus : uint8_t {
+  kReclaimAsyncIdle = 0u,   // Never started
+  kReclaimAsyncBusy,
+  kReclaimAsyncDone,        // GPIO9 and GPIO10 are available
+  kReclaimAsyncFailed
+};
+
+typedef void (*ReclaimAsyncCb)(void *arg, const bool success);
+
+// Returns false when a run is already busy. step_us is the time between
+// steps; 0 runs one step at each pass of loop() or yield().
+bool reclaim_GPIO_9_10_async(ReclaimAsyncCb cb = nullptr, void *arg = nullptr, const uint32_t step_us = 1000u);
+ReclaimAsyncStatus reclaim_GPIO_9_10_async_status(void);
+
+};  // namespace experimental {
+#endif
+
+#endif // EXPERIMENTAL_RECLAIM_ASYNC_H
@@ -0,0 +1,166 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaim Recipe - see ReclaimRecipe.h
+*/
+#include <Arduino.h>
+#include <user_interface.h> // system_get_rst_info()
+#include "SpiFlashUtilsQE.h"
+#include "ReclaimRecipe.h"
+#include "ReclaimTiming.h"
+
+extern "C" {
+
+namespace experimental {
+
+constexpr uint32_t kRecipeMagic = 0x51450910u;  // "QE" 09 10
+
+// Built up while spi_flash_vendor_cases() runs. When called from preinit(),
+// the C++ runtime has not run. reclaim_recipe_begin() must initialize it.
+static ReclaimRecipe recipe_notes __attribute__((section(".noinit")));
+
+static uint32_t recipe_chksum(const ReclaimRecipe *recipe) {
+  uint32_t sum = kRecipeMagic;
+  for (size_t i = 0u; i < 3u; i++) {
+    sum = ((sum << 5u) | (sum >> 27u)) ^ recipe->u32[i];
+  }
+  return sum;
+}
+
+void reclaim_recipe_begin(const uint32_t _id) {
+  memset(&recipe_notes.u32[0], 0, sizeof(recipe_notes));
+  recipe_notes.id = _id;
+}
+
+void reclaim_recipe_note_qe(const uint32_t qe_pos, const uint32_t numbits, const uint32_t non_volatile, const uint32_t status) {
+  recipe_notes.qe_pos = qe_pos;
+  recipe_notes.numbits = numbits;
+  recipe_notes.non_volatile = non_volatile;
+  // SR2 alone for an 8-bit QE/S9 write, else SR1 less WIP and WEL
+  recipe_notes.status = status & ((9u == qe_pos && 8u == numbits) ? 0xFFu : 0xFFFCu);
+}
+
+void reclaim_recipe_note_fixup(const uint32_t fixup, const uint32_t sr3) {
+  recipe_notes.fixup |= fixup;
+  recipe_notes.sr3 = sr3;
+}
+
+const ReclaimRecipe *reclaim_recipe_current(void) {
+  return &recipe_notes;
+}
+
+bool reclaim_recipe_load(ReclaimRecipe *recipe) {
+  if (! sfu_rtc_mem_read(RECLAIM_RECIPE_RTC_BLOCK, &recipe->u32[0], sizeof(ReclaimRecipe))) {
+    return false;
+  }
+  return (recipe_chksum(recipe) == recipe->chksum);
+}
+
+bool reclaim_recipe_save(const ReclaimRecipe *recipe) {
+  ReclaimRecipe rtc = *recipe;
+  rtc.chksum = recipe_chksum(&rtc);
+  return sfu_rtc_mem_write(RECLAIM_RECIPE_RTC_BLOCK, &rtc.u32[0], sizeof(ReclaimRecipe));
+}
+
+void reclaim_recipe_invalidate(void) {
+  ReclaimRecipe rtc;
+  memset(&rtc.u32[0], 0, sizeof(rtc));
+  sfu_rtc_mem_write(RECLAIM_RECIPE_RTC_BLOCK, &rtc.u32[0], sizeof(ReclaimRecipe));
+}
+
+bool reclaim_recipe_is_warm_boot(void) {
+#if (RECLAIM_GPIO_EARLY == 2)
+  // Before the SDK, only the hardware reason is known. A crash cannot be told
+  // apart from a soft restart, so any reset other than power-on replays. A
+  // replay that fails verify falls back to the full detection.
+  return (kRomResetPowerOn != rtc_get_reset_reason());
+#else
+  // REASON_DEFAULT_RST is a power-up, the volatile Status Register and RTC
+  // memory are not valid. For the crash reasons, we want the full detection
+  // to run again.
+  const struct rst_info *info = system_get_rst_info();
+  if (nullptr == info) return false;
+  return (REASON_DEEP_SLEEP_AWAKE == info->reason || REASON_SOFT_RESTART == info->reason);
+#endif
+}
+
+bool reclaim_recipe_replay(const ReclaimRecipe *recipe) {
+  const uint32_t non_volatile = recipe->non_volatile;
+  bool success = false;
+
+  DBG_SFU_PRINTF("  Replay recipe: QE/S%u, %u-bit write, %svolatile\n",
+    recipe->qe_pos, recipe->numbits, (non_volatile_bit == non_volatile) ? "non-" : "");
+
+  // A non-volatile bit is normally still set. Don't spend an endurance cycle
+  // on each warm boot rewriting it.
+  if (non_volatile_bit == non_volatile && reclaim_recipe_is_applied(recipe)) return true;
+
+  // The value the set_S9_QE_bit__*/set_S6_QE_bit__* functions wrote, with the
+  // bits PRESERVE_EXISTING_STATUS_BITS kept.
+  uint32_t verify = 0u;
+  if (9u == recipe->qe_pos) {
+    if (16u == recipe->numbits) {
+      spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, recipe->status | kQES9Bit2B, non_volatile, 16u, kReadStatusRegister2Cmd, &verify);
+    } else {
+      spi0_flash_write_status_sequence(kWriteStatusRegister2Cmd, recipe->status | kQES9Bit1B, non_volatile, 8u, kReadStatusRegister2Cmd, &verify);
+    }
+    success = (0u != (kQES9Bit1B & verify));
+  } else
+  if (6u == recipe->qe_pos) {
+    spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, recipe->status | kQES6Bit, non_volatile, 8u, kReadStatusRegister1Cmd, &verify);
+    success = (0u != (kQES6Bit & verify));
+  }
+  // qe_pos 0, the strategy that worked did not note a QE write. There is
+  // nothing to replay or verify; the full detection runs it again.
+  RECLAIM_TIMING_STAMP(kReclaimPhaseStatusWrite);
+
+  if (success && (kRecipeFixupXmcSR3 & recipe->fixup)) {
+    spi0_flash_write_status_sequence(kWriteStatusRegister3Cmd, recipe->sr3, volatile_bit, 8u, kReadStatusRegister3Cmd, &verify);
+    success = (recipe->sr3 == (0xFFu & verify));
+  }
+  return success;
+}
+
+bool reclaim_recipe_is_applied(const ReclaimRecipe *recipe) {
+  // Nothing to check, see reclaim_recipe_replay()
+  if (0u == recipe->qe_pos) return false;
+
+  const Spi0ReadOp ops[3] = {
+    {kReadStatusRegister1Cmd, 8u},
+    {kReadStatusRegister2Cmd, 8u},
+    {kReadStatusRegister3Cmd, 8u}
+  };
+  uint32_t sr[3] = {0u, 0u, 0u};
+  const size_t n = (kRecipeFixupXmcSR3 & recipe->fixup) ? 3u : 2u;
+  if (SPI_RESULT_OK != spi0_flash_read_batch(ops, sr, n)) return false;
+  RECLAIM_TIMING_STAMP(kReclaimPhaseStatusRead);
+
+  bool applied = false;
+  if (9u == recipe->qe_pos) {
+    applied = (0u != (kQES9Bit1B & sr[1]));
+  } else
+  if (6u == recipe->qe_pos) {
+    applied = (0u != (kQES6Bit & sr[0]));
+  }
+  if (applied && 3u == n) {
+    applied = (recipe->sr3 == (0xFFu & sr[2]));
+  }
+  return applied;
+}
+
+};  // namespace experimental {
+
+};
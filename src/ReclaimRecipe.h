@@ -0,0 +1,109 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaim Recipe - a record of how the QE bit was set on this flash memory.
+
+  After a successful `reclaim_GPIO_9_10()`, the steps that worked are saved in
+  RTC user memory. At the next warm boot, deep sleep wake or soft restart, the
+  recipe is replayed with one Status Register write and one verify read. No
+  Flash ID read or vendor switching is needed. After a power cycle the RTC
+  memory is lost and the checksum fails, so the full detection runs again.
+
+  Enable with build option `-DRECLAIM_GPIO_RECIPE_CACHE=1`.
+
+  A custom `spi_flash_vendor_cases()` that does more than call one of the
+  `set_S9_QE_bit__*`/`set_S6_QE_bit__*` functions should describe the extra
+  work with `reclaim_recipe_note_fixup()` or leave the cache disabled. A
+  recipe that never noted a QE write is not replayed; the full detection runs.
+
+  The Status Register value that was written, or found with QE already set, is
+  saved with the recipe. With `PRESERVE_EXISTING_STATUS_BITS`, the replay keeps
+  the BP, SRP, and CMP bits the detection kept.
+*/
+#ifndef EXPERIMENTAL_RECLAIM_RECIPE_H
+#define EXPERIMENTAL_RECLAIM_RECIPE_H
+
+#if ((1 - RECLAIM_GPIO_RECIPE_CACHE - 1) == 2)
+#undef RECLAIM_GPIO_RECIPE_CACHE
+#define RECLAIM_GPIO_RECIPE_CACHE 1
+#endif
+
+// RTC user memory is at blocks 64 - 191 (4 bytes per block). The recipe uses
+// the last 4 blocks, which is `ESP.rtcUserMemory` offset 124 - 127.
+#ifndef RECLAIM_RECIPE_RTC_BLOCK
+#define RECLAIM_RECIPE_RTC_BLOCK 188u
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+// Extra steps needed after the QE bit write
+constexpr uint8_t kRecipeFixupNone   = 0u;
+constexpr uint8_t kRecipeFixupXmcSR3 = BIT0;  // Restore SR3 lost on volatile write
+
+union ReclaimRecipe {
+  struct {
+    uint32_t id;                // Flash Chip ID from spi_flash_get_id()
+    uint32_t qe_pos:8;          // 9 or 6 for QE/S9 or QE/S6, 0 when no QE write is needed
+    uint32_t numbits:8;         // Status Register write width, 8 or 16
+    uint32_t non_volatile:8;    // non_volatile_bit, volatile_bit, or volatile_wren_bit
+    uint32_t fixup:8;           // kRecipeFixup... bits
+    uint32_t sr3:8;             // value written back for kRecipeFixupXmcSR3
+    uint32_t status:16;         // Status Register value with QE set, SR2 << 8 | SR1
+                                // for a 16-bit write, less WIP and WEL
+    uint32_t reserved:8;
+    uint32_t chksum;
+  };
+  uint32_t u32[4];
+};
+
+// Used by the set_S9_QE_bit__*/set_S6_QE_bit__* functions to note the method
+// that worked.
+void reclaim_recipe_note_qe(const uint32_t qe_pos, const uint32_t numbits, const uint32_t non_volatile, const uint32_t status);
+void reclaim_recipe_note_fixup(const uint32_t fixup, const uint32_t sr3);
+
+// Start a new recipe for _id. Clears any previous notes.
+void reclaim_recipe_begin(const uint32_t _id);
+
+// The recipe built up since reclaim_recipe_begin()
+const ReclaimRecipe *reclaim_recipe_current(void);
+
+// RTC user memory load/save. Load returns false on checksum failure.
+bool reclaim_recipe_load(ReclaimRecipe *recipe);
+bool reclaim_recipe_save(const ReclaimRecipe *recipe);
+void reclaim_recipe_invalidate(void);
+
+// True when the boot reason leaves the flash powered and the RTC memory intact.
+bool reclaim_recipe_is_warm_boot(void);
+
+// One Status Register write and one verify read. No vendor checks.
+bool reclaim_recipe_replay(const ReclaimRecipe *recipe);
+
+// One batched read of SR1 and SR2, plus SR3 for kRecipeFixupXmcSR3. True when
+// the flash still holds the recipe's QE bit, as after a soft restart that left
+// the volatile Status Register alone. Nothing is written.
+bool reclaim_recipe_is_applied(const ReclaimRecipe *recipe);
+
+};  // namespace experimental {
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPERIMENTAL_RECLAIM_RECIPE_H
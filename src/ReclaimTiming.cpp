@@ -0,0 +1,94 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaim Timing - see ReclaimTiming.h
+*/
+#include <Arduino.h>
+#include "SpiFlashUtils.h"     // sfu_cpu_freq_mhz()
+#include "ReclaimTiming.h"
+
+#if RECLAIM_GPIO_TIMING
+extern "C" {
+
+uint32_t sfu_spi0_count __attribute__((section(".noinit")));
+uint32_t sfu_spi0_cmds __attribute__((section(".noinit")));
+
+namespace experimental {
+
+constexpr uint32_t kTimingValid = 0x54494D45u;  // "TIME"
+
+// Must survive from preinit() to setup(), the C++ runtime would clear .bss.
+static ReclaimTiming reclaim_timing __attribute__((section(".noinit")));
+static uint32_t spi0_count_start __attribute__((section(".noinit")));
+static uint32_t spi0_cmds_start __attribute__((section(".noinit")));
+
+void reclaim_timing_start(void) {
+  memset(&reclaim_timing, 0, sizeof(reclaim_timing));
+  spi0_count_start = sfu_spi0_count;
+  spi0_cmds_start = sfu_spi0_cmds;
+  reclaim_timing.cpu_mhz = sfu_cpu_freq_mhz();
+  reclaim_timing.stamp[kReclaimPhaseBegin] = esp_get_cycle_count();
+}
+
+void reclaim_timing_stamp(const ReclaimPhase phase) {
+  if (kReclaimPhaseCount > phase) {
+    reclaim_timing.stamp[phase] = esp_get_cycle_count();
+  }
+}
+
+void reclaim_timing_stop(void) {
+  reclaim_timing.stamp[kReclaimPhaseDone] = esp_get_cycle_count();
+  reclaim_timing.spi0_calls = sfu_spi0_count - spi0_count_start;
+  reclaim_timing.flash_cmds = sfu_spi0_cmds - spi0_cmds_start;
+  reclaim_timing.valid = kTimingValid;
+}
+
+bool reclaim_timing_is_valid(void) {
+  return (kTimingValid == reclaim_timing.valid);
+}
+
+const ReclaimTiming *reclaim_timing_get(void) {
+  return &reclaim_timing;
+}
+
+uint32_t reclaim_timing_cycles(const ReclaimPhase phase) {
+  if (kReclaimPhaseCount <= phase || 0u == reclaim_timing.stamp[phase]) return 0u;
+  return reclaim_timing.stamp[phase] - reclaim_timing.stamp[kReclaimPhaseBegin];
+}
+
+void reclaim_timing_print(void) {
+  static const char *const names[kReclaimPhaseCount] = {
+    "Begin", "ID Read", "WEL Check", "SFDP", "Status Read", "Status Write", "Done"
+  };
+  if (! reclaim_timing_is_valid()) {
+    Serial.printf_P(PSTR("reclaim_GPIO_9_10() timing not available\r\n"));
+    return;
+  }
+  uint32_t mhz = (reclaim_timing.cpu_mhz) ? reclaim_timing.cpu_mhz : 80u;
+  Serial.printf_P(PSTR("reclaim_GPIO_9_10() timing, %u SPI0 transactions, %u flash instructions\r\n"),
+    reclaim_timing.spi0_calls, reclaim_timing.flash_cmds);
+  for (size_t i = 1u; i < kReclaimPhaseCount; i++) {
+    uint32_t cycles = reclaim_timing_cycles((ReclaimPhase)i);
+    if (cycles) {
+      Serial.printf_P(PSTR("  %-14s %8u cycles, %6u us\r\n"), names[i], cycles, cycles / mhz);
+    }
+  }
+}
+
+};  // namespace experimental {
+
+};
+#endif // RECLAIM_GPIO_TIMING
@@ -0,0 +1,87 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaim Timing - CCOUNT stamps for each phase of `reclaim_GPIO_9_10()`.
+
+  Enable with build option `-DRECLAIM_GPIO_TIMING=1`. The record is kept in a
+  `.noinit` section, so it may be filled from `preinit()` before `Serial` is
+  available, then printed or uploaded from `setup()`.
+
+  A phase that did not run this boot has a zero stamp. When
+  `reclaim_GPIO_9_10()` was not called this boot, the record is left over from
+  a previous boot, check `reclaim_timing_is_valid()`.
+
+  `spi0_calls` counts iCache off/on critical sections; `flash_cmds` counts the
+  flash instructions sent in them. A batched read or a `spi0_flash_sequence()`
+  is one call and several instructions. Compare both when changing how a
+  reclaim method talks to the flash.
+*/
+#ifndef EXPERIMENTAL_RECLAIM_TIMING_H
+#define EXPERIMENTAL_RECLAIM_TIMING_H
+
+#include "SpiFlashUtils.h"  // RECLAIM_GPIO_TIMING, SFU_SPI0_COUNT
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+enum ReclaimPhase {
+  kReclaimPhaseBegin = 0,     // entry to reclaim_GPIO_9_10()
+  kReclaimPhaseIdRead,        // Flash Chip ID read done
+  kReclaimPhaseWelCheck,      // WEL check and write disable done
+  kReclaimPhaseSfdp,          // SFDP DW15 strategy done
+  kReclaimPhaseStatusRead,    // set_*_QE_bit__* first Status Register read done
+  kReclaimPhaseStatusWrite,   // set_*_QE_bit__* write and verify read done
+  kReclaimPhaseDone,          // exit from reclaim_GPIO_9_10()
+  kReclaimPhaseCount
+};
+
+struct ReclaimTiming {
+  uint32_t stamp[kReclaimPhaseCount]; // CCOUNT at the end of each phase
+  uint32_t spi0_calls;                // SPI0 transactions from Begin to Done
+  uint32_t flash_cmds;                // Flash instructions sent in those transactions
+  uint32_t cpu_mhz;                   // CCOUNT rate
+  uint32_t valid;
+};
+
+#if RECLAIM_GPIO_TIMING
+void reclaim_timing_start(void);
+void reclaim_timing_stamp(const ReclaimPhase phase);
+void reclaim_timing_stop(void);
+bool reclaim_timing_is_valid(void);
+const ReclaimTiming *reclaim_timing_get(void);
+// Cycles from kReclaimPhaseBegin to phase, 0 when the phase did not run.
+uint32_t reclaim_timing_cycles(const ReclaimPhase phase);
+void reclaim_timing_print(void);
+
+#define RECLAIM_TIMING_START() reclaim_timing_start()
+#define RECLAIM_TIMING_STAMP(phase) reclaim_timing_stamp(phase)
+#define RECLAIM_TIMING_STOP() reclaim_timing_stop()
+#else
+#define RECLAIM_TIMING_START() do {} while (false)
+#define RECLAIM_TIMING_STAMP(phase) do {} while (false)
+#define RECLAIM_TIMING_STOP() do {} while (false)
+#endif
+
+};  // namespace experimental {
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPERIMENTAL_RECLAIM_TIMING_H
@@ -0,0 +1,299 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaimed Bus - see ReclaimedBus.h
+*/
+#include <Arduino.h>
+#include <user_interface.h> // system_get_cpu_freq()
+#include "ReclaimedBus.h"
+
+namespace experimental {
+
+// Advance deadline by cycles and spin until CCOUNT reaches it. Working from
+// the last deadline, rather than "now", keeps loop overhead from adding up.
+static inline __attribute__((always_inline))
+void wait_until(uint32_t& deadline, const uint32_t cycles) {
+  deadline += cycles;
+  while ((int32_t)(esp_get_cycle_count() - deadline) < 0) {}
+}
+
+static bool valid_pin_pair(const uint8_t a, const uint8_t b) {
+  return (9u == a && 10u == b) || (10u == a && 9u == b);
+}
+
+static uint32_t half_bit_cycles(const uint32_t freq_hz) {
+  if (0u == freq_hz) return 0u;
+  const uint32_t half = (system_get_cpu_freq() * 1000000u) / (2u * freq_hz);
+  return (half) ? half : 1u;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// I2C
+//
+// Open-drain outputs: GPOC drives the line low, GPOS releases it.
+bool ReclaimedI2C::begin(const uint32_t freq_hz, const uint8_t sda, const uint8_t scl, const uint32_t stretch_us) {
+  _ready = false;
+  _started = false;
+  if (! ReclaimedPins::available() || ! valid_pin_pair(sda, scl)) return false;
+  _half = half_bit_cycles(freq_hz);
+  if (0u == _half) return false;
+  _stretch = stretch_us * system_get_cpu_freq();
+  _sda = 1u << sda;
+  _scl = 1u << scl;
+
+  ReclaimedPins::set(_sda | _scl);
+  ReclaimedPins::mode_both(OUTPUT_OPEN_DRAIN);
+  GPF9 |= (1u << GPFPU);
+  GPF10 |= (1u << GPFPU);
+  _ready = true;
+
+  // Bus clear: a slave left mid-byte by a reset holds SDA low. Clock it out.
+  for (size_t i = 0u; i < 9u && 0u == (GPI & _sda); i++) {
+    uint32_t deadline = esp_get_cycle_count();
+    ReclaimedPins::clear(_scl);
+    wait_until(deadline, _half);
+    ReclaimedPins::set(_scl);
+    wait_until(deadline, _half);
+  }
+  if (0u == (GPI & _sda)) {
+    end();
+    return false;
+  }
+  _started = true;
+  stop();
+  return true;
+}
+
+void ReclaimedI2C::end() {
+  if (_sda | _scl) {
+    ReclaimedPins::set(_sda | _scl);
+    ReclaimedPins::mode_both(INPUT);
+  }
+  _ready = false;
+  _started = false;
+}
+
+bool IRAM_ATTR ReclaimedI2C::wait_scl_high(uint32_t& deadline) {
+  if (GPI & _scl) return true;
+  // A slave is stretching the clock. Time the high phase from its release.
+  const uint32_t start = esp_get_cycle_count();
+  while (0u == (GPI & _scl)) {
+    if ((esp_get_cycle_count() - start) >= _stretch) return false;
+  }
+  deadline = esp_get_cycle_count();
+  return true;
+}
+
+bool IRAM_ATTR ReclaimedI2C::start() {
+  const uint32_t saved_ps = xt_rsil(15);
+  uint32_t deadline = esp_get_cycle_count();
+  bool ok = true;
+  if (_started) {
+    // Repeated start, SCL is low here
+    ReclaimedPins::set(_sda);
+    wait_until(deadline, _half);
+    ReclaimedPins::set(_scl);
+    ok = wait_scl_high(deadline);
+    wait_until(deadline, _half);
+  }
+  if (ok && (GPI & _sda)) {
+    ReclaimedPins::clear(_sda);
+    wait_until(deadline, _half);
+    ReclaimedPins::clear(_scl);
+    wait_until(deadline, _half);
+    _started = true;
+  } else {
+    ok = false;   // Lost arbitration or the bus is stuck
+  }
+  xt_wsr_ps(saved_ps);
+  return ok;
+}
+
+void IRAM_ATTR ReclaimedI2C::stop() {
+  const uint32_t saved_ps = xt_rsil(15);
+  uint32_t deadline = esp_get_cycle_count();
+  ReclaimedPins::clear(_sda);
+  wait_until(deadline, _half);
+  ReclaimedPins::set(_scl);
+  wait_scl_high(deadline);
+  wait_until(deadline, _half);
+  ReclaimedPins::set(_sda);
+  wait_until(deadline, _half);
+  _started = false;
+  xt_wsr_ps(saved_ps);
+}
+
+// Returns true on ACK
+bool IRAM_ATTR ReclaimedI2C::write_byte(const uint8_t data) {
+  const uint32_t saved_ps = xt_rsil(15);
+  uint32_t deadline = esp_get_cycle_count();
+  bool ok = true;
+  for (uint32_t bit = 0x80u; bit && ok; bit >>= 1u) {
+    if (data & bit) {
+      ReclaimedPins::set(_sda);
+    } else {
+      ReclaimedPins::clear(_sda);
+    }
+    wait_until(deadline, _half);
+    ReclaimedPins::set(_scl);
+    ok = wait_scl_high(deadline);
+    wait_until(deadline, _half);
+    ReclaimedPins::clear(_scl);
+  }
+  if (ok) {
+    ReclaimedPins::set(_sda);
+    wait_until(deadline, _half);
+    ReclaimedPins::set(_scl);
+    ok = wait_scl_high(deadline);
+    wait_until(deadline, _half);
+    ok = ok && (0u == (GPI & _sda));
+    ReclaimedPins::clear(_scl);
+  }
+  xt_wsr_ps(saved_ps);
+  return ok;
+}
+
+uint8_t IRAM_ATTR ReclaimedI2C::read_byte(const bool ack) {
+  const uint32_t saved_ps = xt_rsil(15);
+  uint32_t deadline = esp_get_cycle_count();
+  uint32_t data = 0u;
+  ReclaimedPins::set(_sda);
+  for (size_t i = 0u; i < 8u; i++) {
+    wait_until(deadline, _half);
+    ReclaimedPins::set(_scl);
+    wait_scl_high(deadline);
+    wait_until(deadline, _half);
+    data = (data << 1u) | ((GPI & _sda) ? 1u : 0u);
+    ReclaimedPins::clear(_scl);
+  }
+  if (ack) ReclaimedPins::clear(_sda);
+  wait_until(deadline, _half);
+  ReclaimedPins::set(_scl);
+  wait_scl_high(deadline);
+  wait_until(deadline, _half);
+  ReclaimedPins::clear(_scl);
+  ReclaimedPins::set(_sda);
+  xt_wsr_ps(saved_ps);
+  return data;
+}
+
+bool IRAM_ATTR ReclaimedI2C::write(const uint8_t addr, const uint8_t *buf, const size_t len, const bool send_stop) {
+  if (! _ready || ! start()) return false;
+  bool ok = write_byte(addr << 1u);
+  for (size_t i = 0u; ok && i < len; i++) {
+    ok = write_byte(buf[i]);
+  }
+  if (send_stop || ! ok) stop();
+  return ok;
+}
+
+bool IRAM_ATTR ReclaimedI2C::read(const uint8_t addr, uint8_t *buf, const size_t len, const bool send_stop) {
+  if (! _ready || ! start()) return false;
+  const bool ok = write_byte((addr << 1u) | 1u);
+  if (ok) {
+    for (size_t i = 0u; i < len; i++) {
+      // NACK the last byte so the slave releases SDA for the stop
+      buf[i] = read_byte(i + 1u < len);
+    }
+  }
+  if (send_stop || ! ok) stop();
+  return ok;
+}
+
+bool ReclaimedI2C::write_reg(const uint8_t addr, const uint8_t reg, const uint8_t *buf, const size_t len) {
+  if (! _ready || ! start()) return false;
+  bool ok = write_byte(addr << 1u) && write_byte(reg);
+  for (size_t i = 0u; ok && i < len; i++) {
+    ok = write_byte(buf[i]);
+  }
+  stop();
+  return ok;
+}
+
+bool ReclaimedI2C::read_reg(const uint8_t addr, const uint8_t reg, uint8_t *buf, const size_t len) {
+  return write(addr, &reg, 1u, false) && read(addr, buf, len);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Shift register link
+//
+bool ReclaimedShift::begin(const uint32_t freq_hz, const uint8_t data_pin, const uint8_t clk_pin, const bool msb_first) {
+  _ready = false;
+  if (! ReclaimedPins::available() || ! valid_pin_pair(data_pin, clk_pin)) return false;
+  _half = half_bit_cycles(freq_hz);
+  if (0u == _half) return false;
+  _data_pin = data_pin;
+  _data = 1u << data_pin;
+  _clk = 1u << clk_pin;
+  _msb_first = msb_first;
+
+  ReclaimedPins::clear(_data | _clk);
+  ReclaimedPins::mode_both(OUTPUT);
+  _ready = true;
+  return true;
+}
+
+void ReclaimedShift::end() {
+  if (_data | _clk) ReclaimedPins::mode_both(INPUT);
+  _ready = false;
+}
+
+bool IRAM_ATTR ReclaimedShift::write(const uint8_t *buf, const size_t len) {
+  if (! _ready) return false;
+  const uint32_t first = (_msb_first) ? 0x80u : 0x01u;
+  for (size_t i = 0u; i < len; i++) {
+    const uint32_t data = buf[i];
+    const uint32_t saved_ps = xt_rsil(15);
+    uint32_t deadline = esp_get_cycle_count();
+    for (uint32_t bit = first; bit & 0xFFu; bit = (_msb_first) ? bit >> 1u : bit << 1u) {
+      if (data & bit) {
+        ReclaimedPins::set(_data);
+      } else {
+        ReclaimedPins::clear(_data);
+      }
+      wait_until(deadline, _half);
+      ReclaimedPins::set(_clk);
+      wait_until(deadline, _half);
+      ReclaimedPins::clear(_clk);
+    }
+    xt_wsr_ps(saved_ps);
+  }
+  return true;
+}
+
+bool IRAM_ATTR ReclaimedShift::read(uint8_t *buf, const size_t len) {
+  if (! _ready) return false;
+  ReclaimedPins::mode(_data_pin, INPUT);
+  for (size_t i = 0u; i < len; i++) {
+    uint32_t data = 0u;
+    const uint32_t saved_ps = xt_rsil(15);
+    uint32_t deadline = esp_get_cycle_count();
+    for (size_t n = 0u; n < 8u; n++) {
+      wait_until(deadline, _half);
+      const uint32_t in = (GPI & _data) ? 1u : 0u;
+      data = (_msb_first) ? ((data << 1u) | in) : ((data >> 1u) | (in << 7u));
+      ReclaimedPins::set(_clk);
+      wait_until(deadline, _half);
+      ReclaimedPins::clear(_clk);
+    }
+    xt_wsr_ps(saved_ps);
+    buf[i] = data;
+  }
+  ReclaimedPins::mode(_data_pin, OUTPUT);
+  return true;
+}
+
+};  // namespace experimental {
@@ -0,0 +1,101 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaimed Bus - bit-banged two-wire links on GPIO9 and GPIO10
+
+  `ReclaimedI2C` is an I2C master and `ReclaimedShift` is a clock + data
+  link for shift registers (SPI mode 0 without chip select or MISO).
+
+  Bit timing uses CCOUNT deadlines, not delay loops, and all transfer code is
+  in IRAM. A cache miss cannot stretch a bit. Each byte is sent with
+  interrupts off (about 23us at 400 kHz) so ISRs and WiFi only add gaps
+  between bytes, never inside one.
+
+  `begin()` fails unless `ReclaimedPins::available()` is true. The pins are not
+  touched until then. If the CPU clock is changed, call `begin()` again.
+
+  I2C needs external pull-up resistors for 400 kHz; the internal pull-ups are
+  enabled but are too weak for more than about 100 kHz. SCL clock stretching
+  is honored, up to `stretch_us`.
+*/
+#ifndef EXPERIMENTAL_RECLAIMED_BUS_H
+#define EXPERIMENTAL_RECLAIMED_BUS_H
+
+#include "ReclaimedPins.h"
+
+#ifdef __cplusplus
+namespace experimental {
+
+class ReclaimedI2C {
+public:
+  // sda and scl are 9 and 10, in either order
+  bool begin(const uint32_t freq_hz = 400000u, const uint8_t sda = 9u, const uint8_t scl = 10u, const uint32_t stretch_us = 1000u);
+  void end();
+
+  // False on NACK, bus stuck, or not begun. Pass send_stop = false for a repeated
+  // start on the next call.
+  bool write(const uint8_t addr, const uint8_t *buf, const size_t len, const bool send_stop = true);
+  bool read(const uint8_t addr, uint8_t *buf, const size_t len, const bool send_stop = true);
+
+  // Register access. read_reg() writes reg, then a repeated start for the read.
+  bool write_reg(const uint8_t addr, const uint8_t reg, const uint8_t *buf, const size_t len);
+  bool read_reg(const uint8_t addr, const uint8_t reg, uint8_t *buf, const size_t len);
+
+  // Address ACK check
+  bool probe(const uint8_t addr) { return write(addr, nullptr, 0u); }
+
+  bool ready() const { return _ready; }
+
+private:
+  bool start();
+  void stop();
+  bool write_byte(const uint8_t data);
+  uint8_t read_byte(const bool ack);
+  bool wait_scl_high(uint32_t& deadline);
+
+  uint32_t _sda = 0u;           // Pin masks
+  uint32_t _scl = 0u;
+  uint32_t _half = 0u;          // CCOUNT cycles per half bit
+  uint32_t _stretch = 0u;       // CCOUNT cycles
+  bool _ready = false;
+  bool _started = false;
+};
+
+class ReclaimedShift {
+public:
+  // Data out on data_pin, rising-edge clock on clk_pin
+  bool begin(const uint32_t freq_hz = 1000000u, const uint8_t data_pin = 9u, const uint8_t clk_pin = 10u, const bool msb_first = true);
+  void end();
+
+  bool write(const uint8_t *buf, const size_t len);
+  // Data pin is an input while reading, sampled before each rising edge
+  bool read(uint8_t *buf, const size_t len);
+
+  bool ready() const { return _ready; }
+
+private:
+  uint32_t _data = 0u;
+  uint32_t _clk = 0u;
+  uint32_t _half = 0u;
+  uint8_t _data_pin = 0u;
+  bool _msb_first = true;
+  bool _ready = false;
+};
+
+};  // namespace experimental {
+#endif
+
+#endif // EXPERIMENTAL_RECLAIMED_BUS_H
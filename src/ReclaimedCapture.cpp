@@ -0,0 +1,112 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaimed Capture - see ReclaimedCapture.h
+*/
+#include <Arduino.h>
+#include "ReclaimedCapture.h"
+
+namespace experimental {
+
+// Keep the compiler from moving the ring store past the index update. The
+// ESP8266 has one core, so this is all the ordering the SPSC ring needs.
+#define CAPTURE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+void IRAM_ATTR ReclaimedCapture::isr(void *arg) {
+  const uint32_t now = esp_get_cycle_count();
+  ReclaimedCapture *self = static_cast<ReclaimedCapture *>(arg);
+  const uint32_t level = (GPI & self->_mask) ? 1u : 0u;
+  const uint32_t head = self->_head;
+  const uint32_t next = (head + 1u) & self->_size_mask;
+  self->_count++;
+  if (next == self->_tail) {
+    self->_dropped++;
+    return;
+  }
+  self->_ring[head] = (now & ~1u) | level;
+  CAPTURE_BARRIER();
+  self->_head = next;
+}
+
+bool ReclaimedCapture::begin(const uint8_t pin, const int mode, const size_t ring_size, const bool pullup) {
+  end();
+  if (! ReclaimedPins::available() || (9u != pin && 10u != pin)) return false;
+
+  // One slot stays empty to tell full from empty
+  size_t sz = 2u;
+  while (sz < ring_size) sz <<= 1u;
+  _ring = (uint32_t *)malloc(sz * sizeof(uint32_t));
+  if (nullptr == _ring) return false;
+
+  _size_mask = sz - 1u;
+  _pin = pin;
+  _mask = 1u << pin;
+  _head = 0u;
+  _tail = 0u;
+  reset_counts();
+  ReclaimedPins::mode(pin, (pullup) ? INPUT_PULLUP : INPUT);
+  attachInterruptArg(pin, isr, this, mode);
+  return true;
+}
+
+void ReclaimedCapture::end() {
+  if (_ring) {
+    detachInterrupt(_pin);
+    free(_ring);
+    _ring = nullptr;
+  }
+  _size_mask = 0u;
+  _head = 0u;
+  _tail = 0u;
+}
+
+size_t ReclaimedCapture::drain(uint32_t *dst, const size_t max) {
+  if (nullptr == _ring) return 0u;
+  const uint32_t head = _head;
+  CAPTURE_BARRIER();
+  uint32_t tail = _tail;
+  size_t n = 0u;
+  while (tail != head && n < max) {
+    dst[n++] = _ring[tail];
+    tail = (tail + 1u) & _size_mask;
+  }
+  CAPTURE_BARRIER();
+  _tail = tail;
+  return n;
+}
+
+size_t ReclaimedCapture::drain(CaptureBatchCb cb, void *arg) {
+  if (nullptr == _ring) return 0u;
+  const uint32_t head = _head;
+  CAPTURE_BARRIER();
+  uint32_t tail = _tail;
+  size_t total = 0u;
+  while (tail != head) {
+    // Up to the end of the ring, then from the start
+    const size_t n = (head > tail) ? (head - tail) : (_size_mask + 1u - tail);
+    const bool more = cb(arg, &_ring[tail], n);
+    tail = (tail + n) & _size_mask;
+    total += n;
+    CAPTURE_BARRIER();
+    _tail = tail;
+    if (! more) break;
+  }
+  return total;
+}
+
+#undef CAPTURE_BARRIER
+
+};  // namespace experimental {
@@ -0,0 +1,83 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaimed Capture - edge timestamps on GPIO9 or GPIO10
+
+  The GPIO ISR stores the CCOUNT of each edge in a single producer, single
+  consumer ring. `loop()` drains the ring in batches with `drain()`. No locks
+  are needed; the ISR only writes `_head` and the drain only writes `_tail`.
+
+  Each entry is the CCOUNT with bit 0 replaced by the pin level read in the
+  ISR. Use `edge_ccount()` and `edge_level()` to split it. The resolution is
+  2 CPU cycles. CCOUNT wraps every 53s at 80 MHz; unsigned differences between
+  neighboring edges are still correct.
+
+  The ISR and everything it touches is in IRAM or DRAM, the same as the /HOLD
+  tests in `test_GPIO_pin_short()`. The ISR never waits on a flash cache
+  miss. When the ring is full, new edges are counted in `dropped()` and
+  discarded.
+
+  `begin()` fails unless `ReclaimedPins::available()` is true.
+*/
+#ifndef EXPERIMENTAL_RECLAIMED_CAPTURE_H
+#define EXPERIMENTAL_RECLAIMED_CAPTURE_H
+
+#include "ReclaimedPins.h"
+
+#ifdef __cplusplus
+namespace experimental {
+
+// Called with up to two contiguous spans per drain. Return false to stop.
+typedef bool (*CaptureBatchCb)(void *arg, const uint32_t *edges, size_t n);
+
+class ReclaimedCapture {
+public:
+  // ring_size is rounded up to a power of 2. mode is RISING, FALLING or CHANGE.
+  bool begin(const uint8_t pin = 10u, const int mode = CHANGE, const size_t ring_size = 256u, const bool pullup = false);
+  void end();
+
+  // Number of edges waiting
+  size_t available() const { return (_head - _tail) & _size_mask; }
+
+  // Copy up to max edges to dst, oldest first
+  size_t drain(uint32_t *dst, const size_t max);
+  // Hand the waiting edges to cb without a copy
+  size_t drain(CaptureBatchCb cb, void *arg);
+
+  uint32_t dropped() const { return _dropped; }
+  uint32_t count() const { return _count; }
+  void reset_counts() { _dropped = 0u; _count = 0u; }
+
+  static uint32_t edge_ccount(const uint32_t edge) { return edge & ~1u; }
+  static bool edge_level(const uint32_t edge) { return 0u != (edge & 1u); }
+
+private:
+  static void isr(void *arg);
+
+  uint32_t *_ring = nullptr;
+  uint32_t _size_mask = 0u;
+  uint32_t _mask = 0u;          // Pin mask for GPI
+  uint8_t _pin = 0u;
+  volatile uint32_t _head = 0u; // Written by the ISR
+  volatile uint32_t _tail = 0u; // Written by drain()
+  volatile uint32_t _dropped = 0u;
+  volatile uint32_t _count = 0u;
+};
+
+};  // namespace experimental {
+#endif
+
+#endif // EXPERIMENTAL_RECLAIMED_CAPTURE_H
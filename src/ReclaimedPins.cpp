@@ -0,0 +1,39 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaimed Pins - see ReclaimedPins.h
+*/
+#include <Arduino.h>
+#include "ReclaimedPins.h"
+
+extern "C" {
+
+constexpr uint32_t kPinsAvailable = 0x0910A5A5u;
+
+// False at every boot until reclaim_GPIO_9_10() succeeds. In .data, not .bss,
+// so the loader sets it from the image before any code runs. A set from
+// RF_PRE_INIT() or preinit() is not wiped when the C runtime zeroes .bss.
+static uint32_t pins_available __attribute__((section(".data"))) = 0u;
+
+void reclaimed_pins_set_available(const bool available) {
+  pins_available = (available) ? kPinsAvailable : 0u;
+}
+
+bool IRAM_ATTR reclaimed_pins_available(void) {
+  return (kPinsAvailable == pins_available);
+}
+
+};
@@ -0,0 +1,138 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaimed Pins - direct register access to GPIO9 and GPIO10
+
+  `pinMode`, `digitalWrite` and `digitalRead` work after a successful
+  `reclaim_GPIO_9_10()`; however, each call goes through a pin table lookup.
+  `pinMode` uses the GPF table, which is in PROGMEM and cannot be used while
+  the iCache is off or from an ISR that must not miss the cache.
+
+  Everything here is always inlined into the caller. When the caller is in
+  IRAM, so is the pin access. Only GPIO9 and GPIO10 are handled; other pin
+  numbers are ignored.
+
+  `ReclaimedPins::available()` is false at every boot and while
+  `reclaim_GPIO_9_10()` or `reclaim_GPIO_9_10_async()` is running. It is set
+  when the reclaim succeeds. Check it before driving the pins. If the flash
+  still uses /WP or /HOLD, driving GPIO9 can crash the system on the next
+  flash read.
+*/
+#ifndef EXPERIMENTAL_RECLAIMED_PINS_H
+#define EXPERIMENTAL_RECLAIMED_PINS_H
+
+#include <Arduino.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Set by _reclaim_GPIO_9_10_end()
+void reclaimed_pins_set_available(const bool available);
+bool reclaimed_pins_available(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+namespace experimental {
+
+constexpr uint32_t kGpio9Mask = BIT9;
+constexpr uint32_t kGpio10Mask = BIT10;
+constexpr uint32_t kReclaimedPinsMask = BIT9 | BIT10;
+
+#define RECLAIMED_PINS_INLINE static inline __attribute__((always_inline))
+
+struct ReclaimedPins {
+  static bool available() { return reclaimed_pins_available(); }
+
+  // mask is kGpio9Mask, kGpio10Mask, or both
+  RECLAIMED_PINS_INLINE void set(const uint32_t mask) {
+    GPOS = mask & kReclaimedPinsMask;
+  }
+
+  RECLAIMED_PINS_INLINE void clear(const uint32_t mask) {
+    GPOC = mask & kReclaimedPinsMask;
+  }
+
+  // Update both pins with one register write. The read-modify-write of GPO
+  // can lose a change made by an ISR to another pin; call with interrupts off
+  // when that matters.
+  RECLAIMED_PINS_INLINE void write(const uint32_t mask, const uint32_t value) {
+    const uint32_t m = mask & kReclaimedPinsMask;
+    GPO = (GPO & ~m) | (value & m);
+  }
+
+  RECLAIMED_PINS_INLINE void write_pin(const uint8_t pin, const bool high) {
+    if (high) {
+      set(1u << pin);
+    } else {
+      clear(1u << pin);
+    }
+  }
+
+  RECLAIMED_PINS_INLINE void toggle(const uint32_t mask) {
+    const uint32_t m = mask & kReclaimedPinsMask;
+    GPO ^= m;
+  }
+
+  // Both pins at once, bits 9 and 10
+  RECLAIMED_PINS_INLINE uint32_t read() {
+    return GPI & kReclaimedPinsMask;
+  }
+
+  RECLAIMED_PINS_INLINE bool read_pin(const uint8_t pin) {
+    return 0u != (GPI & (kReclaimedPinsMask & (1u << pin)));
+  }
+
+  // Partial pinMode for GPIO9 and GPIO10 without the GPF table in PROGMEM.
+  // Handles INPUT, INPUT_PULLUP, OUTPUT, OUTPUT_OPEN_DRAIN, and SPECIAL.
+  RECLAIMED_PINS_INLINE void mode(const uint8_t pin, const uint8_t pin_mode) {
+    if (9u != pin && 10u != pin) return;
+    volatile uint32_t& gpf = (9u == pin) ? GPF9 : GPF10;
+    if (SPECIAL == pin_mode) {
+      GPC(pin) = (GPC(pin) & (0xF << GPCI)); //SOURCE(GPIO) | DRIVER(NORMAL) | INT_TYPE(UNCHANGED) | WAKEUP_ENABLE(DISABLED)
+      GPEC = (1u << pin); //Disable
+      gpf = GPFFS(GPFFS_BUS(pin)); //Set mode to BUS, SPI
+    } else
+    if (OUTPUT == pin_mode || OUTPUT_OPEN_DRAIN == pin_mode) {
+      gpf = GPFFS(GPFFS_GPIO(pin)); //Set mode to GPIO
+      GPC(pin) = (GPC(pin) & (0xF << GPCI)); //SOURCE(GPIO) | DRIVER(NORMAL) | INT_TYPE(UNCHANGED) | WAKEUP_ENABLE(DISABLED)
+      if (OUTPUT_OPEN_DRAIN == pin_mode) GPC(pin) |= (1u << GPCD);
+      GPES = (1u << pin); //Enable
+    } else
+    if (INPUT == pin_mode || INPUT_PULLUP == pin_mode) {
+      gpf = GPFFS(GPFFS_GPIO(pin)); //Set mode to GPIO
+      GPEC = (1u << pin); //Disable
+      GPC(pin) = (GPC(pin) & (0xF << GPCI)) | (1u << GPCD); //SOURCE(GPIO) | DRIVER(OPEN_DRAIN) | INT_TYPE(UNCHANGED) | WAKEUP_ENABLE(DISABLED)
+      if (INPUT_PULLUP == pin_mode) gpf |= (1u << GPFPU);
+    }
+  }
+
+  // Same mode for both pins
+  RECLAIMED_PINS_INLINE void mode_both(const uint8_t pin_mode) {
+    mode(9u, pin_mode);
+    mode(10u, pin_mode);
+  }
+};
+
+#undef RECLAIMED_PINS_INLINE
+
+};  // namespace experimental {
+#endif
+
+#endif // EXPERIMENTAL_RECLAIMED_PINS_H
@@ -0,0 +1,133 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaimed Wave - see ReclaimedWave.h
+*/
+#include <Arduino.h>
+#include <user_interface.h> // system_get_cpu_freq()
+#include "ReclaimedWave.h"
+
+namespace experimental {
+
+// Keep the compiler from moving the step count store past the queue index
+// store. One core; this is all the ordering the handoff needs.
+#define WAVE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// timer1 at TIM_DIV16 counts 5 ticks per us from the 80 MHz APB clock
+constexpr uint32_t kTicksPerUs = 5u;
+constexpr uint32_t kMaxTicks = 0x7FFFFFu;
+// One shot delay from submit() to the ISR
+constexpr uint32_t kStartTicks = 10u;
+// A step is late when it starts more than this past its deadline. It covers
+// the loop overhead, and a delta shorter than that.
+constexpr int32_t kLateSlack = 16;
+
+static ReclaimedWave *s_wave = nullptr;
+
+void IRAM_ATTR ReclaimedWave::play(const WaveStep *steps, const size_t n) {
+  const uint32_t pins = _pins;
+  uint32_t late = 0u;
+  const uint32_t saved_ps = xt_rsil(15);
+  uint32_t deadline = esp_get_cycle_count();
+  for (size_t i = 0u; i < n; i++) {
+    deadline += steps[i].delta;
+    if ((int32_t)(esp_get_cycle_count() - deadline) > kLateSlack) late++;
+    while ((int32_t)(esp_get_cycle_count() - deadline) < 0) {}
+    GPOS = steps[i].set & pins;
+    GPOC = steps[i].clear & pins;
+  }
+  xt_wsr_ps(saved_ps);
+  if (late) _late++;
+}
+
+void IRAM_ATTR ReclaimedWave::timer_isr() {
+  ReclaimedWave *self = s_wave;
+  if (nullptr == self) return;
+  const uint8_t queued = self->_queued;
+  if (kNone == queued) {
+    if (self->_period_ticks) self->_underruns++;
+    return;
+  }
+  WAVE_BARRIER();
+  self->play(self->_buf[queued], self->_queued_n);
+  self->_frames++;
+  WAVE_BARRIER();
+  self->_queued = kNone;
+}
+
+bool ReclaimedWave::begin(const uint32_t pins, const size_t max_steps, const uint32_t period_us, const uint32_t idle) {
+  end();
+  if (! ReclaimedPins::available() || nullptr != s_wave) return false;
+  const uint32_t m = pins & kReclaimedPinsMask;
+  if (0u == m || 0u == max_steps || UINT16_MAX < max_steps) return false;
+  if (kMaxTicks / kTicksPerUs < period_us) return false;
+
+  _buf[0] = (WaveStep *)malloc(2u * max_steps * sizeof(WaveStep));
+  if (nullptr == _buf[0]) return false;
+  _buf[1] = _buf[0] + max_steps;
+  _max_steps = max_steps;
+  _pins = m;
+  _period_ticks = period_us * kTicksPerUs;
+  _cpu_mhz = system_get_cpu_freq();
+  _fill = 0u;
+  _queued = kNone;
+  _queued_n = 0u;
+  reset_counts();
+
+  ReclaimedPins::write(m, idle);
+  if (m & kGpio9Mask) ReclaimedPins::mode(9u, OUTPUT);
+  if (m & kGpio10Mask) ReclaimedPins::mode(10u, OUTPUT);
+
+  s_wave = this;
+  timer1_isr_init();
+  timer1_attachInterrupt(timer_isr);
+  if (_period_ticks) {
+    timer1_enable(TIM_DIV16, TIM_EDGE, TIM_LOOP);
+    timer1_write(_period_ticks);
+  } else {
+    timer1_enable(TIM_DIV16, TIM_EDGE, TIM_SINGLE);
+  }
+  return true;
+}
+
+void ReclaimedWave::end() {
+  if (_buf[0]) {
+    timer1_disable();
+    timer1_detachInterrupt();
+    s_wave = nullptr;
+    free(_buf[0]);
+  }
+  _buf[0] = nullptr;
+  _buf[1] = nullptr;
+  _max_steps = 0u;
+  _queued = kNone;
+  _queued_n = 0u;
+}
+
+bool ReclaimedWave::submit(const size_t n) {
+  if (nullptr == _buf[0] || 0u == n || _max_steps < n) return false;
+  if (kNone != _queued) return false;
+  _queued_n = n;
+  WAVE_BARRIER();
+  _queued = _fill;
+  _fill ^= 1u;
+  if (0u == _period_ticks) timer1_write(kStartTicks);
+  return true;
+}
+
+#undef WAVE_BARRIER
+
+};  // namespace experimental {
@@ -0,0 +1,106 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaimed Wave - precomputed waveform replay on GPIO9 and GPIO10
+
+  A frame is an array of `WaveStep`, each a GPOS mask, a GPOC mask, and the
+  CCOUNT cycles to wait after the previous step. The timer1 ISR plays a whole
+  frame with interrupts masked, spinning on CCOUNT deadlines the same as
+  `ReclaimedBus`. The player and the frame buffers are in IRAM and DRAM; no
+  step can be stretched by a flash cache miss. Only the WiFi NMI can get in.
+
+  There are two frame buffers. `frame()` is the one to build; `submit()`
+  queues it and hands back the other one. While the queued frame waits for
+  its timer1 slot, `loop()` builds the next. The player never touches the
+  buffer being built.
+
+  With `period_us` of 0, a submitted frame plays right away. Otherwise timer1
+  runs free at that period and each tick plays the queued frame, if any. A
+  tick with nothing queued is counted in `underruns()`. A frame with a step
+  that started after its deadline, an NMI or a too short delta, is counted in
+  `late()`.
+
+  Interrupts are off for the length of each frame. Keep frames short, well
+  under a millisecond with WiFi on. timer1 is not shared; `begin()` fails while
+  another `ReclaimedWave` has it. Servo, tone, and analogWrite use timer1 too.
+
+  `begin()` fails unless `ReclaimedPins::available()` is true. If the CPU
+  clock is changed, call `begin()` again.
+*/
+#ifndef EXPERIMENTAL_RECLAIMED_WAVE_H
+#define EXPERIMENTAL_RECLAIMED_WAVE_H
+
+#include "ReclaimedPins.h"
+
+#ifdef __cplusplus
+namespace experimental {
+
+struct WaveStep {
+  uint32_t delta;               // CCOUNT cycles after the previous step, or the frame start
+  uint16_t set;                 // GPOS mask, kGpio9Mask and/or kGpio10Mask
+  uint16_t clear;               // GPOC mask
+};
+
+class ReclaimedWave {
+public:
+  // pins is kGpio9Mask, kGpio10Mask, or both; they are made outputs at idle.
+  // max_steps is the size of each of the two frame buffers.
+  bool begin(const uint32_t pins = kReclaimedPinsMask, const size_t max_steps = 256u,
+             const uint32_t period_us = 0u, const uint32_t idle = 0u);
+  void end();
+
+  // The buffer to build. nullptr when not begun.
+  WaveStep *frame() { return (_buf[0]) ? _buf[_fill] : nullptr; }
+  size_t capacity() const { return _max_steps; }
+
+  // Queue the first n steps of frame(). False when a frame is already queued,
+  // n is 0 or larger than capacity(), or not begun.
+  bool submit(const size_t n);
+
+  // A frame is queued and has not played yet
+  bool busy() const { return kNone != _queued; }
+
+  uint32_t cycles_from_ns(const uint32_t ns) const { return (ns * _cpu_mhz + 999u) / 1000u; }
+  uint32_t cycles_from_us(const uint32_t us) const { return us * _cpu_mhz; }
+
+  uint32_t frames() const { return _frames; }
+  uint32_t underruns() const { return _underruns; }
+  uint32_t late() const { return _late; }
+  void reset_counts() { _frames = 0u; _underruns = 0u; _late = 0u; }
+
+private:
+  static constexpr uint8_t kNone = 0xFFu;
+
+  static void timer_isr();
+  void play(const WaveStep *steps, const size_t n);
+
+  WaveStep *_buf[2] = {nullptr, nullptr};
+  size_t _max_steps = 0u;
+  uint32_t _pins = 0u;
+  uint32_t _period_ticks = 0u;  // timer1 ticks, 0 for one shot
+  uint32_t _cpu_mhz = 0u;
+  uint8_t _fill = 0u;           // Buffer index for frame(), written by loop() only
+  volatile uint8_t _queued = kNone; // Buffer index waiting to play, cleared by the ISR
+  volatile uint16_t _queued_n = 0u;
+  volatile uint32_t _frames = 0u;
+  volatile uint32_t _underruns = 0u;
+  volatile uint32_t _late = 0u;
+};
+
+};  // namespace experimental {
+#endif
+
+#endif // EXPERIMENTAL_RECLAIMED_WAVE_H
@@ -55,6 +55,20 @@ SfdpRevInfo get_sfdp_revision() {
   return rev;
 }
 
+size_t get_sfdp_basic_table(SfdpRevInfo *rev, uint32_t *dw, const size_t max_dw) {
+  if (nullptr == rev || nullptr == dw) return 0u;
+
+  *rev = get_sfdp_revision();
+  if (0u == rev->tbl_ptr) return 0u;
+
+  size_t addr = rev->tbl_ptr;
+  size_t sz_dw = std::min((size_t)rev->sz_dw, max_dw);
+  if (SPI_RESULT_OK == spi0_flash_read_sfdp(addr, dw, sz_dw * 4u)) {
+    return sz_dw;
+  }
+  return 0u;
+}
+
 uint32_t* get_sfdp_basic(SfdpRevInfo *rev) {
   if (nullptr == rev) return nullptr;
 
@@ -75,4 +89,64 @@ uint32_t* get_sfdp_basic(SfdpRevInfo *rev) {
   return nullptr;
 }
 
+static uint32_t sfdp_capacity_log2(const SFDP_Basic_2dw *dw2) {
+  if (dw2->giga) {
+    // size in bits is 2^capacity
+    return (3u < dw2->capacity && 35u > dw2->capacity) ? dw2->capacity - 3u : 0u;
+  }
+  uint32_t bits = dw2->capacity + 1u;
+  if (8u > bits || (bits & (bits - 1u))) return 0u;
+  return __builtin_ctz(bits) - 3u;
+}
+
+bool sfdp_parse_basic(const SfdpRevInfo *rev, const uint32_t *dw, const size_t sz_dw, SfdpDescriptor *desc) {
+  if (nullptr == desc) return false;
+  memset(&desc->u32[0], 0, sizeof(SfdpDescriptor));
+  if (rev) {
+    desc->parm_major = rev->parm_major;
+    desc->parm_minor = rev->parm_minor;
+  }
+  if (nullptr == dw || 2u > sz_dw) return false;
+  desc->sz_dw = sz_dw;
+
+  SFDP_Basic_1dw dw1;
+  dw1.u32[0] = dw[0];
+  if (1u == dw1.wr_en_volatile) {
+    desc->vol_wr_en_cmd = 0x50u;
+  } else if (3u == dw1.wr_en_volatile) {
+    desc->vol_wr_en_cmd = 0x06u;
+  }
+  desc->fast_read =
+    ((dw1.fast_read_1_1_2) ? kSfdpFastRead_1_1_2 : 0u) |
+    ((dw1.fast_read_1_2_2) ? kSfdpFastRead_1_2_2 : 0u) |
+    ((dw1.fast_read_1_1_4) ? kSfdpFastRead_1_1_4 : 0u) |
+    ((dw1.fast_read_1_4_4) ? kSfdpFastRead_1_4_4 : 0u);
+
+  SFDP_Basic_2dw dw2;
+  dw2.u32[0] = dw[1];
+  desc->capacity_log2 = sfdp_capacity_log2(&dw2);
+
+  if (16u <= sz_dw) {
+    SFDP_Basic_15dw dw15;
+    SFDP_Basic_16dw dw16;
+    dw15.u32[0] = dw[14];
+    dw16.u32[0] = dw[15];
+    desc->has_dw15 = 1u;
+    desc->qe_method = dw15.qe;
+    desc->hold_disable = dw15.hold_disable;
+    desc->vol_sr = dw16.non_volatile;
+    desc->soft_reset = dw16.soft_reset;
+  }
+  return true;
+}
+
+bool get_sfdp_descriptor(SfdpDescriptor *desc) {
+  if (nullptr == desc) return false;
+
+  SfdpRevInfo rev;
+  uint32_t dw[kSfdpBasicMaxDw];
+  size_t sz_dw = get_sfdp_basic_table(&rev, dw, kSfdpBasicMaxDw);
+  return sfdp_parse_basic(&rev, dw, sz_dw, desc);
+}
+
 };
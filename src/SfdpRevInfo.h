@@ -80,9 +80,95 @@ union SFDP_Basic_2dw {
   uint32_t u32[2];
 };
 
+// 15th DWORD - JESD216A and up, Quad Enable Requirements
+union SFDP_Basic_15dw {
+  struct {
+    uint32_t ignore:20;
+    uint32_t qe:3;              // QE Quad Enable method, see kSfdpQe...
+    uint32_t hold_disable:1;    // Hold/Reset function disable feature available in Extended Status Register
+    uint32_t reserved2:8;
+  };
+  uint32_t u32[1];
+};
+
+// 16th DWORD - JESD216A and up
+union SFDP_Basic_16dw {
+  struct {
+    uint32_t non_volatile:7;    // Volatile or Non-Volatile Register and Write Enable Instruction for Status Register 1
+    uint32_t reserved:1;
+    uint32_t soft_reset:6;      // Soft Reset and Rescue Sequence Support, see kSfdpSoftReset...
+    uint32_t exit_4b_addr:10;
+    uint32_t enter_4b_addr:8;
+  };
+  uint32_t u32[1];
+};
+
+// DW15 QE method, bits 20-22
+constexpr uint8_t kSfdpQeNone           = 0u; // No QE bit
+constexpr uint8_t kSfdpQeS9_01h_2B      = 1u; // QE/S9, 16-bit write with 01h, 8-bit 01h write clears SR2
+constexpr uint8_t kSfdpQeS6_01h_1B      = 2u; // QE/S6, 8-bit write with 01h
+constexpr uint8_t kSfdpQeSR2B7_3Eh      = 3u; // QE bit 7 of SR2, write 3Eh, read 3Fh
+constexpr uint8_t kSfdpQeS9_01h_2B_Keep = 4u; // QE/S9, 16-bit write with 01h, 8-bit 01h write keeps SR2
+constexpr uint8_t kSfdpQeS9_35h_01h_2B  = 5u; // QE/S9, read with 35h, 16-bit write with 01h
+constexpr uint8_t kSfdpQeS9_35h_31h_1B  = 6u; // QE/S9, read with 35h, 8-bit write with 31h
+
+// DW16 Soft Reset, bits 8-13. The Fh sequences drive all four data lines.
+constexpr uint8_t kSfdpSoftReset_Fh8    = BIT0; // drive Fh for 8 clocks
+constexpr uint8_t kSfdpSoftReset_Fh10   = BIT1; // drive Fh for 10 clocks in 4-byte address mode
+constexpr uint8_t kSfdpSoftReset_Fh16   = BIT2; // drive Fh for 16 clocks
+constexpr uint8_t kSfdpSoftReset_F0h    = BIT3; // issue instruction F0h
+constexpr uint8_t kSfdpSoftReset_66h99h = BIT4; // reset enable 66h, then reset 99h
+constexpr uint8_t kSfdpSoftReset_0_4_4  = BIT5; // exit 0-4-4 mode before any of the above
+
+// SfdpDescriptor fast_read bits from DW1
+constexpr uint8_t kSfdpFastRead_1_1_2   = BIT0;
+constexpr uint8_t kSfdpFastRead_1_2_2   = BIT1;
+constexpr uint8_t kSfdpFastRead_1_1_4   = BIT2;
+constexpr uint8_t kSfdpFastRead_1_4_4   = BIT3;
+
+// The fields of the Basic Parameter Table we act on. When has_dw15 is 0 the
+// table predates JESD216A, qe_method, hold_disable, vol_sr, and soft_reset are
+// not valid.
+union SfdpDescriptor {
+  struct {
+    uint32_t capacity_log2:8;   // Flash size as 2^n bytes, 0 when not valid
+    uint32_t qe_method:3;       // DW15, see kSfdpQe...
+    uint32_t hold_disable:1;    // DW15
+    uint32_t vol_sr:7;          // DW16, volatile/non-volatile SR1 write support
+    uint32_t soft_reset:6;      // DW16, see kSfdpSoftReset...
+    uint32_t fast_read:4;       // DW1, see kSfdpFastRead...
+    uint32_t has_dw15:1;        // Table has DW15 and DW16
+    uint32_t reserved:2;
+    uint32_t vol_wr_en_cmd:8;   // DW1, 50h, 06h, or 0 when volatile SR is not described
+    uint32_t parm_major:8;
+    uint32_t parm_minor:8;
+    uint32_t sz_dw:8;           // Size of the Basic Parameter Table in double words
+  };
+  uint32_t u32[2];
+};
+
+// DW1 - DW16 fit in one 64-byte SFDP read
+constexpr size_t kSfdpBasicMaxDw = 16u;
+
 extern "C" {
   SfdpRevInfo get_sfdp_revision();
+  // Reads up to max_dw double words of the Basic Parameter Table into dw.
+  // Returns the number read or 0 when there is no SFDP.
+  size_t get_sfdp_basic_table(SfdpRevInfo *rev, uint32_t *dw, const size_t max_dw);
+  // uses malloc, must free
   uint32_t* get_sfdp_basic(SfdpRevInfo *rev);
+
+  // Decodes sz_dw double words of the Basic Parameter Table in place. No flash
+  // access and no heap. rev may be NULL.
+  bool sfdp_parse_basic(const SfdpRevInfo *rev, const uint32_t *dw, const size_t sz_dw, SfdpDescriptor *desc);
+  // get_sfdp_basic_table() into a stack buffer, then sfdp_parse_basic().
+  // Safe to call from preinit(). Returns false when there is no SFDP.
+  bool get_sfdp_descriptor(SfdpDescriptor *desc);
+}
+
+inline
+size_t sfdp_capacity_bytes(const SfdpDescriptor *desc) {
+  return (desc->capacity_log2 && 32u > desc->capacity_log2) ? (1u << desc->capacity_log2) : 0u;
 }
 };
 #endif // FLASH_CHIP_ID_H
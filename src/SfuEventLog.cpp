@@ -0,0 +1,133 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  SFU Event Log - see SfuEventLog.h
+*/
+#include <Arduino.h>
+#include "SfuEventLog.h"
+
+#if DEBUG_FLASH_QE_LOG
+static_assert(0u == (DEBUG_FLASH_QE_LOG_SIZE & (DEBUG_FLASH_QE_LOG_SIZE - 1u)),
+  "DEBUG_FLASH_QE_LOG_SIZE must be a power of 2");
+
+extern "C" {
+
+namespace experimental {
+
+constexpr uint32_t kEventLogMagic = 0x45564C47u;  // "EVLG"
+
+// Must survive from preinit() to setup(), the C++ runtime would clear .bss.
+static struct {
+  uint32_t magic;
+  uint32_t head;            // Total events added since the clear
+  SfuEvent ring[DEBUG_FLASH_QE_LOG_SIZE];
+} event_log __attribute__((section(".noinit")));
+
+void sfu_event_log_clear(void) {
+  event_log.head = 0u;
+  event_log.magic = kEventLogMagic;
+}
+
+void sfu_event_log_add(const uint32_t code, const uint32_t a, const uint32_t b) {
+  if (kEventLogMagic != event_log.magic) sfu_event_log_clear();
+  SfuEvent &e = event_log.ring[event_log.head & (DEBUG_FLASH_QE_LOG_SIZE - 1u)];
+  e.code = code;
+  e.a = a;
+  e.b = b;
+  event_log.head++;
+}
+
+size_t sfu_event_log_count(void) {
+  if (kEventLogMagic != event_log.magic) return 0u;
+  return (DEBUG_FLASH_QE_LOG_SIZE < event_log.head) ? DEBUG_FLASH_QE_LOG_SIZE : event_log.head;
+}
+
+bool sfu_event_log_get(const size_t idx, SfuEvent *event) {
+  const size_t count = sfu_event_log_count();
+  if (count <= idx) return false;
+  const uint32_t first = event_log.head - count;
+  *event = event_log.ring[(first + idx) & (DEBUG_FLASH_QE_LOG_SIZE - 1u)];
+  return true;
+}
+
+};  // namespace experimental {
+
+};
+
+namespace experimental {
+
+static const char kEvtReclaimBegin[]   PROGMEM = "reclaim begin";
+static const char kEvtQuadMode[]       PROGMEM = "QIO/QOUT, GPIO9/10 not available";
+static const char kEvtFlashId[]        PROGMEM = "Flash Chip ID";
+static const char kEvtIdMismatch[]     PROGMEM = "Flash Chip ID differs from build";
+static const char kEvtWelLeftSet[]     PROGMEM = "WEL left set";
+static const char kEvtSfdp[]           PROGMEM = "SFDP DW15 QE method";
+static const char kEvtQeState[]        PROGMEM = "QE state";
+static const char kEvtQeSet[]          PROGMEM = "QE set, width | non_volatile << 8";
+static const char kEvtQeClear[]        PROGMEM = "QE clear, width | non_volatile << 8";
+static const char kEvtQeVerify[]       PROGMEM = "QE verify";
+static const char kEvtXmcFixup[]       PROGMEM = "XMC SR3 fixup";
+static const char kEvtNoHandler[]      PROGMEM = "no builtin QE handler";
+static const char kEvtRecipeReplay[]   PROGMEM = "recipe replay";
+static const char kEvtRecipeApplied[]  PROGMEM = "recipe QE still set";
+static const char kEvtSrWriteSkipped[] PROGMEM = "SR write skipped";
+static const char kEvtReclaimEnd[]     PROGMEM = "reclaim end";
+static const char kEvtStrategy[]       PROGMEM = "vendor strategy matched";
+static const char kEvtNvCommit[]       PROGMEM = "NV commit, 0 write 1 skip 2 rewrite";
+static const char kEvtNvVerify[]       PROGMEM = "NV commit verify";
+static const char kEvtUnknown[]        PROGMEM = "?";
+
+static const char *const event_names[] PROGMEM = {
+  kEvtReclaimBegin,
+  kEvtQuadMode,
+  kEvtFlashId,
+  kEvtIdMismatch,
+  kEvtWelLeftSet,
+  kEvtSfdp,
+  kEvtQeState,
+  kEvtQeSet,
+  kEvtQeClear,
+  kEvtQeVerify,
+  kEvtXmcFixup,
+  kEvtNoHandler,
+  kEvtRecipeReplay,
+  kEvtRecipeApplied,
+  kEvtSrWriteSkipped,
+  kEvtReclaimEnd,
+  kEvtStrategy,
+  kEvtNvCommit,
+  kEvtNvVerify
+};
+static_assert(kSfuEvtCount == sizeof(event_names) / sizeof(event_names[0]),
+  "event_names[] is out of step with SfuEventCode");
+
+const char *sfu_event_name(const uint32_t code) {
+  if (kSfuEvtCount <= code) return kEvtUnknown;
+  return (const char *)pgm_read_ptr(&event_names[code]);
+}
+
+void sfu_event_log_print(Print &out) {
+  const size_t count = sfu_event_log_count();
+  for (size_t i = 0u; i < count; i++) {
+    SfuEvent e;
+    if (! sfu_event_log_get(i, &e)) break;
+    out.printf_P(PSTR("@EV %02X %X %X "), e.code, e.a, e.b);
+    out.println(FPSTR(sfu_event_name(e.code)));
+  }
+}
+
+};  // namespace experimental {
+#endif
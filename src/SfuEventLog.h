@@ -0,0 +1,119 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  SFU Event Log - compact debug logging for the reclaim path
+
+  With `-DDEBUG_FLASH_QE_LOG=1`, `DBG_SFU_PRINTF` is compiled out and the
+  reclaim path records numeric events in a small `.noinit` ring instead. Each
+  event is a code and two arguments, 8 bytes. No format strings or `%s`
+  argument strings are linked in. The event names are a PROGMEM table only
+  read by `sfu_event_log_print()`, which may be left out of the build.
+
+  The ring works from `preinit()` and with `RECLAIM_GPIO_EARLY == 2`. It is
+  cleared at the start of each `reclaim_GPIO_9_10()`. Dump it later from
+  `setup()` or `loop()`. When full, the oldest events are overwritten.
+
+  Each event prints as one line, numeric fields in hex for a host decoder:
+
+    @EV <code> <a> <b> <name>
+*/
+#ifndef EXPERIMENTAL_SFU_EVENT_LOG_H
+#define EXPERIMENTAL_SFU_EVENT_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if ((1 - DEBUG_FLASH_QE_LOG - 1) == 2)
+#undef DEBUG_FLASH_QE_LOG
+#define DEBUG_FLASH_QE_LOG 1
+#endif
+
+// Entries, a power of 2
+#ifndef DEBUG_FLASH_QE_LOG_SIZE
+#define DEBUG_FLASH_QE_LOG_SIZE 32u
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+// Keep in step with the names in SfuEventLog.cpp
+enum SfuEventCode : uint16_t {
+  kSfuEvtReclaimBegin = 0u,
+  kSfuEvtQuadMode,          // SPI0 in QIO/QOUT, nothing to do
+  kSfuEvtFlashId,           // b: Flash Chip ID
+  kSfuEvtIdMismatch,        // a: expected id16, b: Flash Chip ID
+  kSfuEvtWelLeftSet,
+  kSfuEvtSfdp,              // a: DW15 QE method or 0xFF, b: (major << 8) | minor
+  kSfuEvtQeState,           // a: QE/S pos, b: 1 when already set
+  kSfuEvtQeSet,             // a: QE/S pos, b: sfu_event_width()
+  kSfuEvtQeClear,           // a: QE/S pos, b: sfu_event_width()
+  kSfuEvtQeVerify,          // a: QE/S pos, b: 1 when the bit reads as wanted
+  kSfuEvtXmcFixup,          // a: 1 on success, b: SR3
+  kSfuEvtNoHandler,         // b: Flash Chip ID
+  kSfuEvtRecipeReplay,      // a: 1 on success, b: Flash Chip ID
+  kSfuEvtRecipeApplied,     // a: QE/S pos, b: Flash Chip ID
+  kSfuEvtSrWriteSkipped,    // a: write command, b: Status Register value
+  kSfuEvtReclaimEnd,        // a: 1 on success
+  kSfuEvtStrategy,          // a: list index, b: 1 when apply succeeded
+  kSfuEvtNvCommit,          // a: SrNvCommitAction, b: Status Register value
+  kSfuEvtNvVerify,          // a: 1 when the read back matched, b: Status Register value
+  kSfuEvtCount
+};
+
+struct SfuEvent {
+  uint16_t code;
+  uint16_t a;
+  uint32_t b;
+};
+
+// Packs a Status Register write width and the non_volatile argument,
+// non_volatile_bit, volatile_bit, or volatile_wren_bit, for kSfuEvtQeSet
+static inline uint32_t sfu_event_width(const uint32_t numbits, const uint32_t non_volatile) {
+  return numbits | ((non_volatile & 0xFFu) << 8u);
+}
+
+#if DEBUG_FLASH_QE_LOG
+void sfu_event_log_add(const uint32_t code, const uint32_t a, const uint32_t b);
+void sfu_event_log_clear(void);
+size_t sfu_event_log_count(void);
+// idx 0 is the oldest event. Returns false when idx is out of range.
+bool sfu_event_log_get(const size_t idx, SfuEvent *event);
+#define SFU_EVENT(code, a, b) experimental::sfu_event_log_add((code), (a), (b))
+#define SFU_EVENT_LOG_CLEAR() experimental::sfu_event_log_clear()
+#else
+#define SFU_EVENT(code, a, b) do {} while (false)
+#define SFU_EVENT_LOG_CLEAR() do {} while (false)
+#endif
+
+};  // namespace experimental {
+
+#ifdef __cplusplus
+}
+#endif
+
+#if defined(__cplusplus) && DEBUG_FLASH_QE_LOG
+class Print;
+namespace experimental {
+// PROGMEM name, or "?" for an unknown code
+const char *sfu_event_name(const uint32_t code);
+void sfu_event_log_print(Print &out);
+};  // namespace experimental {
+#endif
+
+#endif // EXPERIMENTAL_SFU_EVENT_LOG_H
@@ -17,8 +17,10 @@
   SPI0 Flash Utilities
 */
 #include <Arduino.h>
-#include <user_interface.h> // system_soft_wdt_feed()
+#include <user_interface.h> // system_soft_wdt_feed(), system_rtc_mem_read()
 #include "BootROM_NONOS.h"
+#include "SrWearGuard.h"
+#include "SrNvCommit.h"
 
 extern "C" {
 
@@ -27,11 +29,61 @@ using experimental::SPI0Command;
 
 namespace experimental {
 
+#if (RECLAIM_GPIO_EARLY == 2)
+// The SDK soft WDT is not running yet
+#define SFU_SOFT_WDT_FEED() do {} while (false)
+
+// RTC memory is 768 bytes, 4 byte blocks. Blocks 0 - 63 belong to the SDK.
+constexpr uint32_t kRtcMemBase = 0x60001000u;
+constexpr uint32_t kRtcMemUserBlock = 64u;
+constexpr uint32_t kRtcMemBlocks = 192u;
+
+static volatile uint32_t *rtc_mem_block(const uint32_t block, const size_t sz) {
+  // Range check block first, the subtraction is unsigned
+  if (kRtcMemUserBlock > block || kRtcMemBlocks <= block) return nullptr;
+  if ((kRtcMemBlocks - block) * 4u < sz) return nullptr;
+  return (volatile uint32_t *)(kRtcMemBase + (block << 2u));
+}
+
+bool sfu_rtc_mem_read(const uint32_t block, void *p, const size_t sz) {
+  volatile uint32_t *rtc = rtc_mem_block(block, sz);
+  if (nullptr == rtc || (3u & sz)) return false;
+  uint32_t *u32 = (uint32_t *)p;
+  for (size_t i = 0u; i < sz / 4u; i++) u32[i] = rtc[i];
+  return true;
+}
+
+bool sfu_rtc_mem_write(const uint32_t block, const void *p, const size_t sz) {
+  volatile uint32_t *rtc = rtc_mem_block(block, sz);
+  if (nullptr == rtc || (3u & sz)) return false;
+  const uint32_t *u32 = (const uint32_t *)p;
+  for (size_t i = 0u; i < sz / 4u; i++) rtc[i] = u32[i];
+  return true;
+}
+
+uint32_t sfu_cpu_freq_mhz(void) {
+  return ets_get_cpu_frequency();
+}
+
+#else
+#define SFU_SOFT_WDT_FEED() system_soft_wdt_feed()
+
+bool sfu_rtc_mem_read(const uint32_t block, void *p, const size_t sz) {
+  return system_rtc_mem_read(block, p, sz);
+}
+
+bool sfu_rtc_mem_write(const uint32_t block, const void *p, const size_t sz) {
+  return system_rtc_mem_write(block, const_cast<void *>(p), sz);
+}
+
+uint32_t sfu_cpu_freq_mhz(void) {
+  return system_get_cpu_freq();
+}
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
-// base function see .h
-// common logic, 24 bit address reads with one dummpy byte.
-SpiOpResult _spi0_flash_read_common(const uint32_t offset, uint32_t *p, const size_t sz, const uint8_t cmd) {
-  if (sz > 64 || (sz % sizeof(uint32_t))) return SPI_RESULT_ERR;
+// One hardware transaction, 24 bit address reads with one dummpy byte.
+static SpiOpResult _spi0_flash_read_chunk(const uint32_t offset, uint32_t *p, const size_t sz, const uint8_t cmd) {
   FlashAddr24 addr24bit;
 
   // MSB goes on wire first. It comes out of the LSB of a 32-bit word.
@@ -48,86 +100,334 @@ SpiOpResult _spi0_flash_read_common(const uint32_t offset, uint32_t *p, const si
   // SPI0Command sends a read opcode, like SFDP Read (5Ah) with 32 bits of data
   // containing the 24 bit address followed by a dummy byte of zeros. The
   // responce is copied back into pData starting at pData[0].
+  SFU_SPI0_COUNT();
   return SPI0Command(cmd, p, 32u, sz * 8u);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// base function see .h
+// common logic, any length is read as full 64-byte chunks plus a remainder.
+SpiOpResult _spi0_flash_read_common(const uint32_t offset, uint32_t *p, const size_t sz, const uint8_t cmd) {
+  if (sz % sizeof(uint32_t)) return SPI_RESULT_ERR;
+
+  for (size_t done = 0u; done < sz; done += kSpi0ReadChunkSize) {
+    size_t chunk = std::min(sz - done, kSpi0ReadChunkSize);
+    SpiOpResult ok0 = _spi0_flash_read_chunk(offset + done, &p[done / sizeof(uint32_t)], chunk, cmd);
+    if (SPI_RESULT_OK != ok0) return ok0;
+  }
+  return SPI_RESULT_OK;
+}
+
+SpiOpResult _spi0_flash_read_stream(const uint32_t offset, const size_t sz, const uint8_t cmd, Spi0ReadChunkCb cb, void *arg) {
+  if ((sz % sizeof(uint32_t)) || nullptr == cb) return SPI_RESULT_ERR;
+
+  uint32_t buf[kSpi0ReadChunkSize / sizeof(uint32_t)];
+  for (size_t done = 0u; done < sz; done += kSpi0ReadChunkSize) {
+    size_t chunk = std::min(sz - done, kSpi0ReadChunkSize);
+    SpiOpResult ok0 = _spi0_flash_read_chunk(offset + done, buf, chunk, cmd);
+    if (SPI_RESULT_OK != ok0) return ok0;
+    if (! cb(arg, offset + done, buf, chunk)) break;
+  }
+  return SPI_RESULT_OK;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //// Some Flash Status Register functions
 SpiOpResult spi0_flash_read_status_registers_2B(uint32_t *pStatus) {
+  static const Spi0ReadOp ops[] = {
+    {kReadStatusRegister1Cmd, 8u},
+    {kReadStatusRegister2Cmd, 8u}
+  };
+  uint32_t sr[2];
   *pStatus = 0u;
-  SpiOpResult ok0 = spi0_flash_read_status_register_1(pStatus);
-  if (SPI_RESULT_OK == ok0) {
-    uint32_t statusR2 = 0u;
-    ok0 = spi0_flash_read_status_register_2(&statusR2);
-    // SPI0Command clears unused bits in 32-bit word.
-    if (SPI_RESULT_OK == ok0) *pStatus |= (statusR2 << 8u);
-  }
+  SpiOpResult ok0 = spi0_flash_read_batch(ops, sr, 2u);
+  if (SPI_RESULT_OK == ok0) *pStatus = sr[0] | (sr[1] << 8u);
   return ok0;
 }
 
 SpiOpResult spi0_flash_read_status_registers_3B(uint32_t *pStatus) {
-  SpiOpResult ok0 = spi0_flash_read_status_registers_2B(pStatus);
-  if (SPI_RESULT_OK == ok0) {
-    uint32_t statusR3 = 0u;
-    ok0 = spi0_flash_read_status_register_3(&statusR3);
-    if (SPI_RESULT_OK == ok0) *pStatus |= (statusR3 << 16u);
-  }
+  static const Spi0ReadOp ops[] = {
+    {kReadStatusRegister1Cmd, 8u},
+    {kReadStatusRegister2Cmd, 8u},
+    {kReadStatusRegister3Cmd, 8u}
+  };
+  uint32_t sr[3];
+  *pStatus = 0u;
+  SpiOpResult ok0 = spi0_flash_read_batch(ops, sr, 3u);
+  if (SPI_RESULT_OK == ok0) *pStatus = sr[0] | (sr[1] << 8u) | (sr[2] << 16u);
   return ok0;
 }
 
+SpiOpResult spi0_flash_read_status_for_write(const uint8_t cmd, const uint32_t numbits,
+  uint32_t *pStatus, uint32_t *pMask) {
+  *pStatus = 0u;
+  *pMask = 0xFFu;
+  if (kWriteStatusRegister1Cmd == cmd) {
+    // WIP and WEL are read only
+    if (8u < numbits) {
+      *pMask = 0xFFFCu;
+      return spi0_flash_read_status_registers_2B(pStatus);
+    }
+    *pMask = 0xFCu;
+    return spi0_flash_read_status_register_1(pStatus);
+  }
+  if (kWriteStatusRegister2Cmd == cmd) return spi0_flash_read_status_register_2(pStatus);
+  if (kWriteStatusRegister3Cmd == cmd) return spi0_flash_read_status_register_3(pStatus);
+  return SPI_RESULT_ERR;
+}
 
-//  spi0_flash_command_pair(kEnableResetCmd, kResetCmd);
-void IRAM_ATTR spi0_flash_command_pair(const uint8_t cmd1, const uint8_t cmd2, const uint32_t us) {
-  system_soft_wdt_feed();
+////////////////////////////////////////////////////////////////////////////////
+// Must be inlined into IRAM callers. Runs one user defined command in the
+// most basic IO mode. Caller has disabled the iCache and interrupts.
+static inline __attribute__((always_inline))
+uint32_t _spi0_user_command(const uint32_t spiu2, const uint8_t cmd,
+  const uint32_t mosi_bits, const uint32_t mosi_data, const uint32_t miso_bits) {
+
+  uint32_t spiu = SPIUCOMMAND | SPIUCSSETUP; //SPI_USR_COMMAND | SPI_CS_SETUP
+  uint32_t spiu1 = 0u;
+  if (mosi_bits) {
+    spiu |= SPIUMOSI;
+    spiu1 |= ((mosi_bits - 1u) & SPIMMOSI) << SPILMOSI;
+    SPI0W0 = mosi_data;
+  }
+  if (miso_bits) {
+    spiu |= SPIUMISO;
+    spiu1 |= ((miso_bits - 1u) & SPIMMISO) << SPILMISO;
+  }
+  SPI0U  = spiu;
+  SPI0U1 = spiu1;
+  SPI0U2 = spiu2 | cmd;
+  SPI0CMD = SPICMDUSR;   //Send cmd
+  while ((SPI0CMD & SPICMDUSR));
+
+  if (0u == miso_bits) return 0u;
+  uint32_t data = SPI0W0;
+  if (32u > miso_bits) data &= (1u << miso_bits) - 1u;
+  return data;
+}
+
+// Status Register writes take up to 15ms (tW) to complete on most parts. For
+// volatile writes, WIP is seldom set at all. Poll with a short first delay,
+// doubling up to kWaitReadyMaxPollUs, so fast parts are not held to the worst
+// case and slow parts are not polled needlessly often.
+constexpr uint32_t kWaitReadyMaxPollUs = 128u;
+
+// CCOUNT measured by the last WIP poll
+static uint32_t last_ready_cycles = 0u;
+
+static inline __attribute__((always_inline))
+bool _spi0_wait_ready(const uint32_t spiu2, const uint32_t timeout_cycles) {
+  const uint32_t start = esp_get_cycle_count();
+  uint32_t poll_us = 1u;
+  bool ready = false;
+  while (true) {
+    // BIT0 of Status Register-1 is WIP. A part still in reset may not drive
+    // the bus and reads as all ones, which is also seen as busy.
+    if (0u == (BIT0 & _spi0_user_command(spiu2, kReadStatusRegister1Cmd, 0u, 0u, 8u))) {
+      ready = true;
+      break;
+    }
+    if ((esp_get_cycle_count() - start) >= timeout_cycles) break;
+    ets_delay_us(poll_us);
+    if (kWaitReadyMaxPollUs > poll_us) poll_us <<= 1u;
+  }
+  last_ready_cycles = esp_get_cycle_count() - start;
+  return ready;
+}
+
+static inline __attribute__((always_inline))
+uint32_t _spi0_basic_io_mode(const uint32_t spi0c) {
+  // Select the most basic IO mode for maximum compatibility
+  // Some flash commands are only available in this mode.
+  uint32_t spic = spi0c;
+  spic &= ~(SPICQIO | SPICDIO | SPICQOUT | SPICDOUT | SPICAHB | SPICFASTRD);
+  spic |= (SPICRESANDRES | SPICSHARE | SPICWPR | SPIC2BSE);
+  return spic;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Each SPI0Command call disables the iCache, waits for SPI idle, and restores
+// the controller state. Here we do that once for the whole list.
+SpiOpResult IRAM_ATTR spi0_flash_read_batch(const Spi0ReadOp *ops, uint32_t *results, const size_t n) {
+  for (size_t i = 0u; i < n; i++) {
+    if (0u == ops[i].miso_bits || 32u < ops[i].miso_bits) return SPI_RESULT_ERR;
+  }
+  SFU_SPI0_COUNT_N(n);
+  SFU_SOFT_WDT_FEED();
 
   Cache_Read_Disable_2();
   Wait_SPI_Idle(flashchip);
-  uint32_t saved_ps = xt_rsil(15); // Only needed for bad ISRs
+  uint32_t saved_ps = xt_rsil(15);
   // preserve essential controller state such as incoming/outgoing
   // data lengths and IO mode.
   uint32_t oldSPI0C = SPI0C;
   uint32_t oldSPI0U = SPI0U;
   uint32_t oldSPI0U2= SPI0U2;
 
-  // Select user defined command mode in the controller
-  uint32_t spiu = SPIUCOMMAND | SPIUCSSETUP; //SPI_USR_COMMAND | SPI_CS_SETUP
   uint32_t spiu2 = ((7 & SPIMCOMMAND)<<SPILCOMMAND); // Set the command byte to send - minus the command
-  // Select the most basic IO mode for maximum compatibility
-  // Some flash commands are only available in this mode.
-  uint32_t spic = oldSPI0C;
-  spic &= ~(SPICQIO | SPICDIO | SPICQOUT | SPICDOUT | SPICAHB | SPICFASTRD);
-  spic |= (SPICRESANDRES | SPICSHARE | SPICWPR | SPIC2BSE);
+  SPI0C  = _spi0_basic_io_mode(oldSPI0C);
+  for (size_t i = 0u; i < n; i++) {
+    results[i] = _spi0_user_command(spiu2, ops[i].cmd, 0u, 0u, ops[i].miso_bits);
+  }
 
-  // Send prefix cmd w/o data - sends 8 bits. eg. Volatile SR Write Enable, 0x50
-  SPI0C  = spic;
-  SPI0U  = spiu;
-  SPI0U1 = 0u;
+  // Restore saved registers
+  SPI0U  = oldSPI0U;
+  SPI0U2 = oldSPI0U2;
+  SPI0C  = oldSPI0C;
 
-  SPI0U2 = spiu2 | cmd1;
-  SPI0CMD = SPICMDUSR;   //Send cmd
-  while ((SPI0CMD & SPICMDUSR));
+  xt_wsr_ps(saved_ps);
+  Cache_Read_Enable_2();
+  return SPI_RESULT_OK;
+}
 
-  SPI0U2 = spiu2 | cmd2;
-  SPI0CMD = SPICMDUSR;   //Send cmd
-  while ((SPI0CMD & SPICMDUSR));
+////////////////////////////////////////////////////////////////////////////////
+// No other flash instruction, including iCache reads, gets inserted between
+// the steps.
+SpiOpResult IRAM_ATTR spi0_flash_sequence(const Spi0Step *steps, uint32_t *data, const size_t n) {
+  for (size_t i = 0u; i < n; i++) {
+    if (32u < steps[i].mosi_bits || 32u < steps[i].miso_bits) return SPI_RESULT_ERR;
+    if (nullptr == data && (steps[i].mosi_bits || steps[i].miso_bits)) return SPI_RESULT_ERR;
+  }
+  SFU_SPI0_COUNT_N(n);
+  // Not in IRAM, get it while the iCache is still on.
+  const uint32_t timeout_cycles = kSpi0WaitReadyTimeoutUs * sfu_cpu_freq_mhz();
+  SpiOpResult result = SPI_RESULT_OK;
+  last_ready_cycles = 0u;
+  SFU_SOFT_WDT_FEED();
+
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  uint32_t saved_ps = xt_rsil(15); // Only needed for bad ISRs
+  // preserve essential controller state such as incoming/outgoing
+  // data lengths and IO mode.
+  uint32_t oldSPI0C = SPI0C;
+  uint32_t oldSPI0U = SPI0U;
+  uint32_t oldSPI0U2= SPI0U2;
+
+  uint32_t spiu2 = ((7 & SPIMCOMMAND)<<SPILCOMMAND); // Set the command byte to send - minus the command
+  SPI0C  = _spi0_basic_io_mode(oldSPI0C);
+  for (size_t i = 0u; i < n; i++) {
+    const uint32_t mosi_bits = steps[i].mosi_bits;
+    const uint32_t miso_bits = steps[i].miso_bits;
+    const uint32_t miso = _spi0_user_command(spiu2, steps[i].cmd,
+      mosi_bits, (mosi_bits) ? data[i] : 0u, miso_bits);
+    if (miso_bits) data[i] = miso;
+
+    if (kSpi0WaitReady == steps[i].post_us) {
+      if (! _spi0_wait_ready(spiu2, timeout_cycles)) result = SPI_RESULT_TIMEOUT;
+    } else if (steps[i].post_us) {
+      ets_delay_us(steps[i].post_us);
+    }
+  }
 
   // Restore saved registers
   SPI0U  = oldSPI0U;
   SPI0U2 = oldSPI0U2;
   SPI0C  = oldSPI0C;
 
-  // needs 10us (tRST) or 40us for GigaDevice or 25ms if erase was running.
-  if (us) ets_delay_us(us);
   // Before making lots of demands after a reset, say hello first with a read
   // status. Otherwise, the iCache stuff gets zeros (observed with XMC)
   // Yes, SPI_read_status() is also called within Wait_SPI_Idle(); however, that
   // by itself was not enough.
-  uint32_t status;
-  SPI_read_status(flashchip, &status);  // function will spin while WIP is set
-  Wait_SPI_Idle(flashchip);
+  // After a timeout, WIP is still set and both would spin on it with no limit.
+  if (SPI_RESULT_TIMEOUT != result) {
+    uint32_t status;
+    SPI_read_status(flashchip, &status);  // function will spin while WIP is set
+    Wait_SPI_Idle(flashchip);
+  }
   WDT_FEED();
   xt_wsr_ps(saved_ps);
   Cache_Read_Enable_2();
+  return result;
+}
+
+//  spi0_flash_command_pair(kEnableResetCmd, kResetCmd);
+void spi0_flash_command_pair(const uint8_t cmd1, const uint8_t cmd2, const uint32_t us) {
+  // needs 10us (tRST) or 40us for GigaDevice or 25ms if erase was running.
+  const uint16_t post_us = (kSpi0WaitReady > us) ? us : kSpi0WaitReady - 1u;
+  const Spi0Step steps[] = {
+    {cmd1, 0u, 0u, 0u},
+    {cmd2, 0u, 0u, post_us}
+  };
+  spi0_flash_sequence(steps, nullptr, 2u);
+}
+
+uint32_t spi0_flash_last_ready_us(void) {
+  return last_ready_cycles / sfu_cpu_freq_mhz();
+}
+
+// tRST is 10us to 40us for an idle part, the rest is polled.
+constexpr uint16_t kResetRecoveryMinUs = 10u;
+
+SpiOpResult spi0_flash_software_reset_wait(uint32_t *elapsed_us) {
+  uint32_t data[3] = {0u, 0u, 0u};
+  const Spi0Step steps[] = {
+    {kEnableResetCmd, 0u, 0u, 0u},
+    {kResetCmd, 0u, 0u, kResetRecoveryMinUs},
+    {kReadStatusRegister1Cmd, 0u, 8u, kSpi0WaitReady}
+  };
+  SpiOpResult ok0 = spi0_flash_sequence(steps, data, 3u);
+  if (elapsed_us) *elapsed_us = kResetRecoveryMinUs + spi0_flash_last_ready_us();
+  return ok0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Write Enable or Volatile Write Enable, the write, then an optional verify
+// read, all in one sequence.
+SpiOpResult spi0_flash_write_status_sequence(const uint8_t cmd, const uint32_t status,
+  const uint32_t non_volatile, const uint32_t numbits, const uint8_t verify_cmd, uint32_t *pVerify) {
+
+  if (0u == numbits || 32u < numbits) return SPI_RESULT_ERR;
+  // volatile_wren_bit uses 06h, but the register has no non-volatile copy
+  [[maybe_unused]] const bool nv_register = (non_volatile_bit == non_volatile);
+  bool skip = false;
+#if FLASH_SR_WEAR_GUARD
+  skip = sr_wear_guard_skip(cmd, status, numbits, nv_register);
+#endif
+#if FLASH_SR_NV_COMMIT
+  if (! skip && nv_register) {
+    skip = (kSrNvCommitSkip == sr_nv_commit_begin(cmd, status, numbits));
+  }
+#endif
+  if (skip) {
+    if (nullptr == pVerify) return SPI_RESULT_OK;
+    const Spi0ReadOp op[1] = {{verify_cmd, 8u}};
+    return spi0_flash_read_batch(op, pVerify, 1u);
+  }
+  Spi0Step steps[4];
+  uint32_t data[4] = {0u, 0u, 0u, 0u};
+  size_t n = 0u;
+  if (volatile_bit != non_volatile) {
+    steps[n++] = {kWriteEnableCmd, 0u, 0u, 0u};
+  } else {
+    // A WEL bit left set from a previous failed operation may turn the
+    // volatile write into a non-volatile write.
+    steps[n++] = {kWriteDisableCmd, 0u, 0u, 0u};
+    steps[n++] = {kVolatileWriteEnableCmd, 0u, 0u, 0u};
+  }
+  data[n] = status;
+  steps[n++] = {cmd, (uint8_t)numbits, 0u, kSpi0WaitReady};
+  const size_t verify = n;
+  if (pVerify) {
+    *pVerify = 0u;
+    steps[n++] = {verify_cmd, 0u, 8u, 0u};
+  }
+
+  SpiOpResult ok0 = spi0_flash_sequence(steps, data, n);
+  if (pVerify && SPI_RESULT_OK == ok0) *pVerify = data[verify];
+#if FLASH_SR_WEAR_GUARD
+  if (SPI_RESULT_OK == ok0) sr_wear_note_write(cmd, numbits, nv_register);
+#endif
+#if FLASH_SR_NV_COMMIT
+  if (SPI_RESULT_OK == ok0) {
+    if (nv_register) {
+      ok0 = sr_nv_commit_end(cmd, status, numbits);
+    } else {
+      sr_nv_commit_note_volatile(cmd, numbits);
+    }
+  }
+#endif
+  return ok0;
 }
 
 };  // namespace experimental {
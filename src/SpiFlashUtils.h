@@ -29,12 +29,28 @@
 #define RECLAIM_GPIO_EARLY 1
 #endif
 
+#if ((1 - RECLAIM_GPIO_TIMING - 1) == 2)
+#undef RECLAIM_GPIO_TIMING
+#define RECLAIM_GPIO_TIMING 1
+#endif
+
 /*
   The debug printing could be controled/overriden by the module that includes
   this file; however, it is less confusing if we do it all in one place - this
   core include file.
 */
-#if !defined(DBG_SFU_PRINTF) && DEBUG_FLASH_QE && RECLAIM_GPIO_EARLY
+#include "SfuEventLog.h"   // SFU_EVENT(), DEBUG_FLASH_QE_LOG
+
+#if !defined(DBG_SFU_PRINTF) && DEBUG_FLASH_QE_LOG
+// Numeric events to a RAM ring in place of the format strings
+#define DBG_SFU_PRINTF(...) do {} while (false)
+#elif !defined(DBG_SFU_PRINTF) && DEBUG_FLASH_QE && (RECLAIM_GPIO_EARLY == 2)
+// No SDK or core print support. The BootROM's ets_printf() reads the format
+// a byte at a time, so the strings must stay in DRAM. Output goes to UART0 at
+// the BootROM baud rate, 74880 with a 26 MHz crystal.
+extern "C" int ets_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+#define DBG_SFU_PRINTF(fmt, ...) ets_printf(fmt, ##__VA_ARGS__)
+#elif !defined(DBG_SFU_PRINTF) && DEBUG_FLASH_QE && RECLAIM_GPIO_EARLY
 // Use lower level print functions when printing before "C++" runtime has
 // initialized. Since no ISRs are involved we can save on DRAM strings by using
 // umm_info_safe_printf_P().
@@ -55,11 +71,25 @@ extern SpiFlashOpResult spi_flash_read_status(uint32_t *status); // NONOS_SDK
 #include <spi_flash.h>    // SpiOpResult
 #include <spi_utils.h>
 
+#if RECLAIM_GPIO_TIMING
+// Count of SPI0 flash transactions, each one an iCache off/on, and of flash
+// instructions sent within them. See ReclaimTiming.h
+extern uint32_t sfu_spi0_count;
+extern uint32_t sfu_spi0_cmds;
+#define SFU_SPI0_COUNT_N(n) do { sfu_spi0_count++; sfu_spi0_cmds += (n); } while (false)
+#else
+#define SFU_SPI0_COUNT_N(n) do {} while (false)
+#endif
+#define SFU_SPI0_COUNT() SFU_SPI0_COUNT_N(1u)
+
 namespace experimental {
 
+// The non_volatile argument of the Status Register write functions. true and
+// false still work.
 enum {
-  non_volatile_bit = true,
-  volatile_bit = false
+  non_volatile_bit = true,      // Write Enable 06h, non-volatile register
+  volatile_bit = false,         // Volatile Write Enable 50h
+  volatile_wren_bit = 2         // Write Enable 06h, volatile only register
 };
 
 //
@@ -109,15 +139,18 @@ constexpr uint8_t kReadSecurityRegisterCmd    = 0x48u;
 // These two are seldom needed when using SPI0Command's pre_cmd argument
 inline
 SpiOpResult spi0_flash_write_volatile_enable(void) {
+  SFU_SPI0_COUNT();
   return SPI0Command(kVolatileWriteEnableCmd, NULL, 0u, 0);
 }
 inline
 SpiOpResult spi0_flash_write_enable(void) {
+  SFU_SPI0_COUNT();
   return SPI0Command(kWriteEnableCmd, NULL, 0u, 0);
 }
 
 inline
 SpiOpResult spi0_flash_write_disable() {
+  SFU_SPI0_COUNT();
   return SPI0Command(kWriteDisableCmd, NULL, 0u, 0);
 }
 
@@ -135,10 +168,12 @@ SpiOpResult spi0_flash_read_status_register(const size_t idx0, uint32_t *pStatus
     // panic();
     return SPI_RESULT_ERR;
   }
+  SFU_SPI0_COUNT();
   return SPI0Command(cmd, pStatus, 0u, 8u);
 }
 
-#if 0
+#if 0 || (RECLAIM_GPIO_EARLY == 2)
+// RECLAIM_GPIO_EARLY == 2, no SDK calls
 inline
 SpiOpResult spi0_flash_read_status_register_1(uint32_t *pStatus) {
   return spi0_flash_read_status_register(0, pStatus);
@@ -152,6 +187,7 @@ SpiOpResult spi0_flash_read_status_register_1(uint32_t *pStatus) {
 inline
 SpiOpResult spi0_flash_read_status_register_1(uint32_t *pStatus) {
   *pStatus = 0u;
+  SFU_SPI0_COUNT();
   // Use the version provided by the SDK - return enums are the same
   return (SpiOpResult)spi_flash_read_status(pStatus);
 }
@@ -166,8 +202,18 @@ SpiOpResult spi0_flash_read_status_register_3(uint32_t *pStatus) {
   return spi0_flash_read_status_register(2, pStatus);
 }
 
+/*
+  Write Enable (06h) or, for volatile_bit, Write Disable (04h) then Volatile
+  Write Enable (50h), the Status Register write, and when pVerify is not NULL, a
+  verify read with verify_cmd. All run back to back in one iCache disable
+  window. Nothing can slip in between the enable and the write.
+*/
+SpiOpResult spi0_flash_write_status_sequence(const uint8_t cmd, const uint32_t status,
+  const uint32_t non_volatile, const uint32_t numbits = 8u,
+  const uint8_t verify_cmd = 0u, uint32_t *pVerify = NULL);
+
 inline
-SpiOpResult spi0_flash_write_status_register(const uint32_t idx0, uint32_t status, const bool non_volatile, const uint32_t numbits = 8) {
+SpiOpResult spi0_flash_write_status_register(const uint32_t idx0, uint32_t status, const uint32_t non_volatile, const uint32_t numbits = 8) {
   uint8_t cmd = 0u;
   if (0u == idx0) {
     cmd = kWriteStatusRegister1Cmd;
@@ -179,43 +225,22 @@ SpiOpResult spi0_flash_write_status_register(const uint32_t idx0, uint32_t statu
     // panic();
     return SPI_RESULT_ERR;
   }
-
-  uint32_t prefix = kWriteEnableCmd;
-  if (! non_volatile) {
-    spi0_flash_write_disable();
-    prefix = kVolatileWriteEnableCmd;
-  }
-  return SPI0Command(cmd, &status, numbits, 0u, prefix);
+  return spi0_flash_write_status_sequence(cmd, status, non_volatile, numbits);
 }
 
 inline
-SpiOpResult spi0_flash_write_status_register_1(uint32_t status, const bool non_volatile, const uint32_t numbits=8) {
-  uint32_t prefix = kWriteEnableCmd;
-  if (! non_volatile) {
-    spi0_flash_write_disable();
-    prefix = kVolatileWriteEnableCmd;
-  }
-  return SPI0Command(kWriteStatusRegister1Cmd, &status, numbits, 0u, prefix);
+SpiOpResult spi0_flash_write_status_register_1(uint32_t status, const uint32_t non_volatile, const uint32_t numbits=8) {
+  return spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, status, non_volatile, numbits);
 }
 
 inline
-SpiOpResult spi0_flash_write_status_register_2(uint32_t status, const bool non_volatile) {
-  uint32_t prefix = kWriteEnableCmd;
-  if (! non_volatile) {
-    spi0_flash_write_disable();
-    prefix = kVolatileWriteEnableCmd;
-  }
-  return SPI0Command(kWriteStatusRegister2Cmd, &status, 8u, 0u, prefix);
+SpiOpResult spi0_flash_write_status_register_2(uint32_t status, const uint32_t non_volatile) {
+  return spi0_flash_write_status_sequence(kWriteStatusRegister2Cmd, status, non_volatile);
 }
 
 inline
-SpiOpResult spi0_flash_write_status_register_3(uint32_t status, const bool non_volatile) {
-  uint32_t prefix = kWriteEnableCmd;
-  if (! non_volatile) {
-    spi0_flash_write_disable();
-    prefix = kVolatileWriteEnableCmd;
-  }
-  return SPI0Command(kWriteStatusRegister3Cmd, &status, 8u, 0u, prefix);
+SpiOpResult spi0_flash_write_status_register_3(uint32_t status, const uint32_t non_volatile) {
+  return spi0_flash_write_status_sequence(kWriteStatusRegister3Cmd, status, non_volatile);
 }
 
 struct FlashAddr24 {
@@ -233,8 +258,59 @@ void spi_set_addr(uint8_t *buf, const uint32_t addr) {
 }
 
 
+// A read only SPI Flash instruction with up to 32 bits of response, such as
+// Read Status Register 05h, 35h, or 15h.
+struct Spi0ReadOp {
+  uint8_t cmd;
+  uint8_t miso_bits;          // 1 - 32
+};
+
+// Runs a list of read instructions inside one iCache disable window. Results
+// are stored at results[0 ... n-1], unused bits are cleared.
+// The ops and results arrays must be in DRAM, not PROGMEM, the iCache is off
+// while they are accessed.
+SpiOpResult spi0_flash_read_batch(const Spi0ReadOp *ops, uint32_t *results, const size_t n);
+
+// One step of a spi0_flash_sequence(). Each step sends the instruction byte,
+// then mosi_bits from data[i], then reads miso_bits back into data[i].
+struct Spi0Step {
+  uint8_t cmd;
+  uint8_t mosi_bits;          // 0 - 32
+  uint8_t miso_bits;          // 0 - 32
+  uint16_t post_us;           // delay after the step, or kSpi0WaitReady
+};
+
+// post_us value to poll Status Register-1 until WIP clears. The poll interval
+// starts at 1us and doubles up to 128us. Gives up after kSpi0WaitReadyTimeoutUs.
+constexpr uint16_t kSpi0WaitReady = 0xFFFFu;
+constexpr uint32_t kSpi0WaitReadyTimeoutUs = 50000u;
+
+// Runs all steps inside one iCache disable window with interrupts off. At the
+// end, waits for WIP to clear. data may be NULL when no step has a data phase.
+// The steps and data arrays must be in DRAM, not PROGMEM.
+// Returns SPI_RESULT_TIMEOUT when a kSpi0WaitReady poll timed out.
+SpiOpResult spi0_flash_sequence(const Spi0Step *steps, uint32_t *data, const size_t n);
+
+// Measured time of the last kSpi0WaitReady poll in spi0_flash_sequence().
+// 0 when the last sequence had no poll.
+uint32_t spi0_flash_last_ready_us(void);
+
 SpiOpResult spi0_flash_read_status_registers_2B(uint32_t *pStatus);
 SpiOpResult spi0_flash_read_status_registers_3B(uint32_t *pStatus);
+// Reads the register(s) a Status Register write with cmd and numbits covers.
+// pMask leaves out the read only WIP and WEL bits.
+SpiOpResult spi0_flash_read_status_for_write(const uint8_t cmd, const uint32_t numbits,
+  uint32_t *pStatus, uint32_t *pMask);
+
+// The registers a Status Register write covers, BIT0 SR1, BIT1 SR2, BIT2 SR3.
+// A 16-bit write with 01h covers SR1 and SR2.
+inline
+uint32_t spi0_flash_status_write_registers(const uint8_t cmd, const uint32_t numbits) {
+  if (kWriteStatusRegister1Cmd == cmd) return (8u < numbits) ? (BIT0 | BIT1) : BIT0;
+  if (kWriteStatusRegister2Cmd == cmd) return BIT1;
+  if (kWriteStatusRegister3Cmd == cmd) return BIT2;
+  return 0u;
+}
 
 /*
   Only call when the Flash supports 16-bit status register writes!
@@ -245,7 +321,7 @@ SpiOpResult spi0_flash_read_status_registers_3B(uint32_t *pStatus);
     * see spi0_flash_write_status_register(idx, status) for 8-bit writes.
 */
 inline
-SpiOpResult spi0_flash_write_status_registers_2B(uint32_t status16, const bool non_volatile) {
+SpiOpResult spi0_flash_write_status_registers_2B(uint32_t status16, const uint32_t non_volatile) {
   // Assume the flash supports 2B write if the SPIC2BSE bit is set.
   if (0u == (SPI0C & SPIC2BSE)) {
     DBG_SFU_PRINTF("\n* 2 Byte Status Write not enabled\n");
@@ -260,7 +336,7 @@ SpiOpResult spi0_flash_write_status_registers_2B(uint32_t status16, const bool n
 
 // Use for tightly sending two commands to the Flash. Like an enable instruction
 // followed by the action instruction. No other flash instruction get inserted
-// between them.
+// between them. A two step spi0_flash_sequence().
 void spi0_flash_command_pair(const uint8_t cmd1, const uint8_t cmd2, const uint32_t us = 0);
 
 inline
@@ -269,8 +345,13 @@ SpiOpResult spi0_flash_software_reset(uint32_t delay_us) {
   return SPI_RESULT_OK;
 }
 
+// Software reset without a guessed delay. After tRST minimum, polls WIP until
+// the part answers ready. elapsed_us, when not NULL, gets the measured time.
+SpiOpResult spi0_flash_software_reset_wait(uint32_t *elapsed_us);
+
 inline
 SpiOpResult spi0_flash_chip_erase() {
+  SFU_SPI0_COUNT();
   SpiOpResult ok0 = SPI0Command(kChipEraseCmd, NULL, 0u, 0u, kWriteEnableCmd);
   // On success - At return, all is unstable. Running on code cached before the
   // Flash was erased. When that runs out we crash.
@@ -280,13 +361,31 @@ SpiOpResult spi0_flash_chip_erase() {
 
 ////////////////////////////////////////////////////////////////////////////////
 // common 24 bit address reads with one dummpy byte.
+//
+// The SPI0 controller returns at most 64 bytes per transaction. Longer reads
+// are split into 64-byte chunks with the address advanced for each. sz must be
+// a multiple of 4.
+constexpr size_t kSpi0ReadChunkSize = 64u;
 SpiOpResult _spi0_flash_read_common(const uint32_t offset, uint32_t *p, const size_t sz, const uint8_t cmd);
 
+// Called once per chunk with the flash offset of p[0]. Return false to stop
+// the read early.
+typedef bool (*Spi0ReadChunkCb)(void *arg, const uint32_t offset, const uint32_t *p, const size_t sz);
+
+// Same as _spi0_flash_read_common() without a caller buffer for the full
+// length. Each chunk is handed to cb from a 64-byte stack buffer.
+SpiOpResult _spi0_flash_read_stream(const uint32_t offset, const size_t sz, const uint8_t cmd, Spi0ReadChunkCb cb, void *arg);
+
 inline
 SpiOpResult spi0_flash_read_sfdp(const uint32_t addr, uint32_t *p, const size_t sz) {
   return _spi0_flash_read_common(addr, p, sz, kReadSFDPCmd);
 }
 
+inline
+SpiOpResult spi0_flash_read_sfdp_stream(const uint32_t addr, const size_t sz, Spi0ReadChunkCb cb, void *arg) {
+  return _spi0_flash_read_stream(addr, sz, kReadSFDPCmd, cb, arg);
+}
+
 #if 1
 // Extra flash commands - not all flash support these or support them in the
 // same way. While this is true in general with SPI Flash, it may be more
@@ -316,17 +415,35 @@ SpiOpResult spi0_flash_read_secure_register(const uint32_t reg, const uint32_t o
   // reg range {1, 2, 3}
   return _spi0_flash_read_common((reg << 12u) + offset, p, sz, kReadSecurityRegisterCmd);
 }
+
+inline
+SpiOpResult spi0_flash_read_secure_register_stream(const uint32_t reg, const uint32_t offset, const size_t sz, Spi0ReadChunkCb cb, void *arg) {
+  // reg range {1, 2, 3}
+  return _spi0_flash_read_stream((reg << 12u) + offset, sz, kReadSecurityRegisterCmd, cb, arg);
+}
 #endif
 
+/*
+  RTC user memory access for the reclaim path. Blocks and return values are
+  the same as system_rtc_mem_read() and system_rtc_mem_write(). With
+  RECLAIM_GPIO_EARLY == 2, the RTC memory is accessed directly, without the
+  SDK.
+*/
+bool sfu_rtc_mem_read(const uint32_t block, void *p, const size_t sz);
+bool sfu_rtc_mem_write(const uint32_t block, const void *p, const size_t sz);
+
+// CPU clock in MHz, from the SDK or with RECLAIM_GPIO_EARLY == 2 the BootROM
+uint32_t sfu_cpu_freq_mhz(void);
+
 #if (RECLAIM_GPIO_EARLY == 2)
-// Use when Flash ID is needed before the NONOS_SDK has initialized; however,
-// with the current implementation of this library, the earliest we run is
-// `preinit()` (RECLAIM_GPIO_EARLY == 1). C++ class wrappers of SDK calls may
-// not work; however, direct SDK calls should. `alt_spi_flash_get_id()` works
-// when SDK has not fully initialized, but ICACHE_READ is enabled.
+// Use when Flash ID is needed before the NONOS_SDK has initialized, as from
+// `RF_PRE_INIT()`. Everything in the reclaim path then uses BootROM functions
+// and SPI0Command. `alt_spi_flash_get_id()` works when SDK has not fully
+// initialized, but ICACHE_READ is enabled.
 inline
 uint32_t alt_spi_flash_get_id(void) {
   uint32_t _id = 0u;
+  SFU_SPI0_COUNT();
   SpiOpResult ok0 = SPI0Command(kJedecId, &_id, 0u, 24u);
   return (SPI_RESULT_OK == ok0) ? _id : 0xFFFFFFFFu;
 }
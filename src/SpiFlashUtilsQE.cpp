@@ -18,6 +18,8 @@
 */
 #include <Arduino.h>
 #include <SpiFlashUtilsQE.h>
+#include "ReclaimRecipe.h"
+#include "ReclaimTiming.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,14 +51,14 @@ namespace experimental {
 //
 bool set_S6_QE_bit__8_bit_sr1_write_EN25Q32B_volatile();
 bool set_S6_QE_bit__8_bit_sr1_write_EN25Q32B_volatile(void) {
-  const bool non_volatile = volatile_bit;
+  const uint32_t non_volatile = volatile_bit;
   uint32_t status = 0u;
   spi0_flash_read_status_register_1(&status);
   bool is_set = (0u != (status & kQES6Bit));
   DBG_SFU_PRINTF("  %s bit %s set.\n", "S6/QE/WPDis", (is_set) ? "confirmed" : "NOT");
   if (is_set) return true;
 
-  DBG_SFU_PRINTF("  Setting %svolatile %s bit.\n", (non_volatile) ? "non-" : "", "S6/QE/WPDis");
+  DBG_SFU_PRINTF("  Setting %svolatile %s bit.\n", (non_volatile_bit == non_volatile) ? "non-" : "", "S6/QE/WPDis");
 
   SPI0Command(kEonOtpCmd, NULL, 0u, 0); // Enter EON's OTP mode
   status = kQES6Bit;
@@ -70,12 +72,17 @@ bool set_S6_QE_bit__8_bit_sr1_write_EN25Q32B_volatile(void) {
 // For the EON EN25Q32C flash, the S6 bit is refered to as Write Protect Disable
 // (WPDis)
 //C renamed set_S6_QE_bit_WPDis to set_S6_QE_bit__8_bit_sr1_write
-bool set_S6_QE_bit__8_bit_sr1_write(const bool non_volatile) {
+bool set_S6_QE_bit__8_bit_sr1_write(const uint32_t non_volatile) {
   uint32_t status = 0u;
   spi0_flash_read_status_register_1(&status);
+  RECLAIM_TIMING_STAMP(kReclaimPhaseStatusRead);
   bool is_set = (0u != (status & kQES6Bit));
   DBG_SFU_PRINTF("  %s bit %s set.\n", "S6/QE/WPDis", (is_set) ? "confirmed" : "NOT");
-  if (is_set) return true;
+  SFU_EVENT(kSfuEvtQeState, 6u, (is_set) ? 1u : 0u);
+  if (is_set) {
+    reclaim_recipe_note_qe(6u, 8u, non_volatile, status);
+    return true;
+  }
 
 #if PRESERVE_EXISTING_STATUS_BITS
   status |= kQES6Bit;
@@ -85,17 +92,26 @@ bool set_S6_QE_bit__8_bit_sr1_write(const bool non_volatile) {
   status = kQES6Bit;
 #endif
   // All changes made to the volatile copies of the Status Register-1.
-  DBG_SFU_PRINTF("  Setting %svolatile %s bit.\n", (non_volatile) ? "non-" : "", "S6/QE/WPDis");
-  spi0_flash_write_status_register_1(status, non_volatile);
-  return is_S6_QE();
+  DBG_SFU_PRINTF("  Setting %svolatile %s bit.\n", (non_volatile_bit == non_volatile) ? "non-" : "", "S6/QE/WPDis");
+  SFU_EVENT(kSfuEvtQeSet, 6u, sfu_event_width(8u, non_volatile));
+  // Write and verify read in one sequence
+  uint32_t verify = 0u;
+  spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, status, non_volatile, 8u, kReadStatusRegister1Cmd, &verify);
+  RECLAIM_TIMING_STAMP(kReclaimPhaseStatusWrite);
+  bool pass = (0u != (verify & kQES6Bit));
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "S6/QE/WPDis", (pass) ? "confirmed" : "NOT");
+  SFU_EVENT(kSfuEvtQeVerify, 6u, (pass) ? 1u : 0u);
+  if (pass) reclaim_recipe_note_qe(6u, 8u, non_volatile, status);
+  return pass;
 }
 
 //C renamed clear_S6_QE_bit_WPDis to clear_S6_QE_bit__8_bit_sr1_write
-bool clear_S6_QE_bit__8_bit_sr1_write(const bool non_volatile) {
+bool clear_S6_QE_bit__8_bit_sr1_write(const uint32_t non_volatile) {
   uint32_t status = 0u;
   spi0_flash_read_status_register_1(&status);
   bool not_set = (0u == (status & kQES6Bit));
   DBG_SFU_PRINTF("  %s bit %s set.\n", "S6/QE/WPDis", (not_set) ? "NOT" : "confirmed");
+  SFU_EVENT(kSfuEvtQeState, 6u, (! not_set) ? 1u : 0u);
   if (not_set) return true;
 
 #if PRESERVE_EXISTING_STATUS_BITS
@@ -106,17 +122,27 @@ bool clear_S6_QE_bit__8_bit_sr1_write(const bool non_volatile) {
   status = 0u;
 #endif
   // All changes made to the volatile copies of the Status Register-1.
-  DBG_SFU_PRINTF("  Clearing %svolatile S6/QE/WPDis bit - 8-bit write.\n", non_volatile ? "non-" : "");
-  spi0_flash_write_status_register_1(status, non_volatile);
-  return (false == is_S6_QE());
+  DBG_SFU_PRINTF("  Clearing %svolatile S6/QE/WPDis bit - 8-bit write.\n", (non_volatile_bit == non_volatile) ? "non-" : "");
+  SFU_EVENT(kSfuEvtQeClear, 6u, sfu_event_width(8u, non_volatile));
+  uint32_t verify = 0u;
+  spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, status, non_volatile, 8u, kReadStatusRegister1Cmd, &verify);
+  bool is_set = (0u != (verify & kQES6Bit));
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "S6/QE/WPDis", (is_set) ? "confirmed" : "NOT");
+  SFU_EVENT(kSfuEvtQeVerify, 6u, (! is_set) ? 1u : 0u);
+  return (false == is_set);
 }
 
-bool set_S9_QE_bit__8_bit_sr2_write(const bool non_volatile) {
+bool set_S9_QE_bit__8_bit_sr2_write(const uint32_t non_volatile) {
   uint32_t status2 = 0u;
   spi0_flash_read_status_register_2(&status2);
+  RECLAIM_TIMING_STAMP(kReclaimPhaseStatusRead);
   bool is_set = (0u != (status2 & kQES9Bit1B));
   DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (is_set) ? "confirmed" : "NOT");
-  if (is_set) return true;
+  SFU_EVENT(kSfuEvtQeState, 9u, (is_set) ? 1u : 0u);
+  if (is_set) {
+    reclaim_recipe_note_qe(9u, 8u, non_volatile, status2);
+    return true;
+  }
 
 #if PRESERVE_EXISTING_STATUS_BITS
   status2 |= kQES9Bit1B;
@@ -125,17 +151,29 @@ bool set_S9_QE_bit__8_bit_sr2_write(const bool non_volatile) {
   // to zero without much care we assume they can all be zero at the startup.
   status2 = kQES9Bit1B;
 #endif
-  DBG_SFU_PRINTF("  Setting %svolatile %s bit - %u-bit write.\n", (non_volatile) ? "non-" : "", "QE", 8u);
-  spi0_flash_write_status_register_2(status2, non_volatile);
-  return is_QE();
+  DBG_SFU_PRINTF("  Setting %svolatile %s bit - %u-bit write.\n", (non_volatile_bit == non_volatile) ? "non-" : "", "QE", 8u);
+  SFU_EVENT(kSfuEvtQeSet, 9u, sfu_event_width(8u, non_volatile));
+  uint32_t verify = 0u;
+  spi0_flash_write_status_sequence(kWriteStatusRegister2Cmd, status2, non_volatile, 8u, kReadStatusRegister2Cmd, &verify);
+  RECLAIM_TIMING_STAMP(kReclaimPhaseStatusWrite);
+  bool pass = (0u != (verify & kQES9Bit1B));
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (pass) ? "confirmed" : "NOT");
+  SFU_EVENT(kSfuEvtQeVerify, 9u, (pass) ? 1u : 0u);
+  if (pass) reclaim_recipe_note_qe(9u, 8u, non_volatile, status2);
+  return pass;
 }
 
-bool set_S9_QE_bit__16_bit_sr1_write(const bool non_volatile) {
+bool set_S9_QE_bit__16_bit_sr1_write(const uint32_t non_volatile) {
   uint32_t status = 0u;
   spi0_flash_read_status_registers_2B(&status);
+  RECLAIM_TIMING_STAMP(kReclaimPhaseStatusRead);
   bool is_set = (0u != (status & kQES9Bit2B));
   DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (is_set) ? "confirmed" : "NOT");
-  if (is_set) return true;
+  SFU_EVENT(kSfuEvtQeState, 9u, (is_set) ? 1u : 0u);
+  if (is_set) {
+    reclaim_recipe_note_qe(9u, 16u, non_volatile, status);
+    return true;
+  }
 
 #if PRESERVE_EXISTING_STATUS_BITS
   status |= kQES9Bit2B;
@@ -144,17 +182,25 @@ bool set_S9_QE_bit__16_bit_sr1_write(const bool non_volatile) {
   // to zero without much care we assume they can all be zero at the startup.
   status = kQES9Bit2B;
 #endif
-  DBG_SFU_PRINTF("  Setting %svolatile %s bit - %u-bit write.\n", (non_volatile) ? "non-" : "", "QE", 16u);
-  spi0_flash_write_status_registers_2B(status, non_volatile);
-  return is_QE();
+  DBG_SFU_PRINTF("  Setting %svolatile %s bit - %u-bit write.\n", (non_volatile_bit == non_volatile) ? "non-" : "", "QE", 16u);
+  SFU_EVENT(kSfuEvtQeSet, 9u, sfu_event_width(16u, non_volatile));
+  uint32_t verify = 0u;
+  spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, status, non_volatile, 16u, kReadStatusRegister2Cmd, &verify);
+  RECLAIM_TIMING_STAMP(kReclaimPhaseStatusWrite);
+  bool pass = (0u != (verify & kQES9Bit1B));
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (pass) ? "confirmed" : "NOT");
+  SFU_EVENT(kSfuEvtQeVerify, 9u, (pass) ? 1u : 0u);
+  if (pass) reclaim_recipe_note_qe(9u, 16u, non_volatile, status);
+  return pass;
 }
 
 
-bool clear_S9_QE_bit__8_bit_sr2_write(const bool non_volatile) {
+bool clear_S9_QE_bit__8_bit_sr2_write(const uint32_t non_volatile) {
   uint32_t status2 = 0u;
   spi0_flash_read_status_register_2(&status2);
   bool is_set = (0u != (status2 & kQES9Bit1B));
   DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (is_set) ? "confirmed" : "NOT");
+  SFU_EVENT(kSfuEvtQeState, 9u, (is_set) ? 1u : 0u);
   if (! is_set) return true;
 
 #if PRESERVE_EXISTING_STATUS_BITS
@@ -164,16 +210,22 @@ bool clear_S9_QE_bit__8_bit_sr2_write(const bool non_volatile) {
   // to zero without much care we assume they can all be zero at the startup.
   status2 = 0u;
 #endif
-  DBG_SFU_PRINTF("  Clear %svolatile %s bit - %u-bit write.\n", (non_volatile) ? "non-" : "", "QE", 8u);
-  spi0_flash_write_status_register_2(status2, non_volatile);
-  return (false == is_QE());
+  DBG_SFU_PRINTF("  Clear %svolatile %s bit - %u-bit write.\n", (non_volatile_bit == non_volatile) ? "non-" : "", "QE", 8u);
+  SFU_EVENT(kSfuEvtQeClear, 9u, sfu_event_width(8u, non_volatile));
+  uint32_t verify = 0u;
+  spi0_flash_write_status_sequence(kWriteStatusRegister2Cmd, status2, non_volatile, 8u, kReadStatusRegister2Cmd, &verify);
+  bool still_set = (0u != (verify & kQES9Bit1B));
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (still_set) ? "confirmed" : "NOT");
+  SFU_EVENT(kSfuEvtQeVerify, 9u, (! still_set) ? 1u : 0u);
+  return (false == still_set);
 }
 
-bool clear_S9_QE_bit__16_bit_sr1_write(const bool non_volatile) {
+bool clear_S9_QE_bit__16_bit_sr1_write(const uint32_t non_volatile) {
   uint32_t status = 0u;
   spi0_flash_read_status_registers_2B(&status);
   bool is_set = (0u != (status & kQES9Bit2B));
   DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (is_set) ? "confirmed" : "NOT");
+  SFU_EVENT(kSfuEvtQeState, 9u, (is_set) ? 1u : 0u);
   if (! is_set) return true;
 
 #if PRESERVE_EXISTING_STATUS_BITS
@@ -183,9 +235,14 @@ bool clear_S9_QE_bit__16_bit_sr1_write(const bool non_volatile) {
   // to zero without much care we assume they can all be zero at the startup.
   status = 0u;
 #endif
-  DBG_SFU_PRINTF("  Setting %svolatile %s bit - %u-bit write.\n", (non_volatile) ? "non-" : "", "QE", 16u);
-  spi0_flash_write_status_registers_2B(status, non_volatile);
-  return (false == is_QE());
+  DBG_SFU_PRINTF("  Setting %svolatile %s bit - %u-bit write.\n", (non_volatile_bit == non_volatile) ? "non-" : "", "QE", 16u);
+  SFU_EVENT(kSfuEvtQeClear, 9u, sfu_event_width(16u, non_volatile));
+  uint32_t verify = 0u;
+  spi0_flash_write_status_sequence(kWriteStatusRegister1Cmd, status, non_volatile, 16u, kReadStatusRegister2Cmd, &verify);
+  bool still_set = (0u != (verify & kQES9Bit1B));
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "QE", (still_set) ? "confirmed" : "NOT");
+  SFU_EVENT(kSfuEvtQeVerify, 9u, (! still_set) ? 1u : 0u);
+  return (false == still_set);
 }
 
 
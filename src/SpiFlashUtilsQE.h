@@ -108,7 +108,7 @@ bool is_WEL(void) {
 inline
 bool is_WEL_dbg(void) {
   bool success = verify_status_register_1(kWELBit);
-  ets_uart_printf("  %s bit %s set.\n", "WEL", (success) ? "confirmed" : "NOT");
+  DBG_SFU_PRINTF("  %s bit %s set.\n", "WEL", (success) ? "confirmed" : "NOT");
   return success;
 }
 
@@ -145,12 +145,12 @@ bool is_spi0_quad(void) {
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-bool set_S6_QE_bit__8_bit_sr1_write(const bool non_volatile);
-bool set_S9_QE_bit__8_bit_sr2_write(const bool non_volatile);
-bool set_S9_QE_bit__16_bit_sr1_write(const bool non_volatile);
-bool clear_S6_QE_bit__8_bit_sr1_write(const bool non_volatile);
-bool clear_S9_QE_bit__8_bit_sr2_write(const bool non_volatile);
-bool clear_S9_QE_bit__16_bit_sr1_write(const bool non_volatile);
+bool set_S6_QE_bit__8_bit_sr1_write(const uint32_t non_volatile);
+bool set_S9_QE_bit__8_bit_sr2_write(const uint32_t non_volatile);
+bool set_S9_QE_bit__16_bit_sr1_write(const uint32_t non_volatile);
+bool clear_S6_QE_bit__8_bit_sr1_write(const uint32_t non_volatile);
+bool clear_S9_QE_bit__8_bit_sr2_write(const uint32_t non_volatile);
+bool clear_S9_QE_bit__16_bit_sr1_write(const uint32_t non_volatile);
 
 
 #if 0
@@ -0,0 +1,147 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Status Register Non-Volatile Commit - see SrNvCommit.h
+*/
+#include <Arduino.h>
+#include "SpiFlashUtils.h"    // sfu_rtc_mem_read()
+#include "SrNvCommit.h"
+
+extern "C" {
+
+namespace experimental {
+
+constexpr uint32_t kNvCommitMagic = 0x4E56434Du;  // "NVCM"
+
+static uint32_t nv_commit_chksum(const SrNvCommit *commit) {
+  uint32_t sum = kNvCommitMagic;
+  for (size_t i = 0u; i < 3u; i++) {
+    sum = ((sum << 5u) | (sum >> 27u)) ^ commit->u32[i];
+  }
+  return sum;
+}
+
+bool sr_nv_commit_get(SrNvCommit *commit) {
+  if (sfu_rtc_mem_read(FLASH_SR_NV_COMMIT_RTC_BLOCK, &commit->u32[0], sizeof(SrNvCommit)) &&
+      nv_commit_chksum(commit) == commit->chksum) {
+    return true;
+  }
+  memset(&commit->u32[0], 0, sizeof(SrNvCommit));
+  return false;
+}
+
+static void nv_commit_save(SrNvCommit *commit) {
+  commit->chksum = nv_commit_chksum(commit);
+  sfu_rtc_mem_write(FLASH_SR_NV_COMMIT_RTC_BLOCK, &commit->u32[0], sizeof(SrNvCommit));
+}
+
+void sr_nv_commit_reset(void) {
+  SrNvCommit commit;
+  sr_nv_commit_get(&commit);
+  // Still describes the flash, not a count
+  const uint32_t vol_active = commit.vol_active;
+  memset(&commit.u32[0], 0, sizeof(SrNvCommit));
+  commit.vol_active = vol_active;
+  nv_commit_save(&commit);
+}
+
+#if FLASH_SR_NV_COMMIT
+static bool nv_commit_same(const SrNvCommit *commit, const uint8_t cmd,
+  const uint32_t status, const uint32_t numbits, const uint32_t mask) {
+  return cmd == commit->cmd && numbits == commit->numbits &&
+         (status & mask) == (commit->status & mask);
+}
+
+SrNvCommitAction sr_nv_commit_begin(const uint8_t cmd, const uint32_t status, const uint32_t numbits) {
+  uint32_t current = 0u;
+  uint32_t mask = 0u;
+  const bool have_current =
+    (SPI_RESULT_OK == spi0_flash_read_status_for_write(cmd, numbits, &current, &mask));
+
+  SrNvCommit commit;
+  sr_nv_commit_get(&commit);
+  const uint32_t regs = spi0_flash_status_write_registers(cmd, numbits);
+  if (! nv_commit_same(&commit, cmd, status, numbits, mask)) {
+    // A different register or value, start over. The totals are kept.
+    commit.status = status & mask;
+    commit.cmd = cmd;
+    commit.numbits = numbits;
+    commit.state = kSrNvCommitIdle;
+  }
+
+  SrNvCommitAction action = kSrNvCommitWrite;
+  if (commit.vol_active & regs) {
+    // The read shows the volatile value, not the non-volatile copy
+    commit.state = kSrNvCommitPending;
+  } else if (have_current && (current & mask) == (status & mask)) {
+    // Committed, or a pending write that finished before the reset
+    if (UINT16_MAX > commit.skipped) commit.skipped++;
+    commit.state = kSrNvCommitDone;
+    action = kSrNvCommitSkip;
+    DBG_SFU_PRINTF("  Status Register already 0x%02X, non-volatile write skipped.\n", current);
+  } else {
+    // Phase 1
+    if (kSrNvCommitDone == commit.state) {
+      // Something else wrote the register since the commit
+      if (UINT16_MAX > commit.rewrites) commit.rewrites++;
+      action = kSrNvCommitRewrite;
+      DBG_SFU_PRINTF("  Status Register 0x%02X lost its committed value, %u rewrites.\n",
+        current, commit.rewrites);
+    }
+    commit.state = kSrNvCommitPending;
+  }
+  nv_commit_save(&commit);
+  SFU_EVENT(kSfuEvtNvCommit, action, current);
+  return action;
+}
+
+SpiOpResult sr_nv_commit_end(const uint8_t cmd, const uint32_t status, const uint32_t numbits) {
+  // Phase 2, a separate transaction from the write. WEL should already be
+  // clear; make sure a part that left it set cannot take a stray write.
+  spi0_flash_write_disable();
+  uint32_t current = 0u;
+  uint32_t mask = 0u;
+  SpiOpResult ok0 = spi0_flash_read_status_for_write(cmd, numbits, &current, &mask);
+  const bool verified = (SPI_RESULT_OK == ok0 && (current & mask) == (status & mask));
+  SFU_EVENT(kSfuEvtNvVerify, (verified) ? 1u : 0u, current);
+  if (! verified) {
+    DBG_SFU_PRINTF("  Non-volatile write of 0x%02X reads back 0x%02X, not committed.\n", status, current);
+    return SPI_RESULT_ERR;
+  }
+
+  SrNvCommit commit;
+  sr_nv_commit_get(&commit);
+  // The non-volatile write also loaded the volatile copy
+  commit.vol_active &= ~spi0_flash_status_write_registers(cmd, numbits);
+  if (nv_commit_same(&commit, cmd, status, numbits, mask)) {
+    commit.state = kSrNvCommitDone;
+    if (UINT16_MAX > commit.writes) commit.writes++;
+  }
+  nv_commit_save(&commit);
+  return SPI_RESULT_OK;
+}
+
+void sr_nv_commit_note_volatile(const uint8_t cmd, const uint32_t numbits) {
+  SrNvCommit commit;
+  sr_nv_commit_get(&commit);
+  commit.vol_active |= spi0_flash_status_write_registers(cmd, numbits);
+  nv_commit_save(&commit);
+}
+#endif // FLASH_SR_NV_COMMIT
+
+};  // namespace experimental {
+
+};
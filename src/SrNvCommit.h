@@ -0,0 +1,120 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Status Register Non-Volatile Commit
+
+  Enable with build option `-DFLASH_SR_NV_COMMIT=1`.
+
+  For parts without a volatile Status Register, the QE bit must be written
+  non-volatile, and each write costs tW and an endurance cycle. This makes
+  every non-volatile `spi0_flash_write_status_sequence()` a two-phase commit
+  with a marker in RTC user memory:
+
+    1. Prepare - the marker is saved as pending with the command and value.
+    2. Write, then clear WEL and read the registers back in a separate
+       transaction. Only when they hold the value is the marker saved as
+       committed.
+
+  Before a later write of the same value, one read checks the hardware. When
+  it agrees, nothing is written. A pending marker left by a crash or reset in
+  the middle of tW is settled by the same read. The read returns the active
+  value. Registers with a volatile write since the last non-volatile write are
+  marked, and a non-volatile write to a marked register is never skipped.
+
+  When the marker says committed and the hardware disagrees, something else
+  rewrote the register, like the BootROM's 16-bit Disable_QMode at each boot.
+  The write always goes out, and it is counted in `rewrites` and logged with
+  kSfuEvtNvCommit as kSrNvCommitRewrite. A count that grows every boot means
+  an endurance cycle every boot; use the volatile QE bit where the part has
+  one.
+
+  The marker does not survive a power cycle; the non-volatile bits do. After a
+  power-up the read alone decides, and a missing bit costs one write.
+
+  Do not use with the Analyze example or other code that needs every write to
+  reach the flash.
+*/
+#ifndef EXPERIMENTAL_SR_NV_COMMIT_H
+#define EXPERIMENTAL_SR_NV_COMMIT_H
+
+#if ((1 - FLASH_SR_NV_COMMIT - 1) == 2)
+#undef FLASH_SR_NV_COMMIT
+#define FLASH_SR_NV_COMMIT 1
+#endif
+
+// The 4 blocks below DeviceFingerprint, `ESP.rtcUserMemory` offset 107 - 110.
+#ifndef FLASH_SR_NV_COMMIT_RTC_BLOCK
+#define FLASH_SR_NV_COMMIT_RTC_BLOCK 171u
+#endif
+
+#include <stdint.h>
+#include <spi_flash.h>    // SpiOpResult
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+enum SrNvCommitState : uint8_t {
+  kSrNvCommitIdle = 0u,
+  kSrNvCommitPending,             // Write started, not verified
+  kSrNvCommitDone                 // Written and read back
+};
+
+// What spi0_flash_write_status_sequence() should do
+enum SrNvCommitAction : uint8_t {
+  kSrNvCommitWrite = 0u,
+  kSrNvCommitSkip,                // The hardware already holds the value
+  kSrNvCommitRewrite              // Write, the committed value was lost
+};
+
+union SrNvCommit {
+  struct {
+    uint32_t status:16;           // Value written, WIP and WEL left out
+    uint32_t cmd:8;               // Write Status Register command
+    uint32_t numbits:8;
+    uint32_t state:8;             // SrNvCommitState
+    uint32_t vol_active:8;        // SR1 - SR3 bits, a volatile write is active,
+                                  // kept by sr_nv_commit_reset()
+    uint32_t rewrites:16;         // Committed value found lost and written again,
+                                  // any register; kept until sr_nv_commit_reset()
+    uint32_t writes:16;           // Committed writes
+    uint32_t skipped:16;          // Writes skipped, the hardware agreed
+    uint32_t chksum;
+  };
+  uint32_t u32[4];
+};
+
+// Returns false and a zeroed record when RTC memory was not valid.
+bool sr_nv_commit_get(SrNvCommit *commit);
+void sr_nv_commit_reset(void);
+
+// Used by spi0_flash_write_status_sequence() for non-volatile writes
+SrNvCommitAction sr_nv_commit_begin(const uint8_t cmd, const uint32_t status, const uint32_t numbits);
+// After the write succeeds. Phase 2, returns SPI_RESULT_ERR when the read back
+// does not match; the marker stays pending.
+SpiOpResult sr_nv_commit_end(const uint8_t cmd, const uint32_t status, const uint32_t numbits);
+// After a volatile write succeeds
+void sr_nv_commit_note_volatile(const uint8_t cmd, const uint32_t numbits);
+
+};  // namespace experimental {
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPERIMENTAL_SR_NV_COMMIT_H
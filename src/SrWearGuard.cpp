@@ -0,0 +1,101 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Status Register Wear Guard - see SrWearGuard.h
+*/
+#include <Arduino.h>
+#include "SpiFlashUtils.h"    // sfu_rtc_mem_read()
+#include "SrWearGuard.h"
+
+extern "C" {
+
+namespace experimental {
+
+constexpr uint32_t kWearMagic = 0x57454152u;  // "WEAR"
+
+static uint32_t wear_chksum(const SrWearCounters *counters) {
+  uint32_t sum = kWearMagic;
+  for (size_t i = 0u; i < 3u; i++) {
+    sum = ((sum << 5u) | (sum >> 27u)) ^ counters->u32[i];
+  }
+  return sum;
+}
+
+bool sr_wear_get_counters(SrWearCounters *counters) {
+  if (sfu_rtc_mem_read(FLASH_SR_WEAR_RTC_BLOCK, &counters->u32[0], sizeof(SrWearCounters)) &&
+      wear_chksum(counters) == counters->chksum) {
+    return true;
+  }
+  memset(&counters->u32[0], 0, sizeof(SrWearCounters));
+  return false;
+}
+
+static void wear_save(SrWearCounters *counters) {
+  counters->chksum = wear_chksum(counters);
+  sfu_rtc_mem_write(FLASH_SR_WEAR_RTC_BLOCK, &counters->u32[0], sizeof(SrWearCounters));
+}
+
+void sr_wear_reset_counters(void) {
+  SrWearCounters counters;
+  sr_wear_get_counters(&counters);
+  // Still describes the flash, not a count
+  const uint8_t vol_active = counters.vol_active;
+  memset(&counters.u32[0], 0, sizeof(SrWearCounters));
+  counters.vol_active = vol_active;
+  wear_save(&counters);
+}
+
+#if FLASH_SR_WEAR_GUARD
+bool sr_wear_guard_skip(const uint8_t cmd, const uint32_t status, const uint32_t numbits, const bool non_volatile) {
+  SrWearCounters counters;
+  sr_wear_get_counters(&counters);
+  // The read would show the volatile value, not the non-volatile copy
+  if (non_volatile && (counters.vol_active & spi0_flash_status_write_registers(cmd, numbits))) return false;
+
+  uint32_t current = 0u;
+  uint32_t mask = 0u;
+  SpiOpResult ok0 = spi0_flash_read_status_for_write(cmd, numbits, &current, &mask);
+  if (SPI_RESULT_OK != ok0 || (current & mask) != (status & mask)) return false;
+
+  if (UINT16_MAX > counters.skipped) counters.skipped++;
+  wear_save(&counters);
+  DBG_SFU_PRINTF("  Status Register already 0x%02X, write skipped.\n", current);
+  SFU_EVENT(kSfuEvtSrWriteSkipped, cmd, current);
+  return true;
+}
+
+void sr_wear_note_write(const uint8_t cmd, const uint32_t numbits, const bool non_volatile) {
+  uint32_t regs = spi0_flash_status_write_registers(cmd, numbits);
+  if (0u == regs) return;
+
+  SrWearCounters counters;
+  sr_wear_get_counters(&counters);
+  if (non_volatile) {
+    // The non-volatile write also loads the volatile copy
+    counters.vol_active &= ~regs;
+    for (size_t i = 0u; i < 3u; i++) {
+      if ((regs & (1u << i)) && UINT16_MAX > counters.nv_writes[i]) counters.nv_writes[i]++;
+    }
+  } else {
+    counters.vol_active |= regs;
+  }
+  wear_save(&counters);
+}
+#endif // FLASH_SR_WEAR_GUARD
+
+};  // namespace experimental {
+
+};
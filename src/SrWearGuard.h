@@ -0,0 +1,84 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Status Register Wear Guard
+
+  Enable with build option `-DFLASH_SR_WEAR_GUARD=1`.
+
+  Every `spi0_flash_write_status_register*()` call first reads the register it
+  is about to write. When the value already matches, the write is skipped. This
+  saves the write time (tW, up to 15ms while the flash is busy) and, for
+  non-volatile writes, an endurance cycle.
+
+  Non-volatile writes that do go out are counted per register in RTC user
+  memory. The counts are kept across deep sleep and soft restarts, not across a
+  power cycle. To keep a lifetime total, read them with
+  `sr_wear_get_counters()`, save them with your own storage, then call
+  `sr_wear_reset_counters()`.
+
+  The read returns the active value. After a volatile write, the non-volatile
+  copy may differ from what is read back. Registers with a volatile write since
+  the last non-volatile write are marked in RTC memory, and a non-volatile write
+  to a marked register is never skipped. A power cycle loads the non-volatile
+  copy and clears the marks. Do not use with the Analyze example or other code
+  that needs every write to reach the flash.
+*/
+#ifndef EXPERIMENTAL_SR_WEAR_GUARD_H
+#define EXPERIMENTAL_SR_WEAR_GUARD_H
+
+#if ((1 - FLASH_SR_WEAR_GUARD - 1) == 2)
+#undef FLASH_SR_WEAR_GUARD
+#define FLASH_SR_WEAR_GUARD 1
+#endif
+
+// The 4 blocks below the reclaim recipe, `ESP.rtcUserMemory` offset 120 - 123.
+#ifndef FLASH_SR_WEAR_RTC_BLOCK
+#define FLASH_SR_WEAR_RTC_BLOCK 184u
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+union SrWearCounters {
+  struct {
+    uint16_t nv_writes[3];      // non-volatile writes to SR1, SR2, SR3
+    uint16_t skipped;           // writes skipped, the register already matched
+    uint8_t vol_active;         // SR1 - SR3 bits, a volatile write is active,
+                                // kept by sr_wear_reset_counters()
+    uint8_t reserved[3];
+    uint32_t chksum;
+  };
+  uint32_t u32[4];
+};
+
+// Returns false and zeroed counters when RTC memory was not valid.
+bool sr_wear_get_counters(SrWearCounters *counters);
+void sr_wear_reset_counters(void);
+
+// Used by spi0_flash_write_status_sequence()
+bool sr_wear_guard_skip(const uint8_t cmd, const uint32_t status, const uint32_t numbits, const bool non_volatile);
+void sr_wear_note_write(const uint8_t cmd, const uint32_t numbits, const bool non_volatile);
+
+};  // namespace experimental {
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPERIMENTAL_SR_WEAR_GUARD_H
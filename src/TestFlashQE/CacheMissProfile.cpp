@@ -0,0 +1,170 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  iCache miss cost profiler - see CacheMissProfile.h
+*/
+#include <Arduino.h>
+#include <SpiFlashUtilsQE.h>  // is_spi0_quad()
+#include "CacheMissProfile.h"
+
+extern "C" {
+
+constexpr uintptr_t kFlashWindow = 0x40200000u;
+// Larger than the iCache
+constexpr size_t kEvictSpan = 0x10000u;
+constexpr size_t kEvictStride = 16u;
+// Strided load span, fits in the iCache so the warm pass is all hits
+constexpr size_t kStrideSpan = 0x2000u;
+constexpr size_t kMaxStride = 128u;
+
+#define CACHE_CODE_BLOCK() __asm__ __volatile__(".rept 1024\n\tnop.n\n\t.endr")
+constexpr uint32_t kCodeBlockBytes = 1024u * 2u;
+
+static void __attribute__((noinline)) code_block_flash(void *) {
+  CACHE_CODE_BLOCK();
+}
+
+static void IRAM_ATTR __attribute__((noinline)) code_block_iram(void *) {
+  CACHE_CODE_BLOCK();
+}
+
+// 64 KB away from the span being measured, inside the 1 MB window
+static uintptr_t evict_base(const uintptr_t addr) {
+  return ((addr - kFlashWindow + 0x10000u) & 0xF0000u) + kFlashWindow;
+}
+
+static void IRAM_ATTR cache_evict(const uintptr_t addr) {
+  const uintptr_t start = evict_base(addr);
+  for (size_t i = 0u; i < kEvictSpan; i += kEvictStride) {
+    (void)*(const volatile uint32_t *)(start + i);
+  }
+}
+
+static uint32_t IRAM_ATTR time_strided(const uintptr_t start, const size_t stride) {
+  const uint32_t saved_ps = xt_rsil(15);
+  const uint32_t t0 = esp_get_cycle_count();
+  for (size_t i = 0u; i < kStrideSpan; i += stride) {
+    (void)*(const volatile uint32_t *)(start + i);
+  }
+  const uint32_t cycles = esp_get_cycle_count() - t0;
+  xt_wsr_ps(saved_ps);
+  return cycles;
+}
+
+static uint32_t IRAM_ATTR time_call(CacheProfileFn fn, void *arg) {
+  const uint32_t saved_ps = xt_rsil(15);
+  const uint32_t t0 = esp_get_cycle_count();
+  fn(arg);
+  const uint32_t cycles = esp_get_cycle_count() - t0;
+  xt_wsr_ps(saved_ps);
+  return cycles;
+}
+
+static uint32_t IRAM_ATTR time_call_cold(CacheProfileFn fn, void *arg) {
+  cache_evict((uintptr_t)fn);
+  return time_call(fn, arg);
+}
+
+// Cycles per load after an eviction
+static uint32_t cold_load_cycles(const uintptr_t start, const size_t stride) {
+  cache_evict(start);
+  return time_strided(start, stride) / (kStrideSpan / stride);
+}
+
+static uint32_t flash_mhz_from_spi0clk(const uint32_t spi0clk) {
+  if (spi0clk & SPICLK_EQU_SYSCLK) return 80u;
+  return 80u / (((spi0clk >> SPICLKCN) & SPIMCLKCN) + 1u);
+}
+
+static const char *spi0_mode_name(const uint32_t spi0c) {
+  if (spi0c & SPICQIO) return "QIO";
+  if (spi0c & SPICQOUT) return "QOUT";
+  if (spi0c & SPICDIO) return "DIO";
+  if (spi0c & SPICDOUT) return "DOUT";
+  return (spi0c & SPICFASTRD) ? "FAST" : "SLOW";
+}
+
+bool cache_miss_measure(CacheMissCost *cost) {
+  memset(cost, 0, sizeof(CacheMissCost));
+  cost->spi0c = SPI0C;
+  cost->flash_mhz = flash_mhz_from_spi0clk(SPI0CLK);
+  cost->quad = (experimental::is_spi0_quad()) ? 1u : 0u;
+
+  // Sketch code, always in the flash window
+  const uintptr_t start = (uintptr_t)&code_block_flash & ~(kStrideSpan - 1u);
+  const uint32_t ref = cold_load_cycles(start, kMaxStride);
+  for (size_t stride = 4u; stride <= kMaxStride; stride <<= 1u) {
+    if (cold_load_cycles(start, stride) * 10u >= ref * 9u) {
+      cost->line_bytes = stride;
+      break;
+    }
+  }
+  if (0u == cost->line_bytes) return false;
+
+  time_strided(start, cost->line_bytes);
+  cost->hit_cycles = time_strided(start, cost->line_bytes) / (kStrideSpan / cost->line_bytes);
+  cost->miss_cycles = (ref > cost->hit_cycles) ? ref - cost->hit_cycles : 0u;
+
+  cost->code_bytes = kCodeBlockBytes;
+  cost->flash_cold_cycles = time_call_cold(code_block_flash, nullptr);
+  cost->flash_warm_cycles = time_call(code_block_flash, nullptr);
+  time_call(code_block_iram, nullptr);
+  cost->iram_cycles = time_call(code_block_iram, nullptr);
+  yield();
+  return true;
+}
+
+void cache_profile_fn(CacheProfileFn fn, void *arg, const CacheMissCost *cost, CacheFnProfile *profile) {
+  fn(arg);
+  profile->cold_cycles = time_call_cold(fn, arg);
+  profile->warm_cycles = time_call(fn, arg);
+  const uint32_t extra = (profile->cold_cycles > profile->warm_cycles)
+                       ? profile->cold_cycles - profile->warm_cycles : 0u;
+  profile->est_lines = (cost->miss_cycles) ? extra / cost->miss_cycles : 0u;
+  profile->iram_candidate = (extra > profile->warm_cycles);
+  yield();
+}
+
+void cache_miss_print(const CacheMissCost *cost) {
+  Serial.printf_P(PSTR("  SPI0 read mode %s at %u MHz%s\r\n"), spi0_mode_name(cost->spi0c),
+    cost->flash_mhz, (cost->quad) ? ", GPIO9 and GPIO10 are used by the flash" : "");
+  Serial.printf_P(PSTR("  Cache line %u bytes, line fill %u cycles, hit %u cycles\r\n"),
+    cost->line_bytes, cost->miss_cycles, cost->hit_cycles);
+  Serial.printf_P(PSTR("  %u byte code block: flash cold %u, flash warm %u, IRAM %u cycles\r\n"),
+    cost->code_bytes, cost->flash_cold_cycles, cost->flash_warm_cycles, cost->iram_cycles);
+  if (cost->line_bytes) {
+    const uint32_t lines = cost->code_bytes / cost->line_bytes;
+    const uint32_t extra = (cost->flash_cold_cycles > cost->flash_warm_cycles)
+                         ? cost->flash_cold_cycles - cost->flash_warm_cycles : 0u;
+    Serial.printf_P(PSTR("  Code fetch: %u cycles per line fill over %u lines\r\n"),
+      (lines) ? extra / lines : 0u, lines);
+  }
+}
+
+void cache_profile_print_header(void) {
+  Serial.printf_P(PSTR("  %-22s %8s %8s %6s %8s %s\r\n"),
+    "Function", "cold", "warm", "lines", "cold us", "suggest");
+}
+
+void cache_profile_print_row(const char *name, const CacheFnProfile *profile, const uint32_t cpu_mhz) {
+  const uint32_t mhz = (cpu_mhz) ? cpu_mhz : 80u;
+  Serial.printf_P(PSTR("  %-22s %8u %8u %6u %5u.%02u %s\r\n"), name,
+    profile->cold_cycles, profile->warm_cycles, profile->est_lines,
+    profile->cold_cycles / mhz, (profile->cold_cycles % mhz) * 100u / mhz,
+    (profile->iram_candidate) ? "IRAM_ATTR" : "");
+}
+
+};
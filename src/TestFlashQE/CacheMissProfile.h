@@ -0,0 +1,77 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  iCache miss cost profiler - what DIO or DOUT costs the code running from flash
+
+  `cache_miss_measure()` fills the cache line by line with strided loads from
+  flash after evicting it, to find the line size and the cycles per line fill
+  at the current SPI0 read mode and clock. It then runs the same 2 KB block of
+  straight-line code from flash, cold and warm, and from IRAM.
+
+  `cache_profile_fn()` times one of your functions cold, right after an
+  eviction, and warm. The difference divided by the line fill cost is about
+  the number of cache lines the call touches. When the cold call costs more
+  than twice the warm call, the function is flagged as an IRAM candidate. A
+  function that runs once per wake, or after WiFi or a flash write has
+  evicted it, pays the cold cost every time.
+
+  Interrupts are masked while timing. All timing code is in IRAM.
+*/
+#ifndef TESTFLASHQE_CACHE_MISS_PROFILE_H
+#define TESTFLASHQE_CACHE_MISS_PROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct CacheMissCost {
+  uint32_t line_bytes;          // Smallest stride where the cost per load stops growing
+  uint32_t miss_cycles;         // CCOUNT cycles per line fill, less a hit
+  uint32_t hit_cycles;          // CCOUNT cycles per cached load
+  uint32_t code_bytes;          // Size of the synthetic code block
+  uint32_t flash_cold_cycles;   // Block from flash after an eviction
+  uint32_t flash_warm_cycles;   // Block from flash, run again
+  uint32_t iram_cycles;         // Same block from IRAM
+  uint32_t spi0c;               // SPI0C at the time of measure
+  uint8_t flash_mhz;
+  uint8_t quad;                 // is_spi0_quad()
+};
+
+struct CacheFnProfile {
+  uint32_t cold_cycles;
+  uint32_t warm_cycles;
+  uint32_t est_lines;           // (cold - warm) / miss_cycles
+  bool iram_candidate;
+};
+
+typedef void (*CacheProfileFn)(void *arg);
+
+bool cache_miss_measure(CacheMissCost *cost);
+
+// cost from cache_miss_measure(). fn is called 3 times: warm up, cold, warm.
+void cache_profile_fn(CacheProfileFn fn, void *arg, const CacheMissCost *cost, CacheFnProfile *profile);
+
+void cache_miss_print(const CacheMissCost *cost);
+void cache_profile_print_header(void);
+void cache_profile_print_row(const char *name, const CacheFnProfile *profile, const uint32_t cpu_mhz);
+
+#ifdef __cplusplus
+};
+#endif
+#endif // TESTFLASHQE_CACHE_MISS_PROFILE_H
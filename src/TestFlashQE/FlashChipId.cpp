@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <FlashChipId_D8.h>
 #include "FlashChipId.h"
+#include <FlashPartTable.h>
 
 // missing from spi_vendors.h
 #ifndef SPI_FLASH_VENDOR_BERGMICRO
@@ -16,49 +17,60 @@
 ////////////////////////////////////////////////////////////////////////////////
 // Print popular Flash Chip IDs
 // Manufacturer strings extracted from comments in esp8266/bootloaders/eboot/spi_vendors.h
+// The names and the table are in PROGMEM, none of it takes DRAM.
+#define FLASH_VENDOR_LIST(X) \
+  X(ALLIANCE,    /* 0x52 */ "Alliance Semiconductor") \
+  X(AMD,         /* 0x01 */ "AMD") \
+  X(AMIC,        /* 0x37 */ "AMIC") \
+  X(ATMEL,       /* 0x1F */ "Atmel (now used by Adesto)") \
+  X(BERGMICRO,   /* 0xE0 */ "BergMicro") \
+  X(BRIGHT,      /* 0xAD */ "Bright Microelectronics") \
+  X(CATALYST,    /* 0x31 */ "Catalyst") \
+  X(EON,         /* 0x1C */ "EON Silicon Devices, missing 0x7F prefix") \
+  X(ESMT,        /* 0x8C */ "Elite Semiconductor Memory Technology (ESMT) / EFST Elite Flash Storage") \
+  X(EXCEL,       /* 0x4A */ "ESI, missing 0x7F prefix") \
+  X(FIDELIX,     /* 0xF8 */ "Fidelix") \
+  X(FUJITSU,     /* 0x04 */ "Fujitsu") \
+  X(GIGADEVICE,  /* 0xC8 */ "GigaDevice") \
+  X(HYUNDAI,     /* 0xAD */ "Hyundai") \
+  X(INTEL,       /* 0x89 */ "Intel") \
+  X(ISSI,        /* 0xD5 */ "ISSI Integrated Silicon Solutions, see also PMC.") /* Bank1 */ \
+  X(MACRONIX,    /* 0xC2 */ "Macronix (MX)") \
+  X(NANTRONICS,  /* 0xD5 */ "Nantronics, missing prefix") \
+  X(PMC,         /* 0x9D */ "PMC, missing 0x7F prefix") \
+  /* Usage found in the RTOS_SDK has ISSI as 0x9D */ \
+  X(ISSI_2,      /* 0x9D */ "Integrated Silicon Solution (ISSI)") /* Bank2 */ \
+  X(PUYA,        /* 0x85 */ "Puya semiconductor (shanghai) co. ltd") \
+  X(SANYO,       /* 0x62 */ "Sanyo") \
+  X(SHARP,       /* 0xB0 */ "Sharp") \
+  X(SPANSION,    /* 0x01 */ "Spansion, same ID as AMD") \
+  X(SST,         /* 0xBF */ "SST") \
+  X(XMC,         /* 0x20 */ "Wuhan Xinxin Semiconductor Manufacturing Corp, XMC") \
+  X(ST,          /* 0x20 */ "ST / SGS/Thomson / Numonyx (later acquired by Micron), XMC") \
+  X(SYNCMOS_MVC, /* 0x40 */ "SyncMOS (SM) and Mosel Vitelic Corporation (MVC)") \
+  X(TENX,        /* 0x5E */ "Tenx Technologies") \
+  X(ZBIT,        /* 0x5E */ "Zbit Semiconductor, Inc. (ZB25VQ)") \
+  X(TI,          /* 0x97 */ "Texas Instruments") \
+  X(TI_OLD,      /* 0x01 */ "TI chips from last century") \
+  X(WINBOND,     /* 0xDA */ "Winbond") \
+  X(WINBOND_NEX, /* 0xEF */ "Winbond (ex Nexcom) serial flashes") \
+  X(MYSTERY_D8,  /* 0xD8 */ "Mystery Vendor ID 0xD8 - value has Parity Error")
+
+#define FLASH_VENDOR_NAME(id, name) static const char kVendor_##id[] PROGMEM = name;
+FLASH_VENDOR_LIST(FLASH_VENDOR_NAME)
+#undef FLASH_VENDOR_NAME
+
 struct FlashList {
   uint32_t id;
   const char *vendor;
-} flashList[] = {
-{SPI_FLASH_VENDOR_ALLIANCE,     /* 0x52 */    "Alliance Semiconductor"},
-{SPI_FLASH_VENDOR_AMD,          /* 0x01 */    "AMD"},
-{SPI_FLASH_VENDOR_AMIC,         /* 0x37 */    "AMIC"},
-{SPI_FLASH_VENDOR_ATMEL,        /* 0x1F */    "Atmel (now used by Adesto)"},
-{SPI_FLASH_VENDOR_BERGMICRO,    /* 0xE0 */    "BergMicro"},
-{SPI_FLASH_VENDOR_BRIGHT,       /* 0xAD */    "Bright Microelectronics"},
-{SPI_FLASH_VENDOR_CATALYST,     /* 0x31 */    "Catalyst"},
-{SPI_FLASH_VENDOR_EON,          /* 0x1C */    "EON Silicon Devices, missing 0x7F prefix"},
-{SPI_FLASH_VENDOR_ESMT,         /* 0x8C */    "Elite Semiconductor Memory Technology (ESMT) / EFST Elite Flash Storage"},
-{SPI_FLASH_VENDOR_EXCEL,        /* 0x4A */    "ESI, missing 0x7F prefix"},
-{SPI_FLASH_VENDOR_FIDELIX,      /* 0xF8 */    "Fidelix"},
-{SPI_FLASH_VENDOR_FUJITSU,      /* 0x04 */    "Fujitsu"},
-{SPI_FLASH_VENDOR_GIGADEVICE,   /* 0xC8 */    "GigaDevice"},
-{SPI_FLASH_VENDOR_HYUNDAI,      /* 0xAD */    "Hyundai"},
-{SPI_FLASH_VENDOR_INTEL,        /* 0x89 */    "Intel"},
-{SPI_FLASH_VENDOR_ISSI,         /* 0xD5 */    "ISSI Integrated Silicon Solutions, see also PMC."}, // Bank1
-{SPI_FLASH_VENDOR_MACRONIX,     /* 0xC2 */    "Macronix (MX)"},
-{SPI_FLASH_VENDOR_NANTRONICS,   /* 0xD5 */    "Nantronics, missing prefix"},
-{SPI_FLASH_VENDOR_PMC,          /* 0x9D */    "PMC, missing 0x7F prefix"},
-// Usage found in the RTOS_SDK has ISSI as 0x9D
-{SPI_FLASH_VENDOR_ISSI_2,       /* 0x9D */    "Integrated Silicon Solution (ISSI)"}, // Bank2
-{SPI_FLASH_VENDOR_PUYA,         /* 0x85 */    "Puya semiconductor (shanghai) co. ltd"},
-{SPI_FLASH_VENDOR_SANYO,        /* 0x62 */    "Sanyo"},
-{SPI_FLASH_VENDOR_SHARP,        /* 0xB0 */    "Sharp"},
-{SPI_FLASH_VENDOR_SPANSION,     /* 0x01 */    "Spansion, same ID as AMD"},
-{SPI_FLASH_VENDOR_SST,          /* 0xBF */    "SST"},
-{SPI_FLASH_VENDOR_XMC,          /* 0x20 */    "Wuhan Xinxin Semiconductor Manufacturing Corp, XMC"},
-{SPI_FLASH_VENDOR_ST,           /* 0x20 */    "ST / SGS/Thomson / Numonyx (later acquired by Micron), XMC"},
-{SPI_FLASH_VENDOR_SYNCMOS_MVC,  /* 0x40 */    "SyncMOS (SM) and Mosel Vitelic Corporation (MVC)"},
-{SPI_FLASH_VENDOR_TENX,         /* 0x5E */    "Tenx Technologies"},
-{SPI_FLASH_VENDOR_ZBIT,         /* 0x5E */    "Zbit Semiconductor, Inc. (ZB25VQ)"},
-{SPI_FLASH_VENDOR_TI,           /* 0x97 */    "Texas Instruments"},
-{SPI_FLASH_VENDOR_TI_OLD,       /* 0x01 */    "TI chips from last century"},
-{SPI_FLASH_VENDOR_WINBOND,      /* 0xDA */    "Winbond"},
-{SPI_FLASH_VENDOR_WINBOND_NEX,  /* 0xEF */    "Winbond (ex Nexcom) serial flashes"},
-{SPI_FLASH_VENDOR_MYSTERY_D8,   /* 0xD8 */    "Mystery Vendor ID 0xD8 - value has Parity Error"},
-{SPI_FLASH_VENDOR_UNKNOWN,      /* 0xFF */    "unknown"}
 };
 
+#define FLASH_VENDOR_ENTRY(id, name) {SPI_FLASH_VENDOR_##id, kVendor_##id},
+static const FlashList flashList[] PROGMEM = {
+FLASH_VENDOR_LIST(FLASH_VENDOR_ENTRY)
+};
+#undef FLASH_VENDOR_ENTRY
+
 uint32_t printFlashChipID(const char *indent) {
  // These lookups matchup to vendors commonly thought to exist on ESP8266 Modules.
  // Unfortunatlly the information returned from spi_flash_get_id() does not
@@ -66,13 +78,26 @@ uint32_t printFlashChipID(const char *indent) {
  // are arround 11 banks at this writing.  Also, I have not seen any devices
  // that impliment the repeating 0x7F to indicate bank number.
  uint32_t deviceId = spi_flash_get_id();
- const char *vendor = "unknown";
- for (size_t i = 0; SPI_FLASH_VENDOR_UNKNOWN != flashList[i].id; i++) {
-   if (flashList[i].id == (deviceId & 0xFFu)) {
-     vendor = flashList[i].vendor;
-     Serial.printf("%s%-12s 0x%06x, '%s'\r\n", indent, "Device ID:", deviceId, vendor);
+ Serial.printf("%s%-12s 0x%06x, '", indent, "Device ID:", deviceId);
+ // Print all the names for a vendor ID collision, once
+ size_t matches = 0u;
+ for (size_t i = 0; i < sizeof(flashList) / sizeof(flashList[0]); i++) {
+   if (pgm_read_dword(&flashList[i].id) == (deviceId & 0xFFu)) {
+     if (matches) Serial.print(F("' or '"));
+     Serial.print(FPSTR(pgm_read_ptr(&flashList[i].vendor)));
+     matches++;
    }
  }
+ Serial.printf_P(PSTR("%s'\r\n"), (matches) ? "" : "unknown");
+
+ experimental::FlashPartRecord rec;
+ if (experimental::flash_part_lookup(deviceId, &rec)) {
+   Serial.printf("%s%-12s QE/S%u, %u-bit write, %svolatile%s\r\n", indent, "Builtin:",
+     rec.qe_pos, (rec.wide16) ? 16u : 8u, (rec.non_volatile) ? "non-" : "",
+     (rec.fixup) ? ", with fixup" : "");
+ } else {
+   Serial.printf("%s%-12s none\r\n", indent, "Builtin:");
+ }
  return deviceId;
 }
 //
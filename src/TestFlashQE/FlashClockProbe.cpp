@@ -0,0 +1,236 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Flash clock and read mode probe - see FlashClockProbe.h
+*/
+#include <Arduino.h>
+#include <spi_flash.h>
+#include <esp8266_undocumented.h>
+#include <SpiFlashUtils.h>
+#include <SfdpRevInfo.h>
+#include "FlashReport.h"      // flash_report_crc32()
+#include "FlashClockProbe.h"
+
+extern "C" {
+
+using experimental::flash_report_crc32;
+
+// IOMUX bit that must match SPICLK_EQU_SYSCLK, 80 MHz flash clock
+constexpr uint32_t kIomuxSpi0ClkEquSysClk = BIT8;
+
+// SPI0C read mode bits. QIO and QOUT are never set by the probe.
+constexpr uint32_t kSpi0ReadModeMask = SPICQIO | SPICDIO | SPICQOUT | SPICDOUT | SPICFASTRD;
+
+constexpr size_t kProbeMaxRegion = 4096u;
+// Evict with a span larger than the iCache, read at the build's settings
+constexpr size_t kProbeEvictSpan = 0x8000u;
+constexpr size_t kProbeEvictStride = 16u;
+
+struct FlashClock {
+  uint32_t spi0clk;
+  uint8_t mhz;
+};
+
+// SPI0CLK from the 80 MHz APB clock: CLKCNT_N = div - 1, CLKCNT_H =
+// (div / 2) - 1, CLKCNT_L = div - 1. Fastest first.
+static const FlashClock probe_clocks[] = {
+  {SPICLK_EQU_SYSCLK, 80u},
+  {0x00001001u, 40u},
+  {0x00002002u, 26u},
+  {0x00003043u, 20u}
+};
+
+static const uint32_t probe_mode_bits[kFlashReadModeCount] = {
+  SPICFASTRD,                 // kFlashRead_1_1_1
+  SPICFASTRD | SPICDOUT,      // kFlashRead_1_1_2
+  SPICFASTRD | SPICDIO        // kFlashRead_1_2_2
+};
+
+static const char *const probe_mode_names[kFlashReadModeCount] = {
+  "1-1-1", "1-1-2 DOUT", "1-2-2 DIO"
+};
+
+static uint32_t probe_mode_from_spi0c(const uint32_t spi0c) {
+  if (spi0c & SPICDIO) return kFlashRead_1_2_2;
+  if (spi0c & SPICDOUT) return kFlashRead_1_1_2;
+  return kFlashRead_1_1_1;
+}
+
+static uint32_t probe_mhz_from_spi0clk(const uint32_t spi0clk) {
+  if (spi0clk & SPICLK_EQU_SYSCLK) return 80u;
+  const uint32_t div = ((spi0clk >> SPICLKCN) & SPIMCLKCN) + 1u;
+  return 80u / div;
+}
+
+/*
+  Everything between the two iCache windows runs from IRAM and DRAM. The only
+  flash reads made with the setting under test are the loads from src.
+*/
+static uint32_t IRAM_ATTR probe_copy(const uint32_t spi0c, const uint32_t spi0clk,
+  const volatile uint32_t *src, uint32_t *dst, const size_t n) {
+
+  uint32_t saved_ps = xt_rsil(15);
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  const uint32_t oldSPI0C = SPI0C;
+  const uint32_t oldSPI0CLK = SPI0CLK;
+  const uint32_t oldGPMUX = GPMUX;
+
+  SPI0C = (oldSPI0C & ~kSpi0ReadModeMask) | (spi0c & kSpi0ReadModeMask);
+  SPI0CLK = spi0clk;
+  GPMUX = (spi0clk & SPICLK_EQU_SYSCLK) ? (oldGPMUX | kIomuxSpi0ClkEquSysClk) : (oldGPMUX & ~kIomuxSpi0ClkEquSysClk);
+  Cache_Read_Enable_2();
+
+  const uint32_t start = esp_get_cycle_count();
+  for (size_t i = 0u; i < n; i++) dst[i] = src[i];
+  const uint32_t cycles = esp_get_cycle_count() - start;
+
+  // Lines read with a bad setting are dropped with the iCache off/on
+  Cache_Read_Disable_2();
+  Wait_SPI_Idle(flashchip);
+  SPI0C = oldSPI0C;
+  SPI0CLK = oldSPI0CLK;
+  GPMUX = oldGPMUX;
+  Cache_Read_Enable_2();
+  xt_wsr_ps(saved_ps);
+  return cycles;
+}
+
+static uint32_t probe_evict(const uintptr_t region) {
+  // Read at the build's settings. Wraps inside the 1 MB flash window.
+  const uintptr_t base = 0x40200000u;
+  const uintptr_t start = ((region - base + 0x10000u) & 0xF0000u) + base;
+  uint32_t sum = 0u;
+  for (size_t i = 0u; i < kProbeEvictSpan; i += kProbeEvictStride) {
+    sum += *(const volatile uint32_t *)(start + i);
+  }
+  return sum;
+}
+
+// One setting, passes times. Returns the passes with a CRC equal to ref_crc.
+static uint32_t probe_one(FlashProbeResult *r, const uintptr_t region, uint32_t *buf,
+  const size_t sz, const uint32_t passes, const uint32_t ref_crc) {
+
+  uint32_t matched = 0u;
+  r->cycles = UINT32_MAX;
+  for (uint32_t i = 0u; i < passes; i++) {
+    probe_evict(region);
+    memset(buf, 0, sz);
+    const uint32_t cycles = probe_copy(probe_mode_bits[r->mode], r->spi0clk,
+      (const volatile uint32_t *)region, buf, sz / 4u);
+    r->crc = flash_report_crc32(buf, sz);
+    if (ref_crc == r->crc) {
+      matched++;
+      if (r->cycles > cycles) r->cycles = cycles;
+    }
+    yield();
+  }
+  r->passes = matched;
+  return matched;
+}
+
+size_t flash_clock_probe(FlashProbeResult *results, const size_t max,
+  const void *region, const size_t region_sz, const uint32_t passes) {
+  using namespace experimental;
+
+  if (0u == max || 0u == passes || UINT8_MAX < passes) return 0u;
+  uintptr_t addr = (uintptr_t)region;
+  size_t sz = region_sz;
+  if (nullptr == region) {
+    // Part of the sketch code, it is in flash and never erased
+    addr = (uintptr_t)&flash_clock_probe & ~(kProbeMaxRegion - 1u);
+    sz = kProbeMaxRegion;
+  }
+  if ((3u & addr) || (3u & sz) || 0u == sz || kProbeMaxRegion < sz) return 0u;
+
+  uint32_t *buf = (uint32_t *)malloc(sz);
+  if (nullptr == buf) return 0u;
+
+  uint32_t fast_read = kSfdpFastRead_1_1_2 | kSfdpFastRead_1_2_2;
+  bool has_sfdp = false;
+  SfdpDescriptor desc;
+  if (get_sfdp_descriptor(&desc)) {
+    fast_read = desc.fast_read;
+    has_sfdp = true;
+  }
+
+  // Baseline, the build's settings. Also the reference CRC.
+  FlashProbeResult *r = &results[0];
+  memset(r, 0, sizeof(FlashProbeResult));
+  r->spi0clk = SPI0CLK;
+  r->mode = probe_mode_from_spi0c(SPI0C);
+  r->flash_mhz = probe_mhz_from_spi0clk(r->spi0clk);
+  r->sfdp = 1u;
+  const uint32_t ref_crc = flash_report_crc32((const void *)addr, sz);
+  if (passes != probe_one(r, addr, buf, sz, passes, ref_crc)) {
+    free(buf);
+    return 0u;
+  }
+
+  size_t n = 1u;
+  for (size_t m = kFlashReadModeCount; m-- > 0u && n < max; ) {
+    const bool listed = (kFlashRead_1_1_1 == m)
+                     || (kFlashRead_1_1_2 == m && (kSfdpFastRead_1_1_2 & fast_read))
+                     || (kFlashRead_1_2_2 == m && (kSfdpFastRead_1_2_2 & fast_read));
+    if (has_sfdp && ! listed) continue;
+    for (size_t c = 0u; c < sizeof(probe_clocks) / sizeof(probe_clocks[0]) && n < max; c++) {
+      r = &results[n++];
+      memset(r, 0, sizeof(FlashProbeResult));
+      r->spi0clk = probe_clocks[c].spi0clk;
+      r->flash_mhz = probe_clocks[c].mhz;
+      r->mode = m;
+      r->sfdp = (listed) ? 1u : 0u;
+      probe_one(r, addr, buf, sz, passes, ref_crc);
+    }
+  }
+  free(buf);
+  return n;
+}
+
+const FlashProbeResult *flash_clock_probe_best(const FlashProbeResult *results, const size_t n, const uint32_t passes) {
+  const FlashProbeResult *best = nullptr;
+  for (size_t i = 0u; i < n; i++) {
+    if (passes != results[i].passes) continue;
+    if (nullptr == best || best->cycles > results[i].cycles) best = &results[i];
+  }
+  return best;
+}
+
+void flash_clock_probe_print(const FlashProbeResult *results, const size_t n, const uint32_t passes) {
+  if (0u == n) {
+    Serial.printf_P(PSTR("  Flash probe failed, the baseline read was not repeatable\r\n"));
+    return;
+  }
+  Serial.printf_P(PSTR("  %-12s %5s %-5s %8s %7s %s\r\n"), "Read mode", "MHz", "SFDP", "cycles", "passes", "");
+  for (size_t i = 0u; i < n; i++) {
+    const FlashProbeResult *r = &results[i];
+    Serial.printf_P(PSTR("  %-12s %5u %-5s %8u %3u/%-3u %s\r\n"),
+      probe_mode_names[r->mode % kFlashReadModeCount], r->flash_mhz, (r->sfdp) ? "yes" : "no",
+      (r->passes) ? r->cycles : 0u, r->passes, passes, (0u == i) ? "build setting" : "");
+  }
+
+  const FlashProbeResult *best = flash_clock_probe_best(results, n, passes);
+  if (best) {
+    static const char *const ide_modes[kFlashReadModeCount] = {"none", "DOUT", "DIO"};
+    Serial.printf_P(PSTR("  Recommend: %s at %u MHz, \"Tools->Flash Mode\" %s, \"Tools->Flash Frequency\" %uMHz\r\n"),
+      probe_mode_names[best->mode], best->flash_mhz, ide_modes[best->mode], best->flash_mhz);
+    if (kFlashRead_1_1_1 == best->mode) {
+      Serial.printf_P(PSTR("  There is no IDE Flash Mode for 1-1-1 fast read, use DOUT\r\n"));
+    }
+  }
+}
+
+};
@@ -0,0 +1,78 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Flash clock and read mode probe - for builds limited to DIO or DOUT
+
+  With GPIO9 and GPIO10 reclaimed, QIO is gone. This finds the fastest flash
+  clock and 1-1-1, 1-1-2 (DOUT), or 1-2-2 (DIO) read mode that reads a known
+  flash region back with the same CRC-32 as the build's own settings.
+
+  For each setting, an IRAM function masks interrupts, turns the iCache off,
+  changes SPI0C read mode bits and SPI0CLK, turns the iCache back on, and
+  copies the region through the cache into a DRAM buffer. It times the copy,
+  which is all cache misses, then puts the build's settings back. Only the
+  copy runs with the setting under test. The CRC is computed afterward.
+
+  The read modes tried come from the SFDP Basic Parameter Table DW1 fast read
+  bits. Without SFDP, all three are tried and the CRC decides.
+
+  This is a characterization tool. Nothing is changed when it returns. Use the
+  result to pick "Tools->Flash Mode" and "Tools->Flash Frequency". Turn off
+  WiFi first; the WiFi NMI is not masked while a setting is under test.
+*/
+#ifndef TESTFLASHQE_FLASH_CLOCK_PROBE_H
+#define TESTFLASHQE_FLASH_CLOCK_PROBE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum FlashReadMode : uint8_t {
+  kFlashRead_1_1_1 = 0u,        // Fast Read 0Bh
+  kFlashRead_1_1_2,             // Dual Output 3Bh, "DOUT"
+  kFlashRead_1_2_2,             // Dual I/O BBh, "DIO"
+  kFlashReadModeCount
+};
+
+struct FlashProbeResult {
+  uint32_t spi0clk;             // SPI0CLK register value
+  uint32_t cycles;              // Fewest CCOUNT cycles to copy the region
+  uint32_t crc;                 // Last pass CRC-32
+  uint8_t flash_mhz;
+  uint8_t mode;                 // FlashReadMode
+  uint8_t passes;               // Passes with a CRC match
+  uint8_t sfdp;                 // 1 when SFDP lists the read mode
+};
+
+// Results for up to max settings. region and region_sz must be a 4-byte
+// aligned span of memory mapped flash, at most 4096 bytes; NULL uses the start
+// of the sketch code. Returns the number of results, 0 when the baseline
+// read was not repeatable.
+size_t flash_clock_probe(FlashProbeResult *results, const size_t max,
+  const void *region, const size_t region_sz, const uint32_t passes);
+
+// The stable result with the fewest cycles, or NULL
+const FlashProbeResult *flash_clock_probe_best(const FlashProbeResult *results, const size_t n, const uint32_t passes);
+
+void flash_clock_probe_print(const FlashProbeResult *results, const size_t n, const uint32_t passes);
+
+#ifdef __cplusplus
+};
+#endif
+#endif // TESTFLASHQE_FLASH_CLOCK_PROBE_H
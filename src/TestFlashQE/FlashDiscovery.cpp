@@ -0,0 +1,56 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include <Arduino.h>
+#include <user_interface.h> // system_rtc_mem_read()
+#include "FlashDiscovery.h"
+
+extern "C" {
+
+namespace experimental {
+
+constexpr uint32_t kDiscoveryMagic = 0x46440910u;  // "FD" 09 10
+constexpr size_t kDiscoveryWords = sizeof(FlashDiscovery) / sizeof(uint32_t) - 1u;
+
+static uint32_t discovery_chksum(const FlashDiscovery *fd) {
+  uint32_t sum = kDiscoveryMagic;
+  for (size_t i = 0u; i < kDiscoveryWords; i++) {
+    sum = ((sum << 5u) | (sum >> 27u)) ^ fd->u32[i];
+  }
+  return sum;
+}
+
+bool flash_discovery_load(FlashDiscovery *fd) {
+  if (! system_rtc_mem_read(FLASH_DISCOVERY_RTC_BLOCK, &fd->u32[0], sizeof(FlashDiscovery))) {
+    return false;
+  }
+  return (discovery_chksum(fd) == fd->chksum);
+}
+
+bool flash_discovery_save(const FlashDiscovery *fd) {
+  FlashDiscovery rtc = *fd;
+  rtc.chksum = discovery_chksum(&rtc);
+  return system_rtc_mem_write(FLASH_DISCOVERY_RTC_BLOCK, &rtc.u32[0], sizeof(FlashDiscovery));
+}
+
+void flash_discovery_invalidate(void) {
+  FlashDiscovery rtc;
+  memset(&rtc.u32[0], 0, sizeof(rtc));
+  system_rtc_mem_write(FLASH_DISCOVERY_RTC_BLOCK, &rtc.u32[0], sizeof(FlashDiscovery));
+}
+
+};  // namespace experimental {
+
+};
@@ -0,0 +1,97 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  FlashDiscovery - A list of discovered characteristics that may help guide
+  configuring the SPI flash memory to disable the pin functions /WP and /HOLD.
+
+  The record is 20 bytes and is kept in RTC user memory while the discovery
+  steps run. The stage is saved before each step. After a crash, the boot code
+  reads back the stage that was running; for the /HOLD test, a crash is the
+  expected failure.
+*/
+#ifndef TESTFLASHQE_FLASH_DISCOVERY_H
+#define TESTFLASHQE_FLASH_DISCOVERY_H
+
+// RTC user memory blocks 179 - 183, `ESP.rtcUserMemory` offset 115 - 119. Just
+// below the SrWearGuard counters.
+#ifndef FLASH_DISCOVERY_RTC_BLOCK
+#define FLASH_DISCOVERY_RTC_BLOCK 179u
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+enum FlashDiscoveryStage : uint8_t {
+  kFdStageIdle = 0u,
+  kFdStageAnalyze,                // analyze_SR_QE()
+  kFdStageCheckWP,                // check_QE_WP()
+  kFdStageTestHold,               // testOutputGPIO9(), may crash on failure
+  kFdStageSuggest,                // suggestedReclaimFn()
+  kFdStageDone
+};
+
+enum FlashDiscoveryResult : uint8_t {
+  kFdResultNone = 0u,
+  kFdResultPass,
+  kFdResultFailAnalyze,
+  kFdResultFailWP,
+  kFdResultFailHold,
+  kFdResultCrash,                 // Unexpected crash, see stage
+  kFdResultGaveUp                 // Too many resets in one stage
+};
+
+union FlashDiscovery {
+  struct {
+    uint32_t device;
+    uint32_t S9:1;                // Proposed/discovered QE bit possition
+    uint32_t S6:1;                // " S6 or S9 or neither
+    uint32_t WP:1;                // Pin function /WP exist
+    uint32_t has_8bw_sr1:1;       // When true, WEL write operation succeeded
+    uint32_t has_8bw_sr2:1;       // "
+    uint32_t has_8bw_sr3:1;       // "
+    uint32_t has_16bw_sr1:1;      // "
+    uint32_t has_volatile:1;      // Volatile Status Register bit detected
+    uint32_t write_QE:1;          // Writable QE bit candidate, S9 or S6 is set
+    uint32_t pass_analyze:1;
+    uint32_t pass_SC:1;           // Short Circuit tests on GPIO 9 and 10 passed
+    uint32_t pass_WP:1;           // /WP disabled - Test results
+    uint32_t pass_HOLD:1;         // /HOLD disabled - Test results
+    uint32_t reserved0:3;
+    uint32_t stage:8;             // FlashDiscoveryStage running or last run
+    uint32_t result:8;            // FlashDiscoveryResult
+    uint32_t sr321:24;            // Status Registers when the record was saved
+    uint32_t boots:8;             // Resets seen while stage was running
+    uint32_t key:8;               // Analyze hotkey, 'a', 'b', 'A', or 'B'
+    uint32_t reserved1:24;
+    uint32_t chksum;
+  };
+  uint32_t u32[5];
+};
+
+// RTC user memory load/save. Load returns false on checksum failure.
+bool flash_discovery_load(FlashDiscovery *fd);
+bool flash_discovery_save(const FlashDiscovery *fd);
+void flash_discovery_invalidate(void);
+
+};  // namespace experimental {
+
+#ifdef __cplusplus
+};
+#endif
+#endif // TESTFLASHQE_FLASH_DISCOVERY_H
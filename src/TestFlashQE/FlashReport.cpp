@@ -0,0 +1,137 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include <Arduino.h>
+extern "C" {
+#include <SpiFlashUtils.h>
+#include <DeviceFingerprint.h>  // device_unique_id()
+#include "FlashReport.h"
+
+namespace experimental {
+
+constexpr uint32_t kSfdpSignature = 0x50444653u; //'SFDP'
+constexpr size_t kHeaderSize = 8u;
+constexpr size_t kRecordHdrSize = 4u;
+
+struct ReportWriter {
+  uint32_t *buf;
+  size_t max_sz;
+  size_t pos;               // Bytes, always a multiple of 4
+  uint32_t count;
+  bool overflow;
+};
+
+// Reserve a record and return a pointer to its data, or NULL on overflow.
+static uint32_t *report_record(ReportWriter *w, const uint8_t tag, const size_t len) {
+  const size_t padded = (len + 3u) & ~3u;
+  // Leave room for the CRC
+  if (w->overflow || w->pos + kRecordHdrSize + padded + sizeof(uint32_t) > w->max_sz) {
+    w->overflow = true;
+    return NULL;
+  }
+  uint32_t *p = &w->buf[w->pos / sizeof(uint32_t)];
+  p[0] = tag | (len << 16u);
+  if (padded) p[padded / sizeof(uint32_t)] = 0u;   // Zero the pad bytes
+  w->pos += kRecordHdrSize + padded;
+  w->count++;
+  return &p[1];
+}
+
+static void report_add(ReportWriter *w, const uint8_t tag, const uint32_t *data, const size_t len) {
+  uint32_t *p = report_record(w, tag, len);
+  if (p) memcpy(p, data, len);
+}
+
+uint32_t flash_report_crc32(const void *p, const size_t sz) {
+  const uint8_t *b = (const uint8_t *)p;
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0u; i < sz; i++) {
+    crc ^= b[i];
+    for (size_t k = 0u; k < 8u; k++) {
+      crc = (crc >> 1u) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+size_t flash_report_build(uint32_t *buf, const size_t max_sz, const FlashDiscovery *fd) {
+  if (max_sz < kHeaderSize + sizeof(uint32_t)) return 0u;
+  ReportWriter w = {buf, max_sz, kHeaderSize, 0u, false};
+
+  uint32_t id = spi_flash_get_id();
+  report_add(&w, kFrTagFlashId, &id, sizeof(id));
+
+  Spi0ReadOp ops[3] = {
+    {kReadStatusRegister1Cmd, 8u},
+    {kReadStatusRegister2Cmd, 8u},
+    {kReadStatusRegister3Cmd, 8u}
+  };
+  uint32_t sr[3] = {0u, 0u, 0u};
+  if (SPI_RESULT_OK == spi0_flash_read_batch(ops, sr, 3u)) {
+    uint32_t sr321 = (sr[0] & 0xFFu) | ((sr[1] & 0xFFu) << 8u) | ((sr[2] & 0xFFu) << 16u);
+    report_add(&w, kFrTagSR321, &sr321, 3u);
+  }
+
+  // Read the SFDP space straight into the record
+  uint32_t *sfdp = report_record(&w, kFrTagSfdp, 256u);
+  if (sfdp) {
+    if (SPI_RESULT_OK != spi0_flash_read_sfdp(0u, sfdp, 256u) || kSfdpSignature != sfdp[0]) {
+      // Drop the record
+      w.pos -= kRecordHdrSize + 256u;
+      w.count--;
+    }
+  }
+
+  // Not always 4Bh, EON keeps it in the SFDP space
+  uint32_t unique[4] = {0u, 0u, 0u, 0u};
+  size_t unique_sz = 0u;
+  if (kUniqueIdNone != device_unique_id(id, unique, &unique_sz)) {
+    report_add(&w, kFrTagUniqueId, unique, unique_sz);
+  }
+
+  if (fd) report_add(&w, kFrTagDiscovery, &fd->u32[0], 4u * sizeof(uint32_t));
+
+  if (w.overflow) return 0u;
+  const size_t total = w.pos + sizeof(uint32_t);
+  buf[0] = kFlashReportMagic;
+  buf[1] = kFlashReportVersion | (w.count << 8u) | (total << 16u);
+  buf[w.pos / sizeof(uint32_t)] = flash_report_crc32(buf, w.pos);
+  return total;
+}
+
+};  // namespace experimental {
+};
+
+void sendFlashReport(HardwareSerial& port, const experimental::FlashDiscovery *fd, const uint32_t baud) {
+  using namespace experimental;
+  uint32_t buf[kFlashReportMaxSize / sizeof(uint32_t)];
+  const size_t sz = flash_report_build(buf, sizeof(buf), fd);
+  if (0u == sz) {
+    port.printf_P(PSTR("@FR 0 0\r\n"));
+    return;
+  }
+  port.printf_P(PSTR("@FR %X %08X\r\n"), sz, buf[sz / sizeof(uint32_t) - 1u]);
+  const uint32_t old_baud = (uint32_t)port.baudRate();
+  if (baud && baud != old_baud) {
+    port.flush();
+    port.updateBaudRate(baud);
+  }
+  port.write((const uint8_t *)buf, sz);
+  if (baud && baud != old_baud) {
+    port.flush();
+    port.updateBaudRate(old_baud);
+  }
+  port.printf_P(PSTR("\r\n"));
+}
@@ -0,0 +1,76 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  FlashReport - a compact binary report of the flash memory for a host tool.
+
+  All values are little-endian.
+
+    Header   u32 magic 'SFUR', u8 version, u8 record count, u16 total length
+    Record   u8 tag, u8 reserved, u16 data length, data padded to 4 bytes
+    Trailer  u32 CRC-32 (IEEE 802.3) of all bytes before it
+
+  The total length includes the header and trailer. Unknown tags can be
+  skipped using the record length.
+
+  On the serial port, the blob follows a text line
+
+    @FR <length> <crc>
+
+  in hex, so a host can find it in the middle of the human readable output.
+*/
+#ifndef TESTFLASHQE_FLASH_REPORT_H
+#define TESTFLASHQE_FLASH_REPORT_H
+
+#include "FlashDiscovery.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+namespace experimental {
+
+constexpr uint32_t kFlashReportMagic = 0x52554653u;  // 'SFUR'
+constexpr uint8_t kFlashReportVersion = 2u;
+
+enum FlashReportTag : uint8_t {
+  kFrTagFlashId = 1u,             // u32 spi_flash_get_id()
+  kFrTagSR321 = 2u,               // u8 SR1, SR2, SR3, pad
+  kFrTagSfdp = 3u,                // First 256 bytes of SFDP space, when the signature is found
+  kFrTagUniqueId = 4u,            // From device_unique_id(): 16 or 8 bytes from 4Bh,
+                                  // 12 bytes from SFDP 80h for EON. Version 1 was
+                                  // always 16 bytes from 4Bh.
+  kFrTagDiscovery = 5u            // FlashDiscovery::u32[0..3]
+};
+
+// Large enough for every record above
+constexpr size_t kFlashReportMaxSize = 384u;
+
+// Fills buf and returns the total length, or 0 when max_sz is too small.
+// fd may be NULL to leave out the discovery record.
+size_t flash_report_build(uint32_t *buf, const size_t max_sz, const FlashDiscovery *fd);
+
+uint32_t flash_report_crc32(const void *p, const size_t sz);
+
+};  // namespace experimental {
+
+#ifdef __cplusplus
+};
+
+// Print the "@FR" line and the blob. When baud is not 0, the blob is sent at
+// that rate and the port returns to its previous rate after.
+void sendFlashReport(HardwareSerial& port, const experimental::FlashDiscovery *fd, const uint32_t baud = 0u);
+#endif
+#endif // TESTFLASHQE_FLASH_REPORT_H
@@ -0,0 +1,200 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaimed pin stress test - see PinStress.h
+*/
+#include <Arduino.h>
+#include <spi_flash.h>
+#include <ReclaimedPins.h>
+#include "FlashReport.h"      // flash_report_crc32()
+#include "PinStress.h"
+
+extern "C" {
+
+using experimental::flash_report_crc32;
+using experimental::ReclaimedPins;
+using experimental::kGpio9Mask;
+using experimental::kGpio10Mask;
+using experimental::kReclaimedPinsMask;
+
+constexpr uintptr_t kFlashWindow = 0x40200000u;
+constexpr size_t kStressBlock = 4096u;
+constexpr size_t kStressDefaultSpan = 0x10000u;
+constexpr size_t kStressMaxSpan = 0x40000u;
+// GPSD fields: enable BIT16, prescale bits 8-15, target bits 0-7. A target
+// of half scale gives a 50% duty, the densest edges.
+constexpr uint32_t kSigmaDeltaEnable = BIT16;
+constexpr uint32_t kSigmaDeltaPrescaleShift = 8u;
+constexpr uint32_t kSigmaDeltaHalf = 0x80u;
+
+struct PinStressSaved {
+  uint32_t gpsd;
+  uint32_t gpo;
+  uint32_t gpe;
+  uint32_t gpc9;
+  uint32_t gpc10;
+  uint32_t gpf9;
+  uint32_t gpf10;
+};
+
+static void stress_toggle_start(const uint32_t pins, const uint8_t prescale, PinStressSaved *saved) {
+  saved->gpsd = GPSD;
+  saved->gpo = GPO;
+  saved->gpe = GPE;
+  saved->gpc9 = GPC(9u);
+  saved->gpc10 = GPC(10u);
+  saved->gpf9 = GPF9;
+  saved->gpf10 = GPF10;
+
+  GPSD = kSigmaDeltaEnable | ((uint32_t)prescale << kSigmaDeltaPrescaleShift) | kSigmaDeltaHalf;
+  for (uint8_t pin = 9u; pin <= 10u; pin++) {
+    if (0u == (pins & (1u << pin))) continue;
+    ReclaimedPins::mode(pin, OUTPUT);
+    GPC(pin) |= (1u << GPCS);   // Source is the sigma-delta output
+  }
+}
+
+static void stress_toggle_stop(const PinStressSaved *saved) {
+  GPC(9u) = saved->gpc9;
+  GPC(10u) = saved->gpc10;
+  ReclaimedPins::write(kReclaimedPinsMask, saved->gpo);
+  GPF9 = saved->gpf9;
+  GPF10 = saved->gpf10;
+  GPES = saved->gpe & kReclaimedPinsMask;
+  GPEC = ~saved->gpe & kReclaimedPinsMask;
+  GPSD = saved->gpsd;
+}
+
+// 32-bit loads only; byte loads from the flash window raise an exception
+static void IRAM_ATTR stress_cache_copy(const volatile uint32_t *src, uint32_t *dst, const size_t n) {
+  for (size_t i = 0u; i < n; i++) dst[i] = src[i];
+}
+
+static uint32_t stress_spi_block(const uint32_t offset, uint32_t *buf, bool *ok) {
+  memset(buf, 0, kStressBlock);
+  *ok = (SPI_FLASH_RESULT_OK == spi_flash_read(offset, buf, kStressBlock));
+  return flash_report_crc32(buf, kStressBlock);
+}
+
+static uint32_t stress_cache_block(const uint32_t offset, uint32_t *buf) {
+  memset(buf, 0, kStressBlock);
+  stress_cache_copy((const volatile uint32_t *)(kFlashWindow + offset), buf, kStressBlock / 4u);
+  return flash_report_crc32(buf, kStressBlock);
+}
+
+bool pin_stress_run(PinStressResult *r, const uint32_t pins, const uint32_t duration_ms,
+  const size_t span, const uint8_t prescale) {
+
+  memset(r, 0, sizeof(PinStressResult));
+  const size_t sz = (span) ? span : kStressDefaultSpan;
+  r->pins = pins & kReclaimedPinsMask;
+  r->span = sz;
+  r->prescale = prescale;
+  if (0u == r->pins || (kStressBlock - 1u) & sz || kStressMaxSpan < sz) return false;
+  if (! ReclaimedPins::available()) return false;
+
+  const size_t n_blocks = sz / kStressBlock;
+  uint32_t *buf = (uint32_t *)malloc(kStressBlock);
+  uint32_t *ref = (uint32_t *)malloc(n_blocks * sizeof(uint32_t));
+  if (nullptr == buf || nullptr == ref) {
+    free(buf);
+    free(ref);
+    return false;
+  }
+
+  // Reference with the pins idle. Both paths must agree.
+  bool ok = true;
+  for (size_t i = 0u; i < n_blocks && ok; i++) {
+    bool read_ok = false;
+    ref[i] = stress_spi_block(i * kStressBlock, buf, &read_ok);
+    ok = read_ok && ref[i] == stress_cache_block(i * kStressBlock, buf);
+    yield();
+  }
+  if (! ok) {
+    free(buf);
+    free(ref);
+    return false;
+  }
+
+  PinStressSaved saved;
+  stress_toggle_start(r->pins, prescale, &saved);
+  const uint32_t start_ms = millis();
+  size_t i = 0u;
+  while (duration_ms > millis() - start_ms) {
+    const uint32_t offset = i * kStressBlock;
+    bool read_ok = false;
+
+    uint32_t t0 = micros();
+    uint32_t crc = stress_spi_block(offset, buf, &read_ok);
+    r->spi_us += micros() - t0;
+    r->spi_blocks++;
+    if (! read_ok) r->spi_read_errors++;
+    if (ref[i] != crc) r->spi_crc_errors++;
+
+    t0 = micros();
+    crc = stress_cache_block(offset, buf);
+    r->cache_us += micros() - t0;
+    r->cache_blocks++;
+    if (ref[i] != crc) r->cache_crc_errors++;
+
+    // The pins are not tied to the transfers; a sample per block is plenty
+    const uint32_t in = ReclaimedPins::read() & r->pins;
+    r->seen_high |= in;
+    r->seen_low |= ~in & r->pins;
+
+    i = (i + 1u) % n_blocks;
+    yield();
+  }
+  r->elapsed_ms = millis() - start_ms;
+  stress_toggle_stop(&saved);
+
+  free(buf);
+  free(ref);
+  return true;
+}
+
+// KB/s from 4 KB blocks and microseconds
+static uint32_t stress_kbps(const uint32_t blocks, const uint32_t us) {
+  return (us) ? (uint32_t)(((uint64_t)blocks * (kStressBlock / 1024u) * 1000000u) / us) : 0u;
+}
+
+// Errors per million blocks
+static uint32_t stress_ppm(const uint32_t errors, const uint32_t blocks) {
+  return (blocks) ? (uint32_t)(((uint64_t)errors * 1000000u) / blocks) : 0u;
+}
+
+void pin_stress_print(const PinStressResult *r) {
+  Serial.printf_P(PSTR("  Pins:%s%s, sigma-delta prescale %u, %u KB span, %u ms\r\n"),
+    (r->pins & kGpio9Mask) ? " GPIO9" : "", (r->pins & kGpio10Mask) ? " GPIO10" : "",
+    r->prescale, r->span / 1024u, r->elapsed_ms);
+  Serial.printf_P(PSTR("  %-16s %8s %8s %8s %8s\r\n"), "Path", "blocks", "errors", "ppm", "KB/s");
+  const uint32_t spi_errors = r->spi_crc_errors + r->spi_read_errors;
+  Serial.printf_P(PSTR("  %-16s %8u %8u %8u %8u\r\n"), "spi_flash_read", r->spi_blocks,
+    spi_errors, stress_ppm(spi_errors, r->spi_blocks), stress_kbps(r->spi_blocks, r->spi_us));
+  Serial.printf_P(PSTR("  %-16s %8u %8u %8u %8u\r\n"), "iCache", r->cache_blocks,
+    r->cache_crc_errors, stress_ppm(r->cache_crc_errors, r->cache_blocks), stress_kbps(r->cache_blocks, r->cache_us));
+
+  const uint32_t stuck = r->pins & ~(r->seen_high & r->seen_low);
+  if (stuck) {
+    Serial.printf_P(PSTR("* Not toggling:%s%s, check for a short or a load on the pin\r\n"),
+      (stuck & kGpio9Mask) ? " GPIO9" : "", (stuck & kGpio10Mask) ? " GPIO10" : "");
+  }
+  const bool pass = (0u == spi_errors && 0u == r->cache_crc_errors && 0u == stuck && r->spi_blocks);
+  Serial.printf_P(PSTR("%c /HOLD and /WP under flash traffic: %s\r\n"), (pass) ? ' ' : '*',
+    (pass) ? "passed" : "failed");
+}
+
+};
@@ -0,0 +1,78 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  Reclaimed pin stress test - GPIO9 and GPIO10 toggling under flash traffic
+
+  `testOutputGPIO9()` and `testOutputGPIO10()` check /HOLD and /WP with the
+  bus idle. This checks them at full bus use. The sigma-delta generator drives
+  GPIO9 and GPIO10 with a square wave at MHz rates, with no CPU involved, so
+  the pins keep toggling through every cache line fill and `spi_flash_read()`
+  transfer. Meanwhile the test streams a flash span both ways, 4 KB at a
+  time, and checks each block's CRC-32 against a reference taken with the
+  pins idle:
+
+    * `spi_flash_read()` into a DRAM buffer
+    * 32-bit loads through the iCache, which misses on every line once the
+      span is larger than the cache
+
+  A flash part still honoring /HOLD pauses mid-transfer and returns shifted
+  data, a CRC error. Honoring /HOLD during a code fetch is more likely a
+  crash or HWDT reset. Either way the pins are not safe to use.
+
+  Only call after `reclaim_GPIO_9_10()` succeeded. Disconnect, or use series
+  resistors on, anything attached to GPIO9 and GPIO10; they see the full
+  toggle rate. The pin setup is put back when done.
+*/
+#ifndef TESTFLASHQE_PIN_STRESS_H
+#define TESTFLASHQE_PIN_STRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct PinStressResult {
+  uint32_t elapsed_ms;
+  uint32_t span;                // Bytes of flash streamed per pass
+  uint32_t spi_blocks;          // 4 KB blocks read with spi_flash_read()
+  uint32_t spi_crc_errors;
+  uint32_t spi_read_errors;     // spi_flash_read() did not return OK
+  uint32_t spi_us;
+  uint32_t cache_blocks;        // 4 KB blocks copied through the iCache
+  uint32_t cache_crc_errors;
+  uint32_t cache_us;
+  uint32_t pins;                // Pin mask under test
+  uint32_t seen_high;           // Pins read high while toggling
+  uint32_t seen_low;            // Pins read low while toggling
+  uint8_t prescale;
+};
+
+// pins is kGpio9Mask, kGpio10Mask, or both. span is a multiple of 4 KB from
+// flash offset 0, at most 256 KB; 0 for 64 KB. A larger prescale slows the
+// toggle rate, 80 MHz / (prescale + 1) sigma-delta clock. False when the
+// arguments are bad, the pins are not reclaimed, or the idle reference reads
+// did not agree.
+bool pin_stress_run(PinStressResult *r, const uint32_t pins, const uint32_t duration_ms,
+  const size_t span, const uint8_t prescale);
+
+void pin_stress_print(const PinStressResult *r);
+
+#ifdef __cplusplus
+};
+#endif
+#endif // TESTFLASHQE_PIN_STRESS_H
@@ -0,0 +1,69 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include <Arduino.h>
+#include <spi_flash.h>    // SpiOpResult
+#include "Spi0Bench.h"
+
+extern "C" {
+
+// Insertion sort, n is small
+static void sort_samples(uint32_t *p, const size_t n) {
+  for (size_t i = 1u; i < n; i++) {
+    const uint32_t v = p[i];
+    size_t j = i;
+    for (; j && p[j - 1u] > v; j--) p[j] = p[j - 1u];
+    p[j] = v;
+  }
+}
+
+size_t spi0_bench_run(BenchFn fn, void *arg, uint32_t *samples, const size_t n, BenchStats *stats) {
+  memset(stats, 0, sizeof(BenchStats));
+  fn(arg);
+  size_t count = 0u;
+  for (size_t i = 0u; i < n; i++) {
+    const uint32_t start = esp_get_cycle_count();
+    const SpiOpResult ok0 = fn(arg);
+    const uint32_t cycles = esp_get_cycle_count() - start;
+    if (SPI_RESULT_OK == ok0) samples[count++] = cycles;
+    if (0u == (i % 16u)) yield();
+  }
+  if (count) {
+    sort_samples(samples, count);
+    stats->min = samples[0];
+    stats->median = samples[count / 2u];
+    stats->max = samples[count - 1u];
+  }
+  stats->count = count;
+  return count;
+}
+
+void spi0_bench_print_header(void) {
+  Serial.printf_P(PSTR("  %-22s %8s %8s %8s %8s %8s\r\n"),
+    "Primitive", "min", "median", "max", "med us", "samples");
+}
+
+void spi0_bench_print_row(const char *name, const BenchStats *stats, const uint32_t cpu_mhz) {
+  if (0u == stats->count) {
+    Serial.printf_P(PSTR("  %-22s failed\r\n"), name);
+    return;
+  }
+  const uint32_t mhz = (cpu_mhz) ? cpu_mhz : 80u;
+  Serial.printf_P(PSTR("  %-22s %8u %8u %8u %5u.%02u %8u\r\n"), name,
+    stats->min, stats->median, stats->max,
+    stats->median / mhz, (stats->median % mhz) * 100u / mhz, stats->count);
+}
+
+};
@@ -0,0 +1,52 @@
+/*
+ *   Copyright 2024 M Hightower
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+/*
+  SPI0 micro-benchmark harness - min, median, and max CCOUNT for one call.
+
+  The SPI0 functions in this library do all their work with the iCache off.
+  Most also mask interrupts. The call time is also how long other code,
+  including WiFi ISRs, is held off. See examples/Benchmark.
+*/
+#ifndef TESTFLASHQE_SPI0_BENCH_H
+#define TESTFLASHQE_SPI0_BENCH_H
+
+#include <spi_flash.h>    // SpiOpResult
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct BenchStats {
+  uint32_t min;                 // CCOUNT cycles
+  uint32_t median;
+  uint32_t max;
+  uint32_t count;               // Samples that returned SPI_RESULT_OK
+};
+
+typedef SpiOpResult (*BenchFn)(void *arg);
+
+// Call fn n times, after one untimed call to warm the cache. samples must
+// hold n values. Failed calls are left out of stats.
+size_t spi0_bench_run(BenchFn fn, void *arg, uint32_t *samples, const size_t n, BenchStats *stats);
+
+// One row of the summary table, cycles and us at cpu_mhz
+void spi0_bench_print_header(void);
+void spi0_bench_print_row(const char *name, const BenchStats *stats, const uint32_t cpu_mhz);
+
+#ifdef __cplusplus
+};
+#endif
+#endif // TESTFLASHQE_SPI0_BENCH_H
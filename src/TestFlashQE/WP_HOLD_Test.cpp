@@ -33,6 +33,7 @@
 #include <user_interface.h> // system_soft_wdt_feed()
 #include "BootROM_NONOS.h"
 #include <SpiFlashUtils.h>
+#include <ReclaimedPins.h>
 #include "WP_HOLD_Test.h"
 #define PRINTF(a, ...)        printf_P(PSTR(a), ##__VA_ARGS__)
 #define PRINTF_LN(a, ...)     printf_P(PSTR(a "\n"), ##__VA_ARGS__)
@@ -54,31 +55,6 @@
   match the behaviors I saw with the part.
 */
 
-// We need pinMode functionality in IRAM.  GPF is a problem it resides in
-// PROGMEM we have replaced with localGPF.
-// Partial extraction of pinMode from core_esp8266_wiring_digital.cpp -
-//   only intended to handle GPIO9 and GPIO10 with OUTPUT and SPECIAL.
-#define localGPF(p) (*_gpioToFn[(p & 0xF)])
-
-static void IRAM_ATTR pinSpecial(uint32_t pin, uint32_t mode) {
-  volatile uint32_t* const _gpioToFn[16] = { &GPF0, &GPF1, &GPF2, &GPF3, &GPF4, &GPF5, &GPF6, &GPF7, &GPF8, &GPF9, &GPF10, &GPF11, &GPF12, &GPF13, &GPF14, &GPF15 };
-  if (SPECIAL == mode) {
-    GPC(pin) = (GPC(pin) & (0xF << GPCI)); //SOURCE(GPIO) | DRIVER(NORMAL) | INT_TYPE(UNCHANGED) | WAKEUP_ENABLE(DISABLED)
-    GPEC = (1 << pin); //Disable
-    localGPF(pin) = GPFFS(GPFFS_BUS(pin));//Set mode to BUS (RX0, TX0, TX1, SPI, HSPI or CLK depending in the p     40 in)
-    if(pin == 3) {
-      localGPF(pin) |= (1 << GPFPU);//enable pullup on RX
-    }
-  } else
-  if (OUTPUT == mode) {
-    localGPF(pin) = GPFFS(GPFFS_GPIO(pin));//Set mode to GPIO  -
-    GPC(pin) = (GPC(pin) & (0xF << GPCI)); //SOURCE(GPIO) | DRIVER(NORMAL) | INT_TYPE(UNCHANGED) | WAKEUP_ENABLE(DISABLED)
-    GPES = (1 << pin); //Enable
-  } else {
-    panic();
-  }
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 // Check for shorted GPIO pins - intended for use with GPIO 9 and 10
 // Because changing the state of the /HOLD pin, may cause a HWDT resets. We need
@@ -92,13 +68,14 @@ bool IRAM_ATTR test_GPIO_pin_short(uint8_t pin) {
   Wait_SPI_Idle(flashchip);
 
   digitalWrite(pin, HIGH);
-  pinSpecial(pin, OUTPUT);  // private version of pinMode(pin, OUTPUT);  // is in ICACHE
+  // pinMode() uses the GPF table in PROGMEM, ReclaimedPins::mode() does not.
+  experimental::ReclaimedPins::mode(pin, OUTPUT);
   bool pass1 = (HIGH == digitalRead(pin));
 
   digitalWrite(pin, LOW);
   bool pass2 = (LOW == digitalRead(pin));
 
-  pinSpecial(pin, SPECIAL); // restore default function
+  experimental::ReclaimedPins::mode(pin, SPECIAL); // restore default function
   xt_wsr_ps(saved_ps);
   // Cache_Read_Enable_2();
 